@@ -102,6 +102,40 @@ VideoFrame* decodeGetOutput(DecodeHandler p)
     return NULL;
 }
 
+uint32_t decodeGetOutputs(DecodeHandler p, VideoFrame** frames, uint32_t max)
+{
+    if (!p || !frames)
+        return 0;
+    std::vector<SharedPtr<VideoFrame> > outputs;
+    uint32_t n = ((IVideoDecoder*)p)->getOutputs(max, outputs);
+    for (uint32_t i = 0; i < n; i++) {
+        SharedPtr<VideoFrame>& frame = outputs[i];
+        frame->user_data = (intptr_t) new SharedPtrHold(frame);
+        frame->free = freeHold;
+        frames[i] = frame.get();
+    }
+    return n;
+}
+
+YamiStatus decodeEnableAsyncOutput(DecodeHandler p, DecodeOutputCallback callback, void* user)
+{
+    if (p)
+        return ((IVideoDecoder*)p)->enableAsyncOutput(callback, user);
+    else
+        return YAMI_FAIL;
+}
+
+int decodeGetOutputEventFd(DecodeHandler p)
+{
+    return (p ? ((IVideoDecoder*)p)->getOutputEventFd() : -1);
+}
+
+void decodeSetSurfaceWaitTimeout(DecodeHandler p, uint32_t timeoutMs)
+{
+    if (p)
+        ((IVideoDecoder*)p)->setSurfaceWaitTimeout(timeoutMs);
+}
+
 const VideoFormatInfo* decodeGetFormatInfo(DecodeHandler p)
 {
     return (p ? ((IVideoDecoder*)p)->getFormatInfo() : NULL);
@@ -8,12 +8,14 @@ LOCAL_SRC_FILES := \
         h264Parser.cpp \
         h265Parser.cpp \
         jpegParser.cpp \
+        jpegDecoder.cpp \
         mpeg2_parser.cpp \
         nalReader.cpp \
         vc1Parser.cpp \
         vp8_bool_decoder.cpp \
         vp8_parser.cpp \
         vp9parser.cpp \
+        vp9SuperFrame.cpp \
         vp9quant.c \
         dboolhuff.c \
 
@@ -19,21 +19,23 @@
 #endif
 
 #include <assert.h>
+#include <string.h>
 #include "bitReader.h"
 
-#define LOAD8BYTESDATA_BE(x) \
-    (((uint64_t)((const uint8_t*)(x))[0] << 56) | \
-     ((uint64_t)((const uint8_t*)(x))[1] << 48) | \
-     ((uint64_t)((const uint8_t*)(x))[2] << 40) | \
-     ((uint64_t)((const uint8_t*)(x))[3] << 32) | \
-     ((uint64_t)((const uint8_t*)(x))[4] << 24) | \
-     ((uint64_t)((const uint8_t*)(x))[5] << 16) | \
-     ((uint64_t)((const uint8_t*)(x))[6] <<  8) | \
-     ((uint64_t)((const uint8_t*)(x))[7]))
-
 namespace YamiParser {
 
-const uint32_t BitReader::CACHEBYTES = sizeof(unsigned long int);
+const uint32_t BitReader::CACHEBYTES = sizeof(uint64_t);
+const uint32_t BitReader::MAX_READ_BITS = ((BitReader::CACHEBYTES - 1) << 3) + 1;
+
+static inline uint64_t load8BytesDataBE(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
 
 BitReader::BitReader(const uint8_t* pdata, uint32_t size)
     : m_stream(pdata)
@@ -47,60 +49,78 @@ BitReader::BitReader(const uint8_t* pdata, uint32_t size)
         assert(pdata);
 }
 
-void BitReader::loadDataToCache(uint32_t nbytes)
+void BitReader::loadDataToCache(uint32_t nbytes) const
 {
-    unsigned long int tmp = 0;
+    assert(nbytes && (nbytes << 3) + m_bitsInCache <= (CACHEBYTES << 3));
     const uint8_t* pStart = m_stream + m_loadBytes;
-
-    if (nbytes == 8)
-        tmp = LOAD8BYTESDATA_BE(pStart);
-    else {
-        for (uint32_t i = 0; i < nbytes; i++) {
-            tmp <<= 8;
-            tmp |= pStart[i];
-        }
+    uint64_t tmp = 0;
+
+    if (m_size - m_loadBytes >= CACHEBYTES) {
+        tmp = load8BytesDataBE(pStart);
+        tmp &= ~(uint64_t)0 << ((CACHEBYTES - nbytes) << 3);
+    } else {
+        for (uint32_t i = 0; i < nbytes; i++)
+            tmp |= (uint64_t)pStart[i] << ((CACHEBYTES - 1 - i) << 3);
     }
 
-    m_cache = tmp;
+    m_cache |= tmp >> m_bitsInCache;
     m_loadBytes += nbytes;
-    m_bitsInCache = nbytes << 3;
+    m_bitsInCache += nbytes << 3;
 }
 
-inline void BitReader::reload()
+void BitReader::reload() const
 {
     assert(m_size >= m_loadBytes);
     uint32_t remainingBytes = m_size - m_loadBytes;
-    if (remainingBytes > 0)
-        loadDataToCache(std::min(remainingBytes, CACHEBYTES));
+    uint32_t nbytes = ((CACHEBYTES << 3) - m_bitsInCache) >> 3;
+    if (remainingBytes > 0 && nbytes > 0)
+        loadDataToCache(std::min(remainingBytes, nbytes));
 }
 
-inline uint32_t BitReader::extractBitsFromCache(uint32_t nbits)
+inline uint64_t BitReader::extractBitsFromCache(uint32_t nbits)
 {
+    assert(nbits <= MAX_READ_BITS && nbits <= m_bitsInCache);
     if (!nbits)
         return 0;
-    uint32_t tmp = 0;
-    tmp = m_cache << ((CACHEBYTES << 3) - m_bitsInCache) >> ((CACHEBYTES << 3) - nbits);
+    uint64_t tmp = m_cache >> ((CACHEBYTES << 3) - nbits);
+    m_cache <<= nbits;
     m_bitsInCache -= nbits;
     m_pos += nbits;
     return tmp;
 }
 
-bool BitReader::read(uint32_t& v, uint32_t nbits)
+bool BitReader::read(uint64_t& v, uint32_t nbits)
 {
     assert(nbits <= (CACHEBYTES << 3));
 
-    if (nbits <= m_bitsInCache) {
-        v = extractBitsFromCache(nbits);
+    if (nbits > MAX_READ_BITS) {
+        uint64_t high, low;
+        const uint32_t lowBits = 32;
+        if (!read(high, nbits - lowBits) || !read(low, lowBits))
+            return false;
+        v = high << lowBits | low;
         return true;
     }
-    /*not enough bits, need to save remaining bits
-      in current cache and then reload more bits*/
-    uint32_t toBeReadBits = nbits - m_bitsInCache;
-    uint32_t tmp = extractBitsFromCache(m_bitsInCache);
-    reload();
-    if (toBeReadBits > m_bitsInCache)
+    if (nbits > m_bitsInCache) {
+        reload();
+        if (nbits > m_bitsInCache) {
+            /*not enough data, eat all of it*/
+            m_pos += m_bitsInCache;
+            m_cache = 0;
+            m_bitsInCache = 0;
+            return false;
+        }
+    }
+    v = extractBitsFromCache(nbits);
+    return true;
+}
+
+bool BitReader::read(uint32_t& v, uint32_t nbits)
+{
+    uint64_t tmp;
+    if (!read(tmp, nbits))
         return false;
-    v = tmp << toBeReadBits | extractBitsFromCache(toBeReadBits);
+    v = tmp;
     return true;
 }
 
@@ -114,23 +134,35 @@ uint32_t BitReader::read(uint32_t nbits)
 
 bool BitReader::skip(uint32_t nbits)
 {
-    uint32_t tmp;
-    uint32_t size = sizeof(tmp) << 3;
-    while (nbits > size) {
-        if (!readT(tmp))
+    uint64_t tmp;
+    while (nbits > MAX_READ_BITS) {
+        if (!read(tmp, MAX_READ_BITS))
             return false;
-        nbits -= size;
+        nbits -= MAX_READ_BITS;
     }
     if (!read(tmp, nbits))
         return false;
     return true;
 }
 
-uint32_t BitReader::peek(uint32_t nbits) const
+bool BitReader::peekBits(uint64_t& v, uint32_t nbits) const
 {
-    BitReader tmp(*this);
+    assert(nbits <= MAX_READ_BITS);
+    if (nbits > m_bitsInCache) {
+        reload();
+        if (nbits > m_bitsInCache)
+            return false;
+    }
+    v = nbits ? m_cache >> ((CACHEBYTES << 3) - nbits) : 0;
+    return true;
+}
 
-    return tmp.read(nbits);
+uint32_t BitReader::peek(uint32_t nbits) const
+{
+    uint64_t tmp;
+    if (!peekBits(tmp, nbits))
+        return 0;
+    return tmp;
 }
 
 } /*namespace YamiParser*/
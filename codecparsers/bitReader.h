@@ -25,12 +25,16 @@ namespace YamiParser {
 class BitReader {
 public:
     static const uint32_t CACHEBYTES;
+    /* the cache is refilled to at least this many bits, so one read or peek can get them at once */
+    static const uint32_t MAX_READ_BITS;
     BitReader(const uint8_t* data, uint32_t size);
     virtual ~BitReader() {}
 
-    /* Read specified bits(<= 8*sizeof(uint32_t)) as a uint32_t to v */
+    /* Read specified bits(<= 8*CACHEBYTES) as a uint32_t to v, only the lower 32 bits are kept */
     /* if not enough data, it will return false, eat all data and keep v untouched */
     bool read(uint32_t& v, uint32_t nbits);
+    /* Read specified bits(<= 8*CACHEBYTES) as a uint64_t to v */
+    bool read(uint64_t& v, uint32_t nbits);
     /* Read specified bits(<= 8*sizeof(uint32_t)) as a uint32_t return value */
     /* will return 0 if not enough data*/
     uint32_t read(uint32_t nbits);
@@ -44,7 +48,7 @@ public:
 
     inline bool readT(bool& v);
 
-    /*read the next nbits bits from the bitstream but not advance the bitstream pointer*/
+    /*read the next nbits(<= MAX_READ_BITS) bits from the bitstream but not advance the bitstream pointer*/
     uint32_t peek(uint32_t nbits) const;
 
     /* this version will check read beyond boundary */
@@ -71,17 +75,23 @@ public:
     }
 
 protected:
-    virtual void loadDataToCache(uint32_t nbytes);
+    /* append the next nbytes(>= 1) bytes of data to the cache,
+     * there is room for them and at least nbytes bytes are left in source data */
+    virtual void loadDataToCache(uint32_t nbytes) const;
+    /* top up the cache to at least MAX_READ_BITS bits, or as many as left */
+    void reload() const;
+    bool peekBits(uint64_t& v, uint32_t nbits) const;
 
     const uint8_t* m_stream; /*a pointer to source data*/
     uint32_t m_size; /*the size of source data in bytes*/
-    unsigned long int m_cache; /*the buffer which load less than or equal to 8 bytes*/
-    uint32_t m_loadBytes; /*the total bytes of data read from source data*/
-    uint32_t m_bitsInCache; /*the remaining bits in cache*/
+    /* refilling the cache does not change what the reader will return,
+     * so peek() and other const members may do it */
+    mutable uint64_t m_cache; /*the next bits of data, msb first, unused low bits are zero*/
+    mutable uint32_t m_loadBytes; /*the total bytes of data read from source data*/
+    mutable uint32_t m_bitsInCache; /*the remaining bits in cache*/
     uint64_t m_pos; /*current pos, for NalReader, it already removed emulation prevent byte*/
 private:
-    inline uint32_t extractBitsFromCache(uint32_t nbits);
-    inline void reload();
+    inline uint64_t extractBitsFromCache(uint32_t nbits);
 };
 
 template <class T>
@@ -108,8 +118,11 @@ bool BitReader::readT(bool& v)
 template <class T>
 bool BitReader::peek(T& v, uint32_t nbits) const
 {
-    BitReader tmp(*this);
-    return tmp.readT(v, nbits);
+    uint64_t tmp;
+    if (!peekBits(tmp, nbits))
+        return false;
+    v = tmp;
+    return true;
 }
 
 } /*namespace YamiParser*/
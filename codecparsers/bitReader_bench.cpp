@@ -0,0 +1,124 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bitReader.h"
+
+#include "common/benchmark.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+using YamiParser::BitReader;
+
+//BitReader throughput with the read patterns of the parsers built on it.
+//usage: bitReader_bench [-n loops]
+//for whole streams, "yamiparse -q -n <loops> <file>" times the real parsers.
+
+static const int DEFAULT_LOOPS = 2000;
+static const uint32_t DATA_SIZE = 64 * 1024;
+
+//vp9 uncompressed header: mostly flags and short literals
+static uint64_t vp9Like(BitReader& br)
+{
+    static const uint32_t widths[] = { 2, 1, 1, 1, 1, 1, 16, 16, 1, 3, 1, 6, 3, 1, 8, 1, 4, 1, 1, 6 };
+    uint64_t sum = 0;
+    for (;;) {
+        for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+            uint32_t v;
+            if (!br.read(v, widths[i]))
+                return sum;
+            sum += v;
+        }
+    }
+}
+
+//mpeg2 headers: start code check, then wide fixed fields
+static uint64_t mpeg2Like(BitReader& br)
+{
+    static const uint32_t widths[] = { 12, 12, 4, 4, 18, 1, 10, 1, 1, 10, 3, 16, 1, 1, 4 };
+    uint64_t sum = 0;
+    for (;;) {
+        sum += br.peek(32);
+        if (!br.skip(32))
+            return sum;
+        for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+            uint32_t v;
+            if (!br.read(v, widths[i]))
+                return sum;
+            sum += v;
+        }
+    }
+}
+
+//jpeg huffman decode: peek a code, skip its length, read the extra bits
+static uint64_t jpegLike(BitReader& br)
+{
+    uint64_t sum = 0;
+    for (;;) {
+        uint32_t code = br.peek(16);
+        uint32_t length = (code >> 12) + 2;
+        uint32_t extra = code & 0xb;
+        uint32_t v;
+        if (!br.skip(length) || !br.read(v, extra))
+            return sum;
+        sum += code + v;
+    }
+}
+
+typedef uint64_t (*Pattern)(BitReader& br);
+
+static void run(const char* name, Pattern pattern, const std::vector<uint8_t>& data, int loops)
+{
+    uint64_t sum = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++) {
+        BitReader br(&data[0], data.size());
+        sum += pattern(br);
+    }
+    t = benchNow() - t;
+    printf("%-6s %8.1f MB/s (checksum %llx)\n", name,
+        (double)data.size() * loops / t / (1024 * 1024), (unsigned long long)sum);
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n loops]\n", argv[0]);
+            return -1;
+        }
+        loops = atoi(optarg);
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+
+    std::vector<uint8_t> data(DATA_SIZE);
+    srand(1);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = rand();
+
+    run("vp9", vp9Like, data, loops);
+    run("mpeg2", mpeg2Like, data, loops);
+    run("jpeg", jpegLike, data, loops);
+    return 0;
+}
@@ -96,4 +96,40 @@ BITREADER_TEST(NullInit)
     EXPECT_DEATH(BitReader r3(NULL, 1), "");
 }
 
+BITREADER_TEST(ReadAndPeekWideBits)
+{
+    const uint8_t data[] = {
+        0x12, 0x34, 0x56, 0x78,
+        0x9a, 0xbc, 0xde, 0xf0,
+        0x0f, 0xed, 0xcb
+    };
+    BitReader reader(data, sizeof(data));
+    uint64_t v;
+
+    EXPECT_EQ(0x0u, reader.peek(3));
+    EXPECT_EQ(0x1234u, reader.peek(16));
+    EXPECT_EQ(0u, reader.getPos());
+
+    EXPECT_TRUE(reader.read(v, 4));
+    EXPECT_EQ(0x1u, v);
+    //a full refill from a non byte-aligned position
+    EXPECT_TRUE(reader.peek(v, BitReader::MAX_READ_BITS));
+    EXPECT_EQ(UINT64_C(0x468acf13579bde), v);
+    EXPECT_TRUE(reader.read(v, BitReader::MAX_READ_BITS));
+    EXPECT_EQ(UINT64_C(0x468acf13579bde), v);
+    EXPECT_EQ(61u, reader.getPos());
+
+    EXPECT_TRUE(reader.read(v, 19));
+    EXPECT_EQ(0xfedu, v);
+    EXPECT_EQ(0xcu, reader.peek(4));
+    EXPECT_EQ(0xcbu, reader.peek(8));
+    EXPECT_EQ(0u, reader.peek(9));
+    EXPECT_FALSE(reader.peek(v, 9));
+    EXPECT_FALSE(reader.end());
+
+    EXPECT_FALSE(reader.read(v, 9));
+    EXPECT_TRUE(reader.end());
+    EXPECT_EQ(88u, reader.getPos());
+}
+
 } // namespace YamiParser
@@ -21,35 +21,125 @@
 #include "bitWriter.h"
 #include "common/log.h"
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 namespace YamiParser {
 
-const uint32_t CACHEBYTES = sizeof(unsigned long int);
-const uint32_t CACHEBITS = sizeof(unsigned long int) * 8;
-
-// clip to keep lowest n bits
-#define CLIPBITS(value, n) ((value) & ((1 << (n)) - 1));
-
 BitWriter::BitWriter(uint32_t size)
-    : m_cache(0)
+    : m_bs(NULL)
+    , m_data(NULL)
+    , m_size(0)
+    , m_capacity(0)
+    , m_external(false)
+    , m_cache(0)
+    , m_bitsInCache(0)
+    , m_emulationPrevention(false)
+    , m_zeros(0)
+{
+    if (size)
+        m_bs = static_cast<uint8_t*>(malloc(size));
+    if (m_bs) {
+        m_data = m_bs;
+        m_capacity = size;
+    }
+}
+
+BitWriter::BitWriter(uint8_t* buffer, uint32_t size)
+    : m_bs(NULL)
+    , m_data(buffer)
+    , m_size(0)
+    , m_capacity(size)
+    , m_external(true)
+    , m_cache(0)
     , m_bitsInCache(0)
+    , m_emulationPrevention(false)
+    , m_zeros(0)
 {
-    m_bs.reserve(size);
+}
+
+BitWriter::~BitWriter()
+{
+    free(m_bs);
+}
+
+void BitWriter::reset()
+{
+    m_size = 0;
+    m_cache = 0;
+    m_bitsInCache = 0;
+    m_emulationPrevention = false;
+    m_zeros = 0;
 }
 
 uint8_t* BitWriter::getBitWriterData()
 {
-    uint8_t* buf;
-    flushCache();
+    if (!flushCache())
+        return NULL;
+    return m_size ? m_data : NULL;
+}
+
+bool BitWriter::reserve(uint32_t bytes)
+{
+    if (m_size + bytes <= m_capacity)
+        return true;
+    if (m_external)
+        return false;
+    uint32_t capacity = std::max(m_capacity * 2, m_size + bytes);
+    uint8_t* bs = static_cast<uint8_t*>(realloc(m_bs, capacity));
+    if (!bs)
+        return false;
+    m_bs = m_data = bs;
+    m_capacity = capacity;
+    return true;
+}
 
-    buf = m_bs.size() ? static_cast<uint8_t*>(&m_bs[0]) : NULL;
-    return buf;
+void BitWriter::putByte(uint8_t byte)
+{
+    if (m_emulationPrevention) {
+        /* 0x000000/0x000001/0x000002/0x000003 need 0x03 after the zeros */
+        if (m_zeros >= 2 && byte <= 3) {
+            m_data[m_size++] = 3;
+            m_zeros = 0;
+        }
+        m_zeros = byte ? 0 : m_zeros + 1;
+    }
+    m_data[m_size++] = byte;
 }
 
-void BitWriter::flushCache()
+bool BitWriter::flushBytes()
 {
-    uint8_t tmp, i, bytesInCache;
+    uint32_t bytes = m_bitsInCache >> 3;
+    if (!bytes)
+        return true;
+    if (m_emulationPrevention) {
+        //one emulation prevention byte at most for every two bytes
+        if (!reserve(bytes + (bytes + 1) / 2))
+            return false;
+    }
+    else if (!reserve(sizeof(m_cache)) && !reserve(bytes)) {
+        return false;
+    }
+    uint32_t left = m_bitsInCache & 7;
+    if (!m_emulationPrevention && m_size + sizeof(m_cache) <= m_capacity) {
+        //store the whole cache, msb first, only the whole bytes are kept
+        uint64_t v = m_cache << (CACHEBITS - m_bitsInCache);
+        for (uint32_t i = 0; i < sizeof(v); i++)
+            m_data[m_size + i] = static_cast<uint8_t>(v >> (CACHEBITS - 8 - i * 8));
+        m_size += bytes;
+    }
+    else {
+        for (uint32_t i = 0; i < bytes; i++)
+            putByte(static_cast<uint8_t>(m_cache >> (m_bitsInCache - (i + 1) * 8)));
+    }
+    m_bitsInCache = left;
+    m_cache &= ((uint64_t)1 << left) - 1;
+    return true;
+}
 
+bool BitWriter::flushCache()
+{
     // make sure m_bitsInCache is byte aligned, else trailing bits should be
     // padded
     if (m_bitsInCache % 8)
@@ -57,57 +147,99 @@ void BitWriter::flushCache()
 
     assert(!(m_bitsInCache % 8));
 
-    bytesInCache = m_bitsInCache / 8;
-
-    for (i = 0; i < bytesInCache; i++) {
-        tmp = static_cast<uint8_t>(m_cache >> (m_bitsInCache - (i + 1) * 8));
-        m_bs.push_back(tmp);
-    }
-
-    m_cache = 0;
-    m_bitsInCache = 0;
+    return flushBytes();
 }
 
-bool BitWriter::writeBits(uint32_t value, uint32_t numBits)
+bool BitWriter::writeBitsSlow(uint32_t value, uint32_t numBits)
 {
-    if (value >= (uint64_t)1 << numBits) {
+    ASSERT(numBits <= 32);
+
+    uint64_t v = value;
+    if (v >= (uint64_t)1 << numBits) {
         WARNING("Write Bits: value overflow");
+        v &= ((uint64_t)1 << numBits) - 1;
     }
 
-    ASSERT((m_bitsInCache <= CACHEBITS) && (numBits <= CACHEBITS));
+    if (m_bitsInCache + numBits > CACHEBITS && !flushBytes())
+        return false;
 
-    uint32_t bitLeft = CACHEBITS - m_bitsInCache;
+    m_cache = (m_cache << numBits) | v;
+    m_bitsInCache += numBits;
+    //keep the coded bits count exact
+    if (m_emulationPrevention && !flushBytes())
+        return false;
+    return true;
+}
 
-    if (bitLeft > numBits) {
-        m_cache = (m_cache << numBits | value);
-        m_bitsInCache += numBits;
-    } else {
-        m_cache = ((m_cache << bitLeft) | (value >> (numBits - bitLeft)));
-        m_bitsInCache = CACHEBITS;
-        flushCache();
-        m_cache = value;
-        m_bitsInCache = numBits - bitLeft;
-    }
+bool BitWriter::writeUe(uint32_t value)
+{
+    uint64_t code = (uint64_t)value + 1;
+    uint32_t length = CACHEBITS - __builtin_clzll(code);
+    if (length <= 16)
+        return writeBits(static_cast<uint32_t>(code), length * 2 - 1);
+    return writeBits(0, length - 1)
+        && writeBits(static_cast<uint32_t>(code >> 16), length - 16)
+        && writeBits(static_cast<uint32_t>(code & 0xffff), 16);
+}
 
-    return true;
+bool BitWriter::writeSe(int32_t value)
+{
+    uint32_t v = static_cast<uint32_t>(value);
+    return writeUe(value <= 0 ? -v * 2 : v * 2 - 1);
 }
 
-bool BitWriter::writeBytes(uint8_t* data, uint32_t numBytes)
+bool BitWriter::writeBytes(const uint8_t* data, uint32_t numBytes)
 {
     if (!data || !numBytes)
         return false;
 
     if ((m_bitsInCache % 8) == 0) {
-        flushCache();
-        m_bs.insert(m_bs.end(), data, data + numBytes);
+        if (!flushCache())
+            return false;
+        if (m_emulationPrevention) {
+            if (!reserve(numBytes + (numBytes + 1) / 2))
+                return false;
+            for (uint32_t i = 0; i < numBytes; i++)
+                putByte(data[i]);
+        }
+        else {
+            if (!reserve(numBytes))
+                return false;
+            memcpy(m_data + m_size, data, numBytes);
+            m_size += numBytes;
+        }
     } else {
-        for (uint32_t i = 0; i < numBytes; i++)
-            writeBits(data[i], 8);
+        for (uint32_t i = 0; i < numBytes; i++) {
+            if (!writeBits(data[i], 8))
+                return false;
+        }
     }
 
     return true;
 }
 
+bool BitWriter::writeBitstream(const uint8_t* data, uint64_t numBits)
+{
+    uint64_t bytes = numBits >> 3;
+    uint64_t i = 0;
+    if (!(m_bitsInCache % 8)) {
+        if (bytes && !writeBytes(data, bytes))
+            return false;
+        i = bytes;
+    }
+    for (; i + 4 <= bytes; i += 4) {
+        uint32_t v = (data[i] << 24) | (data[i + 1] << 16) | (data[i + 2] << 8) | data[i + 3];
+        if (!writeBits(v, 32))
+            return false;
+    }
+    for (; i < bytes; i++) {
+        if (!writeBits(data[i], 8))
+            return false;
+    }
+    uint32_t left = numBits & 7;
+    return !left || writeBits(data[bytes] >> (8 - left), left);
+}
+
 void BitWriter::writeToBytesAligned(bool bit)
 {
     uint8_t padBits = m_bitsInCache & 0x7;
@@ -121,4 +253,13 @@ void BitWriter::writeToBytesAligned(bool bit)
     }
 }
 
+void BitWriter::setEmulationPrevention(bool enable)
+{
+    if (m_bitsInCache % 8)
+        WARNING("emulation prevention changed in the middle of a byte");
+    flushBytes();
+    m_emulationPrevention = enable;
+    m_zeros = 0;
+}
+
 } /*namespace YamiParser*/
@@ -17,8 +17,8 @@
 #ifndef bitWriter_h
 #define bitWriter_h
 
+#include "common/NonCopyable.h"
 #include <stdint.h>
-#include <vector>
 
 namespace YamiParser {
 
@@ -31,37 +31,87 @@ public:
        */
     BitWriter(uint32_t size = BIT_WRITER_DEFAULT_BUFFER_SIZE);
 
-    /* Write a value with numBits into bitstream */
-    bool writeBits(uint32_t value, uint32_t numBits);
+    /* write into the caller's buffer of size bytes, it is never reallocated,
+     * writes that don't fit in it fail */
+    BitWriter(uint8_t* buffer, uint32_t size);
+
+    ~BitWriter();
+
+    /* drop everything written and start over, the buffer is kept */
+    void reset();
+
+    /* Write a value with numBits(<= 32) into bitstream */
+    inline bool writeBits(uint32_t value, uint32_t numBits);
+
+    /* Write ue(v)/se(v) Exp-Golomb codes */
+    bool writeUe(uint32_t value);
+    bool writeSe(int32_t value);
 
     /* Write an array with numBytes into bitstream */
-    bool writeBytes(uint8_t* data, uint32_t numBytes);
+    bool writeBytes(const uint8_t* data, uint32_t numBytes);
+
+    /* Write the first numBits bits of data, msb first, at any bit position */
+    bool writeBitstream(const uint8_t* data, uint64_t numBits);
 
     /* Pad some zeros to make sure bitsteam byte aligned */
     void writeToBytesAligned(bool bit = false);
 
-    /* get encoded bitstream buffer */
+    /* insert emulation prevention bytes into everything written after this
+     * call, so the output is a NAL unit rather than an RBSP.
+     * The writer should be byte aligned */
+    void setEmulationPrevention(bool enable);
+
+    /* get encoded bitstream buffer, NULL if nothing was written or
+     * the caller's buffer is too small */
     uint8_t* getBitWriterData();
 
     /* get encoded bits count
      * it is recommended to call getCodedBitsCount prior to getBitWriterData,
      * because getBitWriterData may pad some bits to make sure byte aligned,
      * then the padded bits will be caculated as coded bits.
+     * Emulation prevention bytes are counted as they are written.
      * */
     uint64_t getCodedBitsCount() const
     {
-        return static_cast<uint64_t>(m_bs.size() * 8) + m_bitsInCache;
+        return static_cast<uint64_t>(m_size) * 8 + m_bitsInCache;
     }
 
 protected:
-    void flushCache();
+    static const uint32_t CACHEBITS = 64;
+
+    bool writeBitsSlow(uint32_t value, uint32_t numBits);
+    bool flushCache();
+    /* move the whole bytes of the cache to the buffer */
+    bool flushBytes();
+    bool reserve(uint32_t bytes);
+    void putByte(uint8_t byte);
 
-    std::vector<uint8_t> m_bs; /* encoded bitstream buffer */
+    uint8_t* m_bs; /* owned bitstream buffer, malloc()ed so it isn't zero filled */
+    uint8_t* m_data; /* encoded bitstream, m_bs or the caller's buffer */
+    uint32_t m_size; /* bytes in m_data */
+    uint32_t m_capacity; /* m_data size */
+    bool m_external; /* m_data is the caller's buffer */
 
-    long int m_cache; /* a 32 or 64 bits cache buffer */
+    uint64_t m_cache; /* bits not yet in m_data, lsb aligned */
     uint32_t m_bitsInCache; /* used bits in cache*/
+
+    bool m_emulationPrevention;
+    uint32_t m_zeros; /* zero bytes at the end of m_data */
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(BitWriter);
 };
 
+bool BitWriter::writeBits(uint32_t value, uint32_t numBits)
+{
+    if ((static_cast<uint64_t>(value) >> numBits) || m_bitsInCache + numBits > CACHEBITS
+        || m_emulationPrevention)
+        return writeBitsSlow(value, numBits);
+    m_cache = (m_cache << numBits) | value;
+    m_bitsInCache += numBits;
+    return true;
+}
+
 } /*namespace YamiParser*/
 
 #endif
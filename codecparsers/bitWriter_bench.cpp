@@ -0,0 +1,156 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bitWriter.h"
+
+#include "common/benchmark.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+using YamiParser::BitWriter;
+
+//packed header generation the way the h264 and hevc encoders do it.
+//usage: bitWriter_bench [-n loops]
+
+static const int DEFAULT_LOOPS = 1000000;
+
+//a p slice header: start code, nal header, three reordering commands,
+//qp and deblocking syntax
+static void writeSliceHeader(BitWriter& bw, uint32_t frame)
+{
+    bw.writeBits(1, 32);
+    bw.writeBits(0, 1);
+    bw.writeBits(2, 2);
+    bw.writeBits(1, 5);
+    bw.writeUe(frame * 10 % 8160); //first_mb_in_slice
+    bw.writeUe(0); //slice_type
+    bw.writeUe(0); //pic_parameter_set_id
+    bw.writeBits(frame & 0xff, 8); //frame_num
+    bw.writeBits((frame * 2) & 0xff, 8); //pic_order_cnt_lsb
+    bw.writeBits(1, 1); //num_ref_idx_active_override_flag
+    bw.writeUe(2);
+    bw.writeBits(1, 1); //ref_pic_list_modification_flag_l0
+    for (uint32_t i = 0; i < 3; i++) {
+        bw.writeUe(0);
+        bw.writeUe(i);
+    }
+    bw.writeUe(3);
+    bw.writeBits(0, 1); //adaptive_ref_pic_marking_mode_flag
+    bw.writeUe(0); //cabac_init_idc
+    bw.writeSe((int32_t)(frame % 7) - 3); //slice_qp_delta
+    bw.writeUe(0); //disable_deblocking_filter_idc
+    bw.writeSe(2);
+    bw.writeSe(2);
+    bw.writeToBytesAligned(true);
+}
+
+//what a sps with vui looks like to the writer: mostly flags and ue(v)
+static void writeSequenceHeader(BitWriter& bw, uint32_t frame)
+{
+    bw.writeBits(100, 8); //profile_idc
+    bw.writeBits(0, 8);
+    bw.writeBits(40, 8); //level_idc
+    bw.writeUe(0);
+    bw.writeUe(1); //chroma_format_idc
+    bw.writeUe(0);
+    bw.writeUe(0);
+    bw.writeBits(0, 2);
+    bw.writeUe(4); //log2_max_frame_num_minus4
+    bw.writeUe(0);
+    bw.writeUe(4);
+    bw.writeUe(4); //max_num_ref_frames
+    bw.writeBits(0, 1);
+    bw.writeUe(119); //pic_width_in_mbs_minus1
+    bw.writeUe(67); //pic_height_in_map_units_minus1
+    bw.writeBits(7, 3);
+    bw.writeBits(1, 1); //frame_cropping_flag
+    bw.writeUe(0);
+    bw.writeUe(0);
+    bw.writeUe(0);
+    bw.writeUe(4);
+    bw.writeBits(1, 1); //vui_parameters_present_flag
+    bw.writeBits(0, 4);
+    bw.writeBits(1, 1); //timing_info_present_flag
+    bw.writeBits(1, 32);
+    bw.writeBits(60 + (frame & 1), 32);
+    bw.writeBits(1, 1);
+    bw.writeBits(0, 5);
+    bw.writeBits(1, 1); //rbsp_stop_one_bit
+    bw.writeToBytesAligned();
+}
+
+typedef void (*Header)(BitWriter& bw, uint32_t frame);
+
+//one writer per header with the default 4 KB buffer, as sps/pps writers do
+static uint32_t writeOwned(Header header, uint32_t frame, bool annexB)
+{
+    BitWriter bw;
+    bw.setEmulationPrevention(annexB);
+    header(bw, frame);
+    uint32_t bits = bw.getCodedBitsCount();
+    return bw.getBitWriterData() ? bits : 0;
+}
+
+//a stack buffer per header, as the slice header writer does
+static uint32_t writeExternal(Header header, uint32_t frame, bool annexB)
+{
+    uint8_t buffer[256];
+    BitWriter bw(buffer, sizeof(buffer));
+    bw.setEmulationPrevention(annexB);
+    header(bw, frame);
+    uint32_t bits = bw.getCodedBitsCount();
+    return bw.getBitWriterData() ? bits : 0;
+}
+
+typedef uint32_t (*Writer)(Header header, uint32_t frame, bool annexB);
+
+static void run(const char* name, Writer writer, Header header, bool annexB, int loops)
+{
+    uint64_t bits = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++)
+        bits += writer(header, i, annexB);
+    t = benchNow() - t;
+    printf("%-24s %6.1f ns/header %8.1f MB/s\n", name, t * 1e9 / loops,
+        bits / 8 / t / (1024 * 1024));
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n loops]\n", argv[0]);
+            return -1;
+        }
+        loops = atoi(optarg);
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+
+    run("slice, owned buffer", writeOwned, writeSliceHeader, false, loops);
+    run("slice, stack buffer", writeExternal, writeSliceHeader, false, loops);
+    run("sps, owned buffer", writeOwned, writeSequenceHeader, false, loops);
+    run("sps, annex b", writeOwned, writeSequenceHeader, true, loops);
+    return 0;
+}
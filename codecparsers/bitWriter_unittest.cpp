@@ -22,8 +22,13 @@
 #include "bitWriter.h"
 
 // library headers
+#include "bitReader.h"
+#include "common/common_def.h"
 #include "common/unittest.h"
 
+// system headers
+#include <vector>
+
 namespace YamiParser {
 
 static const uint16_t writeArrary[16][2] = {
@@ -33,6 +38,16 @@ static const uint16_t writeArrary[16][2] = {
     { 13, 4 }, { 14, 4 }, { 15, 4 }, { 16, 5 }
 };
 
+static uint64_t readUe(BitReader& reader)
+{
+    uint32_t zeros = 0;
+    while (!reader.read(1))
+        zeros++;
+    uint64_t v = 0;
+    reader.read(v, zeros);
+    return ((uint64_t)1 << zeros) + v - 1;
+}
+
 class BitWriterTest
     : public ::testing::Test {
 };
@@ -57,4 +72,126 @@ BITWriter_TEST(Writer_Simple)
     EXPECT_EQ(bitsSum, Writer.getCodedBitsCount());
 }
 
+BITWriter_TEST(Writer_LongStream)
+{
+    //crosses many cache flushes and the initial buffer size
+    BitWriter writer(16);
+    for (uint32_t i = 0; i < 1000; i++)
+        EXPECT_TRUE(writer.writeBits(i, (i % 32) + 1 > 10 ? (i % 32) + 1 : 10));
+    uint64_t bits = writer.getCodedBitsCount();
+    uint8_t* data = writer.getBitWriterData();
+    ASSERT_TRUE(data);
+
+    BitReader reader(data, (bits + 7) / 8);
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t n = (i % 32) + 1 > 10 ? (i % 32) + 1 : 10;
+        uint32_t v;
+        ASSERT_TRUE(reader.read(v, n));
+        EXPECT_EQ(n == 32 ? i : i & ((1u << n) - 1), v);
+    }
+}
+
+BITWriter_TEST(Writer_ExpGolomb)
+{
+    const uint32_t ue[] = { 0, 1, 2, 3, 7, 254, 255, 65534, 65535, 0x12345678, 0xfffffffe, 0xffffffff };
+    const int32_t se[] = { 0, 1, -1, 2, -2, 1000, -1000, 32767, -32768 };
+    BitWriter writer;
+    for (size_t i = 0; i < N_ELEMENTS(ue); i++)
+        EXPECT_TRUE(writer.writeUe(ue[i]));
+    for (size_t i = 0; i < N_ELEMENTS(se); i++)
+        EXPECT_TRUE(writer.writeSe(se[i]));
+    uint64_t bits = writer.getCodedBitsCount();
+    uint8_t* data = writer.getBitWriterData();
+    ASSERT_TRUE(data);
+
+    BitReader reader(data, (bits + 7) / 8);
+    for (size_t i = 0; i < N_ELEMENTS(ue); i++)
+        EXPECT_EQ(ue[i], readUe(reader));
+    for (size_t i = 0; i < N_ELEMENTS(se); i++) {
+        uint64_t v = readUe(reader);
+        EXPECT_EQ(se[i], v & 1 ? (int32_t)((v + 1) / 2) : -(int32_t)(v / 2));
+    }
+    EXPECT_EQ(bits, reader.getPos());
+
+    //ue(0) is 1, ue(3) is 00100
+    BitWriter small;
+    small.writeUe(0);
+    small.writeUe(3);
+    EXPECT_EQ(6u, small.getCodedBitsCount());
+    EXPECT_EQ(0x90, small.getBitWriterData()[0]);
+}
+
+BITWriter_TEST(Writer_ExternalBuffer)
+{
+    uint8_t buffer[4];
+    BitWriter writer(buffer, sizeof(buffer));
+    EXPECT_TRUE(writer.writeBits(0x12345678, 32));
+    EXPECT_EQ(buffer, writer.getBitWriterData());
+    EXPECT_EQ(0x12, buffer[0]);
+    EXPECT_EQ(0x78, buffer[3]);
+
+    //no room for more
+    EXPECT_TRUE(writer.writeBits(1, 8));
+    EXPECT_FALSE(writer.getBitWriterData());
+
+    writer.reset();
+    EXPECT_EQ(0u, writer.getCodedBitsCount());
+    uint8_t bytes[] = { 0xab, 0xcd };
+    EXPECT_TRUE(writer.writeBytes(bytes, sizeof(bytes)));
+    EXPECT_FALSE(writer.writeBytes(bytes, sizeof(bytes) + 1));
+    EXPECT_EQ(16u, writer.getCodedBitsCount());
+    EXPECT_EQ(buffer, writer.getBitWriterData());
+    EXPECT_EQ(0xab, buffer[0]);
+    EXPECT_EQ(0xcd, buffer[1]);
+}
+
+BITWriter_TEST(Writer_Bitstream)
+{
+    const uint8_t data[] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 };
+    for (uint32_t offset = 0; offset < 8; offset++) {
+        for (uint32_t numBits = 0; numBits <= 64; numBits += 7) {
+            BitWriter writer;
+            writer.writeBits(0x5a >> offset, 8 - offset);
+            EXPECT_TRUE(writer.writeBitstream(data, numBits));
+            writer.writeBits(1, 1);
+            uint64_t bits = writer.getCodedBitsCount();
+            EXPECT_EQ(8 - offset + numBits + 1, bits);
+
+            BitReader reader(writer.getBitWriterData(), (bits + 7) / 8);
+            reader.skip(8 - offset);
+            for (uint32_t i = 0; i < numBits; i++)
+                EXPECT_EQ((data[i / 8] >> (7 - i % 8)) & 1u, reader.read(1));
+            EXPECT_EQ(1u, reader.read(1));
+        }
+    }
+}
+
+BITWriter_TEST(Writer_EmulationPrevention)
+{
+    const uint8_t rbsp[] = { 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x03, 0x80 };
+    const uint8_t nal[] = { 0x00, 0x00, 0x01, 0x00, 0x00, 0x03, 0x00, 0x00, 0x04,
+        0x00, 0x00, 0x03, 0x03, 0x80 };
+    //the start code is written as is
+    const uint32_t startCode = 3;
+
+    BitWriter bytes;
+    bytes.writeBytes(rbsp, startCode);
+    bytes.setEmulationPrevention(true);
+    bytes.writeBytes(rbsp + startCode, sizeof(rbsp) - startCode);
+    EXPECT_EQ(sizeof(nal) * 8, bytes.getCodedBitsCount());
+    EXPECT_EQ(std::vector<uint8_t>(nal, nal + sizeof(nal)),
+        std::vector<uint8_t>(bytes.getBitWriterData(), bytes.getBitWriterData() + sizeof(nal)));
+
+    BitWriter bits;
+    bits.writeBytes(rbsp, startCode);
+    bits.setEmulationPrevention(true);
+    for (size_t i = startCode; i < sizeof(rbsp); i++) {
+        bits.writeBits(rbsp[i] >> 4, 4);
+        bits.writeBits(rbsp[i] & 0xf, 4);
+    }
+    EXPECT_EQ(sizeof(nal) * 8, bits.getCodedBitsCount());
+    EXPECT_EQ(std::vector<uint8_t>(nal, nal + sizeof(nal)),
+        std::vector<uint8_t>(bits.getBitWriterData(), bits.getBitWriterData() + sizeof(nal)));
+}
+
 } // namespace YamiParser
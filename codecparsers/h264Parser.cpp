@@ -310,8 +310,18 @@ bool Parser::vuiParameters(SharedPtr<SPS>& sps, NalReader& br)
 
 bool Parser::parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu)
 {
-    NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
-        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    const uint8_t* data = nalu->m_data + nalu->m_nalUnitHeaderBytes;
+    uint32_t size = nalu->m_size - nalu->m_nalUnitHeaderBytes;
+
+    SharedPtr<SPS> same = m_spsSets.find(data, size);
+    if (same) {
+        sps = same;
+        return true;
+    }
+
+    sps.reset(new SPS());
+    memset(sps.get(), 0, sizeof(SPS));
+    NalReader br(data, size);
 
     READ(sps->profile_idc);
     READ(sps->constraint_set0_flag);
@@ -495,7 +505,7 @@ bool Parser::parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu)
         sps->m_cropY = cropUnitY * sps->frame_crop_top_offset;
     }
 
-    m_spsMap[sps->sps_id] = sps;
+    m_spsSets.set(sps->sps_id, sps, data, size);
 
     return true;
 }
@@ -506,8 +516,18 @@ bool Parser::parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu)
     bool pic_scaling_matrix_present_flag;
     int32_t qp_bd_offset;
 
-    NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
-        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    const uint8_t* data = nalu->m_data + nalu->m_nalUnitHeaderBytes;
+    uint32_t size = nalu->m_size - nalu->m_nalUnitHeaderBytes;
+
+    //the pps is only the same if its sps did not change since
+    SharedPtr<PPS> same = m_ppsSets.find(data, size);
+    if (same && same->m_sps == searchSps(same->sps_id)) {
+        pps = same;
+        return true;
+    }
+
+    pps.reset(new PPS());
+    NalReader br(data, size);
 
     READ_UE(pps->pps_id);
     READ_UE(pps->sps_id);
@@ -641,7 +661,7 @@ bool Parser::parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu)
             goto error;
     }
 
-    m_ppsMap[pps->pps_id] = pps;
+    m_ppsSets.set(pps->pps_id, pps, data, size);
 
     return true;
 error:
@@ -649,29 +669,15 @@ error:
     return false;
 }
 
-inline SharedPtr<PPS>
-Parser::searchPps(uint8_t id) const
-{
-    SharedPtr<PPS> res;
-    PpsMap::const_iterator it = m_ppsMap.find(id);
-    if (it != m_ppsMap.end())
-        res = it->second;
-    return res;
-}
-
-inline SharedPtr<SPS>
-Parser::searchSps(uint8_t id) const
+SliceHeader::SliceHeader()
 {
-    SharedPtr<SPS> res;
-    SpsMap::const_iterator it = m_spsMap.find(id);
-    if (it != m_spsMap.end())
-        res = it->second;
-    return res;
+    memset((void*)this, 0, offsetof(SliceHeader, m_pps));
 }
 
-SliceHeader::SliceHeader()
+void SliceHeader::reset()
 {
     memset((void*)this, 0, offsetof(SliceHeader, m_pps));
+    m_pps.reset();
 }
 
 bool SliceHeader::refPicListModification(NalReader& br, RefPicListModification* pm0,
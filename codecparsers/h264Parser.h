@@ -30,9 +30,9 @@
 #define h264parser_h
 
 #include "nalReader.h"
+#include "parameterSets.h"
 #include "VideoCommonDefs.h"
 
-#include <map>
 #include <string.h>
 
 namespace YamiParser {
@@ -371,6 +371,8 @@ struct DecRefPicMarking {
 class SliceHeader {
 public:
     SliceHeader();
+    /* back to the just constructed state, so one header can be reused for every slice */
+    void reset();
     bool parseHeader(Parser* nalparser, NalUnit* nalu);
 
 private:
@@ -430,22 +432,31 @@ public:
         SCALING_LIST_DEFAULT_VALUE = 16
     };
 
-    typedef std::map<uint8_t, SharedPtr<SPS> > SpsMap;
-    typedef std::map<uint8_t, SharedPtr<PPS> > PpsMap;
+    typedef ParameterSets<SPS, MAX_SPS_ID + 1> SpsSets;
+    typedef ParameterSets<PPS, MAX_PPS_ID + 1> PpsSets;
 
+    /* if the nal carries the same bytes as a stored sps/pps,
+     * sps/pps is set to the stored one and nothing is parsed.
+     * otherwise a new one is allocated and parsed into sps/pps */
     bool parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu);
     bool parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu);
 
-    inline SharedPtr<PPS> searchPps(uint8_t id) const;
-    inline SharedPtr<SPS> searchSps(uint8_t id) const;
+    SharedPtr<PPS> searchPps(uint8_t id) const
+    {
+        return m_ppsSets.get(id);
+    }
+    SharedPtr<SPS> searchSps(uint8_t id) const
+    {
+        return m_spsSets.get(id);
+    }
 
 private:
     bool hrdParameters(HRDParameters* hrd, NalReader& nr);
     bool vuiParameters(SharedPtr<SPS>& sps, NalReader& nr);
 
     static const uint8_t EXTENDED_SAR;
-    SpsMap m_spsMap;
-    PpsMap m_ppsMap;
+    SpsSets m_spsSets;
+    PpsSets m_ppsSets;
 };
 
 }
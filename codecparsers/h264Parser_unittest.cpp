@@ -26,6 +26,9 @@
 #include "common/unittest.h"
 #include "common/nalreader.h"
 
+// system headers
+#include <vector>
+
 namespace YamiParser {
 namespace H264 {
 
@@ -209,5 +212,62 @@ namespace H264 {
         ASSERT_FALSE(HasFailure());
     }
 
+    H264_PARSER_TEST(Parse_RepeatedParameterSets)
+    {
+        const uint8_t* nal;
+        int32_t size;
+        NalUnit spsNalu, ppsNalu;
+        NalReader nr(&g_SimpleH264[0], g_SimpleH264.size());
+        Parser parser;
+
+        ASSERT_TRUE(nr.read(nal, size));
+        ASSERT_TRUE(spsNalu.parseNalUnit(nal, size));
+        ASSERT_TRUE(nr.read(nal, size));
+        ASSERT_TRUE(ppsNalu.parseNalUnit(nal, size));
+
+        SharedPtr<SPS> sps(new SPS());
+        memset(sps.get(), 0, sizeof(SPS));
+        ASSERT_TRUE(parser.parseSps(sps, &spsNalu));
+        SharedPtr<PPS> pps(new PPS());
+        ASSERT_TRUE(parser.parsePps(pps, &ppsNalu));
+
+        //resent unchanged, we get the stored ones back
+        SharedPtr<SPS> sps2(new SPS());
+        memset(sps2.get(), 0, sizeof(SPS));
+        ASSERT_TRUE(parser.parseSps(sps2, &spsNalu));
+        EXPECT_EQ(sps, sps2);
+        EXPECT_EQ(sps, parser.searchSps(0));
+        SharedPtr<PPS> pps2(new PPS());
+        ASSERT_TRUE(parser.parsePps(pps2, &ppsNalu));
+        EXPECT_EQ(pps, pps2);
+        EXPECT_EQ(pps, parser.searchPps(0));
+
+        //same pps bytes, but it refers to a new sps now
+        std::vector<uint8_t> changed(spsNalu.m_data, spsNalu.m_data + spsNalu.m_size);
+        changed[3]++; //level_idc
+        NalUnit changedNalu;
+        ASSERT_TRUE(changedNalu.parseNalUnit(&changed[0], changed.size()));
+        SharedPtr<SPS> sps3(new SPS());
+        memset(sps3.get(), 0, sizeof(SPS));
+        ASSERT_TRUE(parser.parseSps(sps3, &changedNalu));
+        EXPECT_NE(sps, sps3);
+        EXPECT_EQ(41, sps3->level_idc);
+        SharedPtr<PPS> pps3(new PPS());
+        ASSERT_TRUE(parser.parsePps(pps3, &ppsNalu));
+        EXPECT_NE(pps, pps3);
+        EXPECT_EQ(sps3, pps3->m_sps);
+
+        //the parser allocates on a miss, callers pass an empty pointer
+        SharedPtr<SPS> sps4;
+        ASSERT_TRUE(parser.parseSps(sps4, &spsNalu));
+        ASSERT_TRUE(bool(sps4));
+        EXPECT_NE(sps3, sps4);
+        EXPECT_EQ(40, sps4->level_idc);
+        SharedPtr<PPS> pps4;
+        ASSERT_TRUE(parser.parsePps(pps4, &ppsNalu));
+        ASSERT_TRUE(bool(pps4));
+        EXPECT_EQ(sps4, pps4->m_sps);
+    }
+
 } // namespace H264
 } // namespace YamiParser
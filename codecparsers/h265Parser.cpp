@@ -188,6 +188,14 @@ SliceHeader::~SliceHeader()
 {
 }
 
+void SliceHeader::reset()
+{
+    memset((void*)this, 0, offsetof(SliceHeader, pps));
+    pps.reset();
+    //keep the capacity for next slice
+    entry_point_offset_minus1.clear();
+}
+
 uint32_t SliceHeader::getSliceDataByteOffset() const
 {
     return NalUnit::NALU_HEAD_SIZE + (headerSize + 7) / 8;
@@ -239,33 +247,24 @@ uint8_t Parser::EXTENDED_SAR = 255;
 
 SharedPtr<VPS> Parser::getVps(uint8_t id) const
 {
-    SharedPtr<VPS> res;
-    VpsMap::const_iterator it = m_vps.find(id);
-    if (it != m_vps.end())
-        res = it->second;
-    else
+    SharedPtr<VPS> res = m_vps.get(id);
+    if (!res)
         WARNING("can't get the VPS by ID(%d)", id);
     return res;
 }
 
 SharedPtr<SPS> Parser::getSps(uint8_t id) const
 {
-    SharedPtr<SPS> res;
-    SpsMap::const_iterator it = m_sps.find(id);
-    if (it != m_sps.end())
-        res = it->second;
-    else
+    SharedPtr<SPS> res = m_sps.get(id);
+    if (!res)
         WARNING("can't get the SPS by ID(%d)", id);
     return res;
 }
 
 SharedPtr<PPS> Parser::getPps(uint8_t id) const
 {
-    SharedPtr<PPS> res;
-    PpsMap::const_iterator it = m_pps.find(id);
-    if (it != m_pps.end())
-        res = it->second;
-    else
+    SharedPtr<PPS> res = m_pps.get(id);
+    if (!res)
         WARNING("can't get the PPS by ID(%d)", id);
     return res;
 }
@@ -898,10 +897,15 @@ bool Parser::predWeightTable(SliceHeader* slice, NalReader& br)
 // 7.3.2.1 Video parameter set RBSP syntax
 bool Parser::parseVps(const NalUnit* nalu)
 {
+    const uint8_t* data = nalu->m_data + NalUnit::NALU_HEAD_SIZE;
+    uint32_t size = nalu->m_size - NalUnit::NALU_HEAD_SIZE;
+
+    if (m_vps.find(data, size))
+        return true;
+
     SharedPtr<VPS> vps(new VPS());
 
-    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
-        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    NalReader br(data, size);
 
     READ_BITS(vps->vps_id, 4);
     READ(vps->vps_base_layer_internal_flag);
@@ -971,7 +975,7 @@ bool Parser::parseVps(const NalUnit* nalu)
             SKIP(1); // vps_extension_data_flag
     }
     br.rbspTrailingBits();
-    m_vps[vps->vps_id] = vps;
+    m_vps.set(vps->vps_id, vps, data, size);
 
     return true;
 }
@@ -979,14 +983,21 @@ bool Parser::parseVps(const NalUnit* nalu)
 // 7.3.2.2 Sequence parameter set RBSP syntax
 bool Parser::parseSps(const NalUnit* nalu)
 {
+    const uint8_t* data = nalu->m_data + NalUnit::NALU_HEAD_SIZE;
+    uint32_t size = nalu->m_size - NalUnit::NALU_HEAD_SIZE;
+
+    //the sps is only the same if its vps did not change since
+    SharedPtr<SPS> same = m_sps.find(data, size);
+    if (same && same->vps == m_vps.get(same->vps_id))
+        return true;
+
     SharedPtr<SPS> sps(new SPS());
     SharedPtr<VPS> vps;
     // Table 6-1
     uint8_t subWidthC[5] = { 1, 2, 2, 1, 1 };
     uint8_t subHeightC[5] = { 1, 2, 1, 1, 1 };
 
-    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
-        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    NalReader br(data, size);
 
     READ_BITS(sps->vps_id, 4);
     vps = getVps(sps->vps_id);
@@ -1114,7 +1125,7 @@ bool Parser::parseSps(const NalUnit* nalu)
     // remaining some extension elements, it is not necessary for me, so ignore.
     // maybe add in the future.
 
-    m_sps[sps->sps_id] = sps;
+    m_sps.set(sps->sps_id, sps, data, size);
 
     return true;
 }
@@ -1122,15 +1133,22 @@ bool Parser::parseSps(const NalUnit* nalu)
 // 7.3.2.3 Picture parameter set RBSP syntax
 bool Parser::parsePps(const NalUnit* nalu)
 {
-    SharedPtr<PPS> pps(new PPS());
     SharedPtr<SPS> sps;
 
     uint32_t minCbLog2SizeY;
     uint32_t ctbLog2SizeY;
     uint32_t ctbSizeY;
 
-    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
-        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    const uint8_t* data = nalu->m_data + NalUnit::NALU_HEAD_SIZE;
+    uint32_t size = nalu->m_size - NalUnit::NALU_HEAD_SIZE;
+
+    //the pps is only the same if its sps did not change since
+    SharedPtr<PPS> same = m_pps.find(data, size);
+    if (same && same->sps == m_sps.get(same->sps_id))
+        return true;
+
+    SharedPtr<PPS> pps(new PPS());
+    NalReader br(data, size);
 
     // set default values
     pps->uniform_spacing_flag = 1;
@@ -1289,7 +1307,7 @@ bool Parser::parsePps(const NalUnit* nalu)
         CHECK_READ_UE(pps->log2_sao_offset_scale_chroma, 0, maxValue);
     }
 
-    m_pps[pps->pps_id] = pps;
+    m_pps.set(pps->pps_id, pps, data, size);
 
     return true;
 }
@@ -27,9 +27,9 @@
 #define h265Parser_h
 
 #include "nalReader.h"
+#include "parameterSets.h"
 #include "VideoCommonDefs.h"
 
-#include <map>
 #include <vector>
 
 namespace YamiParser {
@@ -498,6 +498,9 @@ namespace H265 {
         SliceHeader();
         ~SliceHeader();
 
+        /* back to the just constructed state, so headers can be reused */
+        void reset();
+
         uint32_t getSliceDataByteOffset() const;
 
         bool isBSlice() const;
@@ -587,17 +590,18 @@ namespace H265 {
             NalReader& nr, int32_t numPicTotalCurr);
         bool predWeightTable(SliceHeader* slice, NalReader& nr);
 
-        typedef std::map<uint8_t, SharedPtr<VPS> > VpsMap;
-        typedef std::map<uint8_t, SharedPtr<SPS> > SpsMap;
-        typedef std::map<uint8_t, SharedPtr<PPS> > PpsMap;
+        //vps_video_parameter_set_id is 4 bits
+        typedef ParameterSets<VPS, 16> VpsSets;
+        typedef ParameterSets<SPS, MAXSPSCOUNT + 1> SpsSets;
+        typedef ParameterSets<PPS, MAXPPSCOUNT + 1> PpsSets;
 
         SharedPtr<VPS> getVps(uint8_t id) const;
         SharedPtr<SPS> getSps(uint8_t id) const;
         SharedPtr<PPS> getPps(uint8_t id) const;
 
-        VpsMap m_vps;
-        SpsMap m_sps;
-        PpsMap m_pps;
+        VpsSets m_vps;
+        SpsSets m_sps;
+        PpsSets m_pps;
 
         friend class H265ParserTest;
     };
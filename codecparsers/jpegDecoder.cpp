@@ -0,0 +1,652 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ----
+ *
+ * The huffman decoding and the integer inverse DCT in this decoder follow
+ * IJG's libjpeg jdhuff.c and jidctint.c (the "islow" method), so the output
+ * matches libjpeg's default DCT method.  They are rewritten using C++-style
+ * syntax and data structures to fit into the overall libyami framework.
+ * Therefore, this implementation is considered to be partially derived from
+ * IJG's libjpeg.
+ *
+ * The following license preamble, below, is reproduced from libjpeg's
+ * jidctint.c file.  The README.ijg is also provided with this file:
+ *
+ * Copyright (C) 1991-1998, Thomas G. Lane.
+ * The jidctint.c file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README.ijg file.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "jpegDecoder.h"
+
+// library headers
+#include "common/log.h"
+
+// system headers
+#include <algorithm>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define YAMI_JPEG_X86_SIMD 1
+#else
+#define YAMI_JPEG_X86_SIMD 0
+#endif
+
+namespace YamiParser {
+namespace JPEG {
+
+using ::std::bind;
+using ::std::ref;
+using ::YamiMediaCodec::Thread;
+
+// natural order position of the k-th coefficient in zigzag order
+static const uint8_t naturalOrder[DCTSIZE2] = {
+    0,   1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * Reads the entropy coded data of one segment, removing the stuffed zero
+ * after every 0xFF.  Like libjpeg, zeros are fed once the data runs out so
+ * a truncated segment still decodes into something.
+ */
+class EntropyReader {
+public:
+    EntropyReader(const uint8_t* data, uint32_t size)
+        : m_current(data)
+        , m_end(data + size)
+        , m_bits(0)
+        , m_count(0)
+    {
+    }
+
+    // make sure at least 57 bits are buffered
+    void fill()
+    {
+        while (m_count <= 56) {
+            uint64_t byte = 0;
+            if (m_current < m_end) {
+                byte = *m_current++;
+                if (byte == 0xFF) {
+                    if (m_current < m_end && !*m_current) {
+                        m_current++;
+                    } else {
+                        // a fill byte or a marker, nothing more to read
+                        m_current = m_end;
+                        byte = 0;
+                    }
+                }
+            }
+            m_bits |= byte << (56 - m_count);
+            m_count += 8;
+        }
+    }
+
+    uint32_t peek(uint32_t n) const { return m_bits >> (64 - n); }
+
+    void skip(uint32_t n)
+    {
+        m_bits <<= n;
+        m_count -= n;
+    }
+
+    // F.2.2.1 RECEIVE and EXTEND, n is at most 15
+    int32_t receiveExtend(uint32_t n)
+    {
+        if (!n)
+            return 0;
+        const int32_t v = peek(n);
+        skip(n);
+        return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+    }
+
+private:
+    const uint8_t* m_current;
+    const uint8_t* const m_end;
+    uint64_t m_bits;
+    int32_t m_count;
+};
+
+/**
+ * Canonical huffman decoding of F.2.2.3, with a lookup table for the codes
+ * of up to LOOKAHEAD bits.
+ */
+class HuffDecoder {
+public:
+    enum { LOOKAHEAD = 9 };
+
+    bool init(const HuffTable& table)
+    {
+        uint32_t count = 0;
+        for (size_t i(0); i < 16; ++i)
+            count += table.codes[i];
+        if (count > 256)
+            return false;
+
+        // check the code space before filling anything, an over-subscribed
+        // table would run the lookup fill past its end (jdhuff does the same)
+        int32_t code = 0;
+        for (uint32_t length(1); length <= 16; ++length) {
+            code += table.codes[length - 1];
+            // all ones is not a valid code
+            if (code >= (1 << length))
+                return false;
+            code <<= 1;
+        }
+
+        memset(m_lookup, 0, sizeof(m_lookup));
+        memset(m_coefLookup, 0, sizeof(m_coefLookup));
+        memcpy(m_values, &table.values[0], sizeof(m_values));
+
+        code = 0;
+        int32_t index = 0;
+        for (uint32_t length(1); length <= 16; ++length) {
+            const int32_t n = table.codes[length - 1];
+            m_valueOffset[length] = index - code;
+            m_maxCode[length] = n ? code + n - 1 : -1;
+            for (int32_t i(0); i < n; ++i, ++code, ++index) {
+                if (length > LOOKAHEAD)
+                    continue;
+                const uint32_t shift = LOOKAHEAD - length;
+                const uint16_t entry = (length << 8) | m_values[index];
+                for (uint32_t j(0); j < (1u << shift); ++j) {
+                    m_lookup[(code << shift) | j] = entry;
+                    m_coefLookup[(code << shift) | j] = coefEntry(length, m_values[index], j, shift);
+                }
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    // EntropyReader::fill() must be called first
+    uint8_t decode(EntropyReader& reader) const
+    {
+        const uint16_t entry = m_lookup[reader.peek(LOOKAHEAD)];
+        if (entry) {
+            reader.skip(entry >> 8);
+            return entry & 0xFF;
+        }
+        for (uint32_t length(LOOKAHEAD + 1); length <= 16; ++length) {
+            const int32_t code = reader.peek(length);
+            if (code <= m_maxCode[length]) {
+                reader.skip(length);
+                return m_values[(m_valueOffset[length] + code) & 0xFF];
+            }
+        }
+        // corrupt data, go on with a zero like libjpeg does
+        reader.skip(16);
+        return 0;
+    }
+
+    /**
+     * Decode an AC run/size symbol and the coefficient bits following it in
+     * one lookup when both fit in LOOKAHEAD bits.  EntropyReader::fill()
+     * must be called first.
+     *
+     * @return false if the caller has to fall back to decode()
+     */
+    bool decodeCoef(EntropyReader& reader, uint32_t& run, int32_t& value) const
+    {
+        const int32_t entry = m_coefLookup[reader.peek(LOOKAHEAD)];
+        if (!entry)
+            return false;
+        reader.skip(entry & 15);
+        run = (entry >> 4) & 15;
+        value = entry >> 8;
+        return true;
+    }
+
+private:
+    // value << 8 | run << 4 | total bits, 0 if the coefficient does not
+    // fit or the symbol has no coefficient bits (EOB, ZRL)
+    static int32_t coefEntry(uint32_t length, uint8_t rs, uint32_t bits, uint32_t shift)
+    {
+        const uint32_t size = rs & 15;
+        if (!size || length + size > LOOKAHEAD)
+            return 0;
+        int32_t v = bits >> (shift - size);
+        if (v < (1 << (size - 1)))
+            v -= (1 << size) - 1;
+        return (v * 256) | ((rs >> 4) << 4) | (length + size);
+    }
+
+    // code length << 8 | value, 0 for longer codes
+    uint16_t m_lookup[1 << LOOKAHEAD];
+    int32_t m_coefLookup[1 << LOOKAHEAD];
+    int32_t m_maxCode[17];
+    int32_t m_valueOffset[17];
+    uint8_t m_values[256];
+};
+
+/* the integer inverse DCT of jidctint.c.  The 1-D transform is written
+ * once for four lanes of gcc vector extensions, so both passes work on
+ * four columns (rows) at a time in SSE2/NEON registers. */
+typedef int32_t Lanes __attribute__((vector_size(16)));
+
+#define CONST_BITS 13
+#define PASS1_BITS 2
+
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+// x[i] is the i-th input of the four transforms, results are scaled
+// down by shift with rounding
+static inline __attribute__((always_inline)) void idct8(Lanes x[8], uint32_t shift)
+{
+    // even part
+    Lanes z1 = (x[2] + x[6]) * FIX_0_541196100;
+    Lanes tmp2 = z1 - x[6] * FIX_1_847759065;
+    Lanes tmp3 = z1 + x[2] * FIX_0_765366865;
+
+    Lanes tmp0 = (x[0] + x[4]) << CONST_BITS;
+    Lanes tmp1 = (x[0] - x[4]) << CONST_BITS;
+    tmp0 += 1 << (shift - 1);
+    tmp1 += 1 << (shift - 1);
+
+    const Lanes tmp10 = tmp0 + tmp3;
+    const Lanes tmp13 = tmp0 - tmp3;
+    const Lanes tmp11 = tmp1 + tmp2;
+    const Lanes tmp12 = tmp1 - tmp2;
+
+    // odd part
+    tmp0 = x[7];
+    tmp1 = x[5];
+    tmp2 = x[3];
+    tmp3 = x[1];
+
+    z1 = tmp0 + tmp3;
+    Lanes z2 = tmp1 + tmp2;
+    Lanes z3 = tmp0 + tmp2;
+    Lanes z4 = tmp1 + tmp3;
+    const Lanes z5 = (z3 + z4) * FIX_1_175875602;
+
+    tmp0 *= FIX_0_298631336;
+    tmp1 *= FIX_2_053119869;
+    tmp2 *= FIX_3_072711026;
+    tmp3 *= FIX_1_501321110;
+    z1 *= -FIX_0_899976223;
+    z2 *= -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    x[0] = (tmp10 + tmp3) >> shift;
+    x[7] = (tmp10 - tmp3) >> shift;
+    x[1] = (tmp11 + tmp2) >> shift;
+    x[6] = (tmp11 - tmp2) >> shift;
+    x[2] = (tmp12 + tmp1) >> shift;
+    x[5] = (tmp12 - tmp1) >> shift;
+    x[3] = (tmp13 + tmp0) >> shift;
+    x[4] = (tmp13 - tmp0) >> shift;
+}
+
+static inline __attribute__((always_inline)) Lanes clampSample(Lanes v)
+{
+    v += 128;
+    v &= (Lanes)(v > 0);
+    const Lanes over = (Lanes)(v > 255);
+    return (v & ~over) | (over & 255);
+}
+
+// coefficients in natural order, dequantized
+static inline __attribute__((always_inline)) void idctBlockBody(const int32_t coefs[DCTSIZE2], uint8_t* out, uint32_t pitch)
+{
+    Lanes x[8];
+    int32_t work[DCTSIZE2] __attribute__((aligned(16)));
+
+    // columns, four at a time
+    for (uint32_t half(0); half < 2; ++half) {
+        for (uint32_t i(0); i < 8; ++i)
+            memcpy(&x[i], &coefs[i * DCTSIZE + half * 4], sizeof(Lanes));
+        idct8(x, CONST_BITS - PASS1_BITS);
+        for (uint32_t i(0); i < 8; ++i)
+            memcpy(&work[i * DCTSIZE + half * 4], &x[i], sizeof(Lanes));
+    }
+
+    // rows, four at a time, lane j works on row half * 4 + j
+    for (uint32_t half(0); half < 2; ++half) {
+        const int32_t* row = &work[half * 4 * DCTSIZE];
+        for (uint32_t i(0); i < 8; ++i) {
+            const Lanes column = { row[i], row[DCTSIZE + i],
+                row[2 * DCTSIZE + i], row[3 * DCTSIZE + i] };
+            x[i] = column;
+        }
+        idct8(x, CONST_BITS + PASS1_BITS + 3);
+        for (uint32_t i(0); i < 8; ++i) {
+            const Lanes samples = clampSample(x[i]);
+            for (uint32_t j(0); j < 4; ++j)
+                out[(half * 4 + j) * pitch + i] = samples[j];
+        }
+    }
+}
+
+typedef void (*IdctFunction)(const int32_t coefs[DCTSIZE2], uint8_t* out, uint32_t pitch);
+
+static void idctBlockGeneric(const int32_t coefs[DCTSIZE2], uint8_t* out, uint32_t pitch)
+{
+    idctBlockBody(coefs, out, pitch);
+}
+
+#if YAMI_JPEG_X86_SIMD
+// sse2 has no 32-bit multiply, pmulld of sse4.1 more than halves the cost
+__attribute__((target("sse4.1"))) static void idctBlockSse41(const int32_t coefs[DCTSIZE2], uint8_t* out, uint32_t pitch)
+{
+    idctBlockBody(coefs, out, pitch);
+}
+#endif
+
+static IdctFunction selectIdct()
+{
+#if YAMI_JPEG_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+        return idctBlockSse41;
+#endif
+    return idctBlockGeneric;
+}
+
+static void idctBlock(const int32_t coefs[DCTSIZE2], uint8_t* out, uint32_t pitch)
+{
+    static const IdctFunction idct = selectIdct();
+    idct(coefs, out, pitch);
+}
+
+// the result of idctBlock() when only the DC coefficient is set
+static void dcBlock(int32_t dc, uint8_t* out, uint32_t pitch)
+{
+    int32_t v = ((dc << PASS1_BITS) + 16) >> 5;
+    v = std::min(std::max(v + 128, 0), 255);
+    for (uint32_t i(0); i < DCTSIZE; ++i)
+        memset(out + i * pitch, v, DCTSIZE);
+}
+
+// a component of the scan being decoded
+struct ScanComponent {
+    const HuffDecoder* dc;
+    const HuffDecoder* ac;
+    int32_t quant[DCTSIZE2]; // zigzag order
+    uint32_t hBlocks; // per mcu
+    uint32_t vBlocks;
+    uint32_t width; // of the plane
+    uint32_t height;
+    Decoder::Plane plane;
+};
+
+struct Decoder::Scan {
+    const uint8_t* data;
+    const RestartIntervals* segments;
+    uint32_t restartInterval;
+    uint32_t mcusPerRow;
+    uint32_t mcus;
+    size_t numComponents;
+    ScanComponent components[MAX_COMPS_IN_SCAN];
+    HuffDecoder dcTables[NUM_HUFF_TBLS];
+    HuffDecoder acTables[NUM_HUFF_TBLS];
+};
+
+// decode one block and write its samples to the plane, clipped at the
+// plane's edges
+static void decodeBlock(EntropyReader& reader,
+    const ScanComponent& component, int32_t& pred,
+    uint32_t x, uint32_t y)
+{
+    int32_t coefs[DCTSIZE2];
+    memset(coefs, 0, sizeof(coefs));
+
+    reader.fill();
+    const uint8_t dcSize = component.dc->decode(reader);
+    pred += reader.receiveExtend(dcSize & 15);
+    coefs[0] = pred * component.quant[0];
+
+    bool acCoded = false;
+    for (uint32_t k(1); k < DCTSIZE2; ++k) {
+        reader.fill();
+        uint32_t run;
+        int32_t value;
+        if (component.ac->decodeCoef(reader, run, value)) {
+            k += run;
+            if (k >= DCTSIZE2)
+                break;
+            coefs[naturalOrder[k]] = value * component.quant[k];
+            acCoded = true;
+            continue;
+        }
+        const uint8_t rs = component.ac->decode(reader);
+        run = rs >> 4;
+        const uint32_t size = rs & 15;
+        if (!size) {
+            if (run != 15)
+                break;
+            k += 15;
+            continue;
+        }
+        k += run;
+        if (k >= DCTSIZE2)
+            break;
+        coefs[naturalOrder[k]] = reader.receiveExtend(size) * component.quant[k];
+        acCoded = true;
+    }
+
+    if (x >= component.width || y >= component.height)
+        return;
+
+    const Decoder::Plane& plane = component.plane;
+    uint8_t* out = plane.data + y * plane.pitch + x;
+    uint8_t edge[DCTSIZE2];
+    const bool clipped = x + DCTSIZE > component.width
+        || y + DCTSIZE > component.height;
+    uint8_t* target = clipped ? edge : out;
+    const uint32_t pitch = clipped ? DCTSIZE : plane.pitch;
+
+    if (acCoded)
+        idctBlock(coefs, target, pitch);
+    else
+        dcBlock(coefs[0], target, pitch);
+
+    if (clipped) {
+        const uint32_t w = std::min<uint32_t>(DCTSIZE, component.width - x);
+        const uint32_t h = std::min<uint32_t>(DCTSIZE, component.height - y);
+        for (uint32_t i(0); i < h; ++i)
+            memcpy(out + i * plane.pitch, edge + i * DCTSIZE, w);
+    }
+}
+
+void Decoder::decodeSegments(const Scan& scan, size_t first, size_t last)
+{
+    const RestartIntervals& segments = *scan.segments;
+
+    for (size_t s(first); s < last; ++s) {
+        EntropyReader reader(scan.data + segments[s].offset, segments[s].size);
+        int32_t preds[MAX_COMPS_IN_SCAN] = { 0 };
+
+        const uint32_t begin = scan.restartInterval ? s * scan.restartInterval : 0;
+        const uint32_t end = scan.restartInterval
+            ? std::min(begin + scan.restartInterval, scan.mcus) : scan.mcus;
+
+        for (uint32_t mcu(begin); mcu < end; ++mcu) {
+            const uint32_t mcuX = mcu % scan.mcusPerRow;
+            const uint32_t mcuY = mcu / scan.mcusPerRow;
+            for (size_t c(0); c < scan.numComponents; ++c) {
+                const ScanComponent& component = scan.components[c];
+                for (uint32_t by(0); by < component.vBlocks; ++by) {
+                    for (uint32_t bx(0); bx < component.hBlocks; ++bx) {
+                        decodeBlock(reader, component, preds[c],
+                            (mcuX * component.hBlocks + bx) * DCTSIZE,
+                            (mcuY * component.vBlocks + by) * DCTSIZE);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void doNothing() { }
+
+Decoder::Decoder(uint32_t threads)
+{
+    for (uint32_t i(1); i < threads; ++i) {
+        ThreadPtr worker(new Thread("jpeg decode"));
+        if (!worker->start()) {
+            ERROR("failed to start jpeg decoding thread");
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+}
+
+Decoder::~Decoder()
+{
+    for (size_t i(0); i < m_workers.size(); ++i)
+        m_workers[i]->stop();
+}
+
+bool Decoder::isSupported(const FrameHeader& frame, const ScanHeader& scan)
+{
+    if (frame.isArithmetic || frame.isProgressive || frame.dataPrecision != 8)
+        return false;
+    if (scan.numComponents != frame.components.size())
+        return false;
+    return scan.ss == 0 && scan.se == 63 && !scan.ah && !scan.al;
+}
+
+bool Decoder::decode(const uint8_t* data, const FrameHeader& frame,
+    const ScanHeader& scanHeader, const QuantTables& quantTables,
+    const HuffTables& dcTables, const HuffTables& acTables,
+    unsigned restartInterval, const RestartIntervals& segments,
+    const Plane planes[])
+{
+    if (!isSupported(frame, scanHeader)) {
+        ERROR("unsupported jpeg scan for software decoding");
+        return false;
+    }
+
+    Scan scan;
+    scan.data = data;
+    scan.segments = &segments;
+    scan.restartInterval = restartInterval;
+    scan.numComponents = scanHeader.numComponents;
+
+    const uint32_t maxH = frame.maxHSampleFactor;
+    const uint32_t maxV = frame.maxVSampleFactor;
+    const bool interleaved = scan.numComponents > 1;
+    if (interleaved) {
+        scan.mcusPerRow = (frame.imageWidth + maxH * DCTSIZE - 1) / (maxH * DCTSIZE);
+        scan.mcus = scan.mcusPerRow
+            * ((frame.imageHeight + maxV * DCTSIZE - 1) / (maxV * DCTSIZE));
+    }
+
+    bool dcReady[NUM_HUFF_TBLS] = { false };
+    bool acReady[NUM_HUFF_TBLS] = { false };
+
+    for (size_t c(0); c < scan.numComponents; ++c) {
+        const Component& header = *scanHeader.components[c];
+        ScanComponent& component = scan.components[c];
+
+        const uint32_t h = header.hSampleFactor;
+        const uint32_t v = header.vSampleFactor;
+        component.width = (frame.imageWidth * h + maxH - 1) / maxH;
+        component.height = (frame.imageHeight * v + maxV - 1) / maxV;
+        component.hBlocks = interleaved ? h : 1;
+        component.vBlocks = interleaved ? v : 1;
+        component.plane = planes[header.index];
+
+        if (!interleaved) {
+            scan.mcusPerRow = (component.width + DCTSIZE - 1) / DCTSIZE;
+            scan.mcus = scan.mcusPerRow
+                * ((component.height + DCTSIZE - 1) / DCTSIZE);
+        }
+
+        const size_t q = header.quantTableNumber;
+        const size_t dc = header.dcTableNumber;
+        const size_t ac = header.acTableNumber;
+        if (q >= NUM_QUANT_TBLS || !quantTables[q]
+            || dc >= NUM_HUFF_TBLS || !dcTables[dc]
+            || ac >= NUM_HUFF_TBLS || !acTables[ac]) {
+            ERROR("missing table for component %d", header.id);
+            return false;
+        }
+
+        for (size_t i(0); i < DCTSIZE2; ++i)
+            component.quant[i] = quantTables[q]->values[i];
+
+        if (!dcReady[dc] && !scan.dcTables[dc].init(*dcTables[dc])) {
+            ERROR("bad dc huffman table %d", (int)dc);
+            return false;
+        }
+        if (!acReady[ac] && !scan.acTables[ac].init(*acTables[ac])) {
+            ERROR("bad ac huffman table %d", (int)ac);
+            return false;
+        }
+        dcReady[dc] = acReady[ac] = true;
+        component.dc = &scan.dcTables[dc];
+        component.ac = &scan.acTables[ac];
+    }
+
+    size_t numSegments = 1;
+    if (restartInterval) {
+        numSegments = (scan.mcus + restartInterval - 1) / restartInterval;
+        if (segments.size() != numSegments) {
+            ERROR("expected %u restart intervals, found %u",
+                (unsigned)numSegments, (unsigned)segments.size());
+            return false;
+        }
+    } else if (segments.size() != 1) {
+        ERROR("restart markers without a restart interval");
+        return false;
+    }
+
+    // contiguous runs of segments, the caller takes the first one
+    const size_t jobs = std::min(m_workers.size() + 1, numSegments);
+    for (size_t i(1); i < jobs; ++i) {
+        m_workers[i - 1]->post(bind(&Decoder::decodeSegments, this, ref(scan),
+            numSegments * i / jobs, numSegments * (i + 1) / jobs));
+    }
+    decodeSegments(scan, 0, numSegments / jobs);
+    for (size_t i(1); i < jobs; ++i)
+        m_workers[i - 1]->send(doNothing);
+
+    return true;
+}
+
+} // namespace JPEG
+} // namespace YamiParser
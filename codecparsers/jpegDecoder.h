@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ----
+ *
+ * The huffman decoding and the integer inverse DCT in this decoder follow
+ * IJG's libjpeg jdhuff.c and jidctint.c (the "islow" method), so the output
+ * matches libjpeg's default DCT method.  They are rewritten using C++-style
+ * syntax and data structures to fit into the overall libyami framework.
+ * Therefore, this implementation is considered to be partially derived from
+ * IJG's libjpeg.
+ *
+ * The following license preamble, below, is reproduced from libjpeg's
+ * jidctint.c file.  The README.ijg is also provided with this file:
+ *
+ * Copyright (C) 1991-1998, Thomas G. Lane.
+ * The jidctint.c file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README.ijg file.
+ *
+ */
+
+#ifndef jpegDecoder_h
+#define jpegDecoder_h
+
+// library headers
+#include "jpegParser.h"
+#include "common/Thread.h"
+
+// system headers
+#include <vector>
+
+namespace YamiParser {
+namespace JPEG {
+
+/**
+ * Decodes baseline JPEG scans on the cpu: 8-bit samples, huffman coding and
+ * one scan that holds all the components of the frame.  The restart
+ * intervals of a scan are independent, so they are split over a few worker
+ * threads.
+ */
+class Decoder {
+public:
+    struct Plane {
+        uint8_t* data;
+        uint32_t pitch;
+    };
+
+    /**
+     * @param threads how many threads decode the restart intervals of a scan,
+     * the calling thread included.
+     */
+    explicit Decoder(uint32_t threads = 1);
+
+    ~Decoder();
+
+    /**
+     * @return true if decode() can handle the frame and scan
+     */
+    static bool isSupported(const FrameHeader&, const ScanHeader&);
+
+    /**
+     * Decode the entropy coded data of a scan.  The segments are given by
+     * Parser::restartIntervals() with offsets into data.  Samples are written
+     * to one Plane per frame component, in frame order.  A component plane is
+     * ceil(imageWidth * h / maxH) by ceil(imageHeight * v / maxV) samples.
+     *
+     * @retval true if the scan is decoded
+     * @retval false if the scan is unsupported, a table is missing or the
+     * segments don't match the restart interval
+     */
+    bool decode(const uint8_t* data, const FrameHeader&, const ScanHeader&,
+        const QuantTables&, const HuffTables& dcTables,
+        const HuffTables& acTables, unsigned restartInterval,
+        const RestartIntervals&, const Plane planes[]);
+
+private:
+    struct Scan;
+
+    void decodeSegments(const Scan&, size_t first, size_t last);
+
+    typedef std::shared_ptr<YamiMediaCodec::Thread> ThreadPtr;
+    std::vector<ThreadPtr> m_workers;
+
+    DISALLOW_COPY_AND_ASSIGN(Decoder);
+};
+
+} // namespace JPEG
+} // namespace YamiParser
+
+#endif // jpegDecoder_h
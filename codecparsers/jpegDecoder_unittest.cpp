@@ -0,0 +1,208 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "jpegDecoder.h"
+
+// library headers
+#include "common/unittest.h"
+
+namespace YamiParser {
+namespace JPEG {
+
+// 30x20, 4:2:0, one MCU per restart interval
+const static std::array<uint8_t, 391> g_RestartJPEG = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+    0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+    0x00, 0x1b, 0x12, 0x14, 0x17, 0x14, 0x11, 0x1b, 0x17, 0x16, 0x17, 0x1e,
+    0x1c, 0x1b, 0x20, 0x28, 0x42, 0x2b, 0x28, 0x25, 0x25, 0x28, 0x51, 0x3a,
+    0x3d, 0x30, 0x42, 0x60, 0x55, 0x65, 0x64, 0x5f, 0x55, 0x5d, 0x5b, 0x6a,
+    0x78, 0x99, 0x81, 0x6a, 0x71, 0x90, 0x73, 0x5b, 0x5d, 0x85, 0xb5, 0x86,
+    0x90, 0x9e, 0xa3, 0xab, 0xad, 0xab, 0x67, 0x80, 0xbc, 0xc9, 0xba, 0xa6,
+    0xc7, 0x99, 0xa8, 0xab, 0xa4, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x1c, 0x1e,
+    0x1e, 0x28, 0x23, 0x28, 0x4e, 0x2b, 0x2b, 0x4e, 0xa4, 0x6e, 0x5d, 0x6e,
+    0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4,
+    0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4,
+    0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4,
+    0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4, 0xa4,
+    0xa4, 0xa4, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x14, 0x00, 0x1e, 0x03,
+    0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00,
+    0x17, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05, 0xff, 0xc4,
+    0x00, 0x1e, 0x10, 0x00, 0x02, 0x02, 0x02, 0x03, 0x01, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+    0x61, 0x11, 0x21, 0x51, 0x31, 0x71, 0xff, 0xc4, 0x00, 0x17, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x02, 0x04, 0x03, 0x05, 0xff, 0xc4, 0x00, 0x1b, 0x11,
+    0x00, 0x03, 0x00, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x02, 0x11, 0x22, 0x31, 0x61,
+    0xff, 0xdd, 0x00, 0x04, 0x00, 0x01, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01,
+    0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xc3, 0x85, 0x1a, 0x1f,
+    0x0c, 0x7d, 0x15, 0xd7, 0x46, 0x8a, 0x6b, 0xc7, 0xd0, 0x30, 0xe8, 0x13,
+    0xb9, 0xff, 0xd0, 0x86, 0x18, 0xfa, 0x1d, 0x1c, 0x6e, 0xbe, 0x16, 0xaa,
+    0x94, 0x7a, 0xe3, 0x96, 0x32, 0x34, 0xc9, 0xaf, 0x3f, 0x03, 0x93, 0x9e,
+    0x2f, 0x5e, 0xb2, 0xd9, 0x5d, 0x9f, 0xff, 0xd1, 0x6d, 0x50, 0x5e, 0x14,
+    0xc6, 0x29, 0x47, 0x94, 0x80, 0x0c, 0x22, 0xf8, 0x6f, 0xe1, 0xcb, 0x99,
+    0xff, 0xd2, 0xd1, 0xae, 0x11, 0xf0, 0x7b, 0x49, 0x74, 0x80, 0x08, 0xb6,
+    0xd4, 0x9b, 0x41, 0x9f, 0xa7, 0xff, 0xd9
+};
+
+// samples of libjpeg's islow decoding of g_RestartJPEG
+struct PlaneChecksum {
+    uint32_t width;
+    uint32_t height;
+    uint32_t sum; // of the samples
+    uint32_t weighted; // of the samples times their raster position + 1
+};
+
+const static PlaneChecksum g_RestartChecksums[3] = {
+    { 30, 20, 67241, 24936464 },
+    { 15, 10, 17391, 1277451 },
+    { 15, 10, 19592, 1290259 },
+};
+
+class JPEGDecoderTest
+    : public ::testing::Test {
+protected:
+    void SetUp()
+    {
+        parser.reset(new Parser(&g_RestartJPEG[0], g_RestartJPEG.size()));
+        ASSERT_TRUE(parser->parse());
+        for (size_t i(0); i < 3; ++i) {
+            samples[i].assign(g_RestartChecksums[i].width
+                * g_RestartChecksums[i].height, 0);
+            planes[i].data = &samples[i][0];
+            planes[i].pitch = g_RestartChecksums[i].width;
+        }
+    }
+
+    bool decode(Decoder& decoder, const RestartIntervals& intervals)
+    {
+        return decoder.decode(&g_RestartJPEG[0], *parser->frameHeader(),
+            *parser->scanHeader(), parser->quantTables(),
+            parser->dcHuffTables(), parser->acHuffTables(),
+            parser->restartInterval(), intervals, planes);
+    }
+
+    void checkSamples()
+    {
+        for (size_t i(0); i < 3; ++i) {
+            uint32_t sum = 0;
+            uint32_t weighted = 0;
+            for (size_t j(0); j < samples[i].size(); ++j) {
+                sum += samples[i][j];
+                weighted += (j + 1) * samples[i][j];
+            }
+            EXPECT_EQ(g_RestartChecksums[i].sum, sum) << i;
+            EXPECT_EQ(g_RestartChecksums[i].weighted, weighted) << i;
+        }
+    }
+
+    Parser::Shared parser;
+    std::vector<uint8_t> samples[3];
+    Decoder::Plane planes[3];
+};
+
+#define JPEG_DECODER_TEST(name) \
+    TEST_F(JPEGDecoderTest, name)
+
+JPEG_DECODER_TEST(Decode)
+{
+    Decoder decoder;
+
+    EXPECT_EQ(1u, parser->restartInterval());
+    EXPECT_EQ(4u, parser->restartIntervals().size());
+    EXPECT_TRUE(decoder.isSupported(*parser->frameHeader(), *parser->scanHeader()));
+
+    ASSERT_TRUE(decode(decoder, parser->restartIntervals()));
+    checkSamples();
+}
+
+JPEG_DECODER_TEST(Decode_Threads)
+{
+    Decoder decoder(3);
+
+    ASSERT_TRUE(decode(decoder, parser->restartIntervals()));
+    checkSamples();
+
+    // the decoder is reusable
+    for (size_t i(0); i < 3; ++i)
+        std::fill(samples[i].begin(), samples[i].end(), 0);
+    ASSERT_TRUE(decode(decoder, parser->restartIntervals()));
+    checkSamples();
+}
+
+JPEG_DECODER_TEST(Decode_BadRestartIntervals)
+{
+    Decoder decoder;
+    RestartIntervals intervals(parser->restartIntervals());
+
+    intervals.pop_back();
+    EXPECT_FALSE(decode(decoder, intervals));
+}
+
+JPEG_DECODER_TEST(Decode_MissingTable)
+{
+    Decoder decoder;
+    HuffTables acTables(parser->acHuffTables());
+
+    acTables[1].reset();
+    EXPECT_FALSE(decoder.decode(&g_RestartJPEG[0], *parser->frameHeader(),
+        *parser->scanHeader(), parser->quantTables(), parser->dcHuffTables(),
+        acTables, parser->restartInterval(), parser->restartIntervals(),
+        planes));
+}
+
+JPEG_DECODER_TEST(Decode_OverSubscribedTable)
+{
+    Decoder decoder;
+    HuffTables dcTables(parser->dcHuffTables());
+
+    // three codes of length 1 do not fit, the parser rejects this too
+    dcTables[0].reset(new HuffTable(*dcTables[0]));
+    dcTables[0]->codes[0] = 3;
+    EXPECT_FALSE(decoder.decode(&g_RestartJPEG[0], *parser->frameHeader(),
+        *parser->scanHeader(), parser->quantTables(), dcTables,
+        parser->acHuffTables(), parser->restartInterval(),
+        parser->restartIntervals(), planes));
+}
+
+JPEG_DECODER_TEST(IsSupported)
+{
+    FrameHeader frame(*parser->frameHeader());
+    ScanHeader scan(*parser->scanHeader());
+
+    EXPECT_TRUE(Decoder::isSupported(frame, scan));
+
+    frame.isProgressive = true;
+    EXPECT_FALSE(Decoder::isSupported(frame, scan));
+    frame.isProgressive = false;
+
+    frame.dataPrecision = 12;
+    EXPECT_FALSE(Decoder::isSupported(frame, scan));
+    frame.dataPrecision = 8;
+
+    // components in separate scans
+    scan.numComponents = 1;
+    EXPECT_FALSE(Decoder::isSupported(frame, scan));
+}
+
+} // namespace JPEG
+} // namespace YamiParser
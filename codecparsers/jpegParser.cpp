@@ -40,6 +40,7 @@
 #include "jpegParser.h"
 
 // library headers
+#include "common/bytescan.h"
 #include "common/log.h"
 
 // system headers
@@ -223,6 +224,7 @@ Defaults::Defaults()
 
 Parser::Parser(const uint8_t* data, const uint32_t size)
     : m_input(data, size)
+    , m_inputOffset(0)
     , m_data(data)
     , m_size(size)
     , m_current()
@@ -239,9 +241,28 @@ Parser::Parser(const uint8_t* data, const uint32_t size)
     , m_sawEOI(false)
     , m_sawSOS(false)
     , m_restartInterval(0)
+    , m_restartIntervals()
+    , m_inEntropyData(false)
 {
 }
 
+void Parser::reset(const uint8_t* data, const uint32_t size)
+{
+    m_data = data;
+    m_size = size;
+    seek(0);
+
+    m_current = Segment();
+    m_frameHeader.reset();
+    m_scanHeader.reset();
+    m_sawSOI = false;
+    m_sawEOI = false;
+    m_sawSOS = false;
+    m_restartInterval = 0;
+    m_restartIntervals.clear();
+    m_inEntropyData = false;
+}
+
 bool Parser::skipBytes(const uint32_t nBytes)
 {
     if ((static_cast<uint64_t>(nBytes) << 3)
@@ -250,19 +271,26 @@ bool Parser::skipBytes(const uint32_t nBytes)
         return false;
     }
 
-    // BitReader only supports skipping a max of CACHEBYTES at a time
-    // for each call to skip.
-    const uint32_t nSkips = nBytes / BitReader::CACHEBYTES;
-    const uint32_t rem = nBytes % BitReader::CACHEBYTES;
-    for (uint32_t i(0); i < nSkips; ++i)
-        m_input.skip(BitReader::CACHEBYTES << 3);
-    m_input.skip(rem << 3);
+    // the parser only reads whole bytes, so m_input is always byte aligned
+    seek(currentBytePosition() + nBytes);
 
     return true;
 }
 
+void Parser::seek(uint32_t position)
+{
+    // restart the reader there instead of skipping a large entropy coded
+    // segment CACHEBYTES at a time
+    m_input = BitReader(m_data + position, m_size - position);
+    m_inputOffset = position;
+}
+
 void Parser::registerCallback(const Marker& marker, const Callback& callback)
 {
+    if (static_cast<size_t>(marker) >= m_callbacks.size()) {
+        ERROR("Invalid marker 0x%x", marker);
+        return;
+    }
     m_callbacks[marker].push_back(callback);
 }
 
@@ -278,14 +306,11 @@ void Parser::registerStartOfFrameCallback(const Callback& callback)
 
 Parser::CallbackResult Parser::notifyCallbacks() const
 {
-    const Callbacks::const_iterator match(m_callbacks.find(m_current.marker));
-    if (match != m_callbacks.end()) {
-        const CallbackList& callbacks = match->second;
-        const size_t nCallbacks = callbacks.size();
-        for (size_t i(0); i < nCallbacks; ++i)
-            if (callbacks[i]() == ParseSuspend)
-                return ParseSuspend;
-    }
+    const CallbackList& callbacks = m_callbacks[m_current.marker];
+    const size_t nCallbacks = callbacks.size();
+    for (size_t i(0); i < nCallbacks; ++i)
+        if (callbacks[i]() == ParseSuspend)
+            return ParseSuspend;
     return ParseContinue;
 }
 
@@ -312,28 +337,33 @@ bool Parser::nextMarker()
     if (m_input.getRemainingBitsCount() == 0)
         return false;
 
-    const uint8_t* const end = m_data + m_size - 1;
-    const uint8_t* const start = m_data + currentBytePosition();
-    const uint8_t* current = start;
-    const uint8_t* match;
+    const uint8_t* const end = m_data + m_size;
+    const uint8_t* const match = YamiMediaCodec::findJpegMarker(
+        m_data + currentBytePosition(), end);
 
-    do {
-        match = std::find(current, end, 0xFF);
-        if (match == end) {
-            skipBytes(std::distance(start, match) + 1);
-            return false;
+    if (match == end) {
+        if (m_inEntropyData) {
+            RestartInterval& last = m_restartIntervals.back();
+            last.size = m_size - last.offset;
+            m_inEntropyData = false;
         }
-        if (*(match + 1) < 0xFF && *(match + 1) >= M_SOF0)
-            break;
-        current = match + 1;
-    } while (true);
+        seek(m_size);
+        return false;
+    }
 
-    skipBytes(std::distance(start, match) + 1);
+    seek(std::distance(m_data, match) + 1);
 
     m_current.marker = static_cast<Marker>(m_input.read(8));
     m_current.position = currentBytePosition() - 1;
     m_current.length = 0; // set by marker parse routines when appropriate
 
+    if (m_inEntropyData) {
+        // any marker ends the restart interval, only RSTn starts a new one
+        RestartInterval& last = m_restartIntervals.back();
+        last.size = m_current.position - 1 - last.offset;
+        m_inEntropyData = false;
+    }
+
     return true;
 }
 
@@ -430,7 +460,6 @@ bool Parser::parse()
             parseSegment = parseAPP();
             break;
 
-        case M_COM:
         case M_RST0:
         case M_RST1:
         case M_RST2:
@@ -439,6 +468,10 @@ bool Parser::parse()
         case M_RST5:
         case M_RST6:
         case M_RST7:
+            parseSegment = parseRST();
+            break;
+
+        case M_COM:
             parseSegment = true;
             break;
 
@@ -637,6 +670,23 @@ bool Parser::parseSOS()
 
     m_sawSOS = true;
 
+    // the entropy coded data starts right after the header
+    m_restartIntervals.clear();
+    m_restartIntervals.push_back(RestartInterval(currentBytePosition()));
+    m_inEntropyData = true;
+
+    return true;
+}
+
+bool Parser::parseRST()
+{
+    // a RSTn out of the entropy coded data has nothing to restart, skip it
+    if (m_restartIntervals.empty())
+        return true;
+
+    m_restartIntervals.push_back(RestartInterval(currentBytePosition()));
+    m_inEntropyData = true;
+
     return true;
 }
 
@@ -748,7 +798,7 @@ bool Parser::parseDHT()
         INPUT_BYTE(index, return false);
 
         long count = 0;
-        std::vector<uint8_t> codes(16, 0);
+        uint8_t codes[16];
         for (size_t i(0); i < 16; ++i) {
             INPUT_BYTE(codes[i], return false);
             count += codes[i];
@@ -761,7 +811,19 @@ bool Parser::parseDHT()
             return false;
         }
 
-        std::vector<uint8_t> huffval(256, 0);
+        // more codes of a length than the code space left for them,
+        // or a code of all ones
+        long code = 0;
+        for (size_t i(0); i < 16; ++i) {
+            code += codes[i];
+            if (code >= (1L << (i + 1))) {
+                ERROR("Bad Huff Table");
+                return false;
+            }
+            code <<= 1;
+        }
+
+        uint8_t huffval[256] = { 0 };
         for (long i(0); i < count; ++i)
             INPUT_BYTE(huffval[i], return false);
 
@@ -784,9 +846,9 @@ bool Parser::parseDHT()
         if (!huffTable)
             huffTable.reset(new HuffTable);
 
-        std::memcpy(&huffTable->codes[0], &codes[0],
+        std::memcpy(&huffTable->codes[0], codes,
                     sizeof(huffTable->codes));
-        std::memcpy(&huffTable->values[0], &huffval[0],
+        std::memcpy(&huffTable->values[0], huffval,
                     sizeof(huffTable->values));
     }
 
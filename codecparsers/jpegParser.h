@@ -42,7 +42,6 @@
 #include "interface/VideoCommonDefs.h"
 
 // system headers
-#include <map>
 #include <vector>
 
 namespace YamiParser {
@@ -115,6 +114,19 @@ struct Segment {
     uint32_t length;
 };
 
+/**
+ * The entropy coded data between two RSTn markers.  It can be decoded on its
+ * own, the DC predictions are reset at every restart.
+ */
+struct RestartInterval {
+    RestartInterval(uint32_t o) : offset(o), size(0) { }
+
+    uint32_t offset; // from the start of the data
+    uint32_t size; // without the RSTn marker that ends it
+};
+
+typedef std::vector<RestartInterval> RestartIntervals;
+
 struct FrameHeader {
     typedef std::shared_ptr<FrameHeader> Shared;
 
@@ -175,12 +187,22 @@ public:
 
     typedef std::function<CallbackResult (void)> Callback;
     typedef std::vector<Callback> CallbackList;
-    typedef std::map<enum Marker, CallbackList> Callbacks;
+    // indexed by the marker code, most entries stay empty
+    typedef std::array<CallbackList, 256> Callbacks;
 
     Parser(const uint8_t* data, uint32_t size);
 
     virtual ~Parser() { }
 
+    /**
+     * Start over on new JPEG byte data, e.g. the next frame of a MJPEG
+     * stream.  Registered callbacks are kept.  The quantization, huffman and
+     * arithmetic conditioning tables are kept too, like a decoder keeps the
+     * tables of an abbreviated table specification, and are overwritten in
+     * place when the new data defines them again.
+     */
+    void reset(const uint8_t* data, uint32_t size);
+
     /**
      * Parses the JPEG byte data.  Notifies registered callbacks after each
      * successfully parsed JPEG segment Marker.  If a registered Callback
@@ -216,13 +238,27 @@ public:
     const HuffTables& acHuffTables() const { return m_acHuffTables; }
     unsigned restartInterval() const { return m_restartInterval; }
 
+    /**
+     * @return the entropy coded data of the most current scan, split at the
+     * RSTn markers.  It is complete once the marker after the scan is parsed,
+     * e.g. in the EOI Callback.
+     */
+    const RestartIntervals& restartIntervals() const
+    {
+        return m_restartIntervals;
+    }
+
 private:
     friend class JPEGParserTest;
 
     bool firstMarker();
     bool nextMarker();
     bool skipBytes(const uint32_t);
-    uint32_t currentBytePosition() const { return m_input.getPos() >> 3; }
+    void seek(uint32_t);
+    uint32_t currentBytePosition() const
+    {
+        return m_inputOffset + (m_input.getPos() >> 3);
+    }
     CallbackResult notifyCallbacks() const;
 
     bool parseSOI();
@@ -234,8 +270,11 @@ private:
     bool parseDQT();
     bool parseDHT();
     bool parseDRI();
+    bool parseRST();
 
     BitReader m_input;
+    // m_input starts at this byte of m_data
+    uint32_t m_inputOffset;
 
     const uint8_t* m_data;
     uint32_t m_size;
@@ -259,6 +298,9 @@ private:
     bool m_sawSOS;
 
     unsigned m_restartInterval;
+    RestartIntervals m_restartIntervals;
+    // the last restart interval is not ended by a marker yet
+    bool m_inEntropyData;
 };
 
 } // namespace JPEG
@@ -223,7 +223,8 @@ JPEG_PARSER_TEST(Construct_Defaults)
     EXPECT_EQ(m_arithDCU(parser).size(), NUM_ARITH_TBLS);
     EXPECT_EQ(m_arithACK(parser).size(), NUM_ARITH_TBLS);
 
-    EXPECT_EQ(m_callbacks(parser).size(), 0u);
+    for (size_t i(0); i < m_callbacks(parser).size(); ++i)
+        EXPECT_TRUE(m_callbacks(parser)[i].empty());
 
     EXPECT_FALSE(m_sawSOI(parser));
     EXPECT_FALSE(m_sawEOI(parser));
@@ -424,6 +425,27 @@ JPEG_PARSER_TEST(ParseSOS)
     EXPECT_EQ(m_scanHeader(parser)->al, 0x6);
 }
 
+// g_SimpleJPEG with a DRI before the SOS and entropy coded data split by
+// RSTn markers, with stuffed and fill bytes in it.
+static std::vector<uint8_t> restartJPEG(bool withEOI)
+{
+    static const uint8_t dri[] = { 0xff, 0xdd, 0x00, 0x04, 0x00, 0x01 };
+    static const uint8_t data[] = {
+        0x12, 0xff, 0x00, 0x34, 0xff, 0xd0,
+        0x56, 0xff, 0xff, 0xd1,
+        0xff, 0x00, 0xff, 0x00, 0x78, 0x9a
+    };
+    static const uint8_t eoi[] = { 0xff, 0xd9 };
+
+    std::vector<uint8_t> jpeg(&g_SimpleJPEG[0], &g_SimpleJPEG[609]);
+    jpeg.insert(jpeg.end(), dri, dri + sizeof(dri));
+    jpeg.insert(jpeg.end(), &g_SimpleJPEG[609], &g_SimpleJPEG[623]);
+    jpeg.insert(jpeg.end(), data, data + sizeof(data));
+    if (withEOI)
+        jpeg.insert(jpeg.end(), eoi, eoi + sizeof(eoi));
+    return jpeg;
+}
+
 JPEG_PARSER_TEST(Parse_Simple)
 {
     Parser parser(&g_SimpleJPEG[0], g_SimpleJPEG.size());
@@ -515,6 +537,41 @@ JPEG_PARSER_TEST(Parse_SimpleWithCallbacks)
     ASSERT_FALSE(HasFailure());
 }
 
+JPEG_PARSER_TEST(Parse_Reset)
+{
+    const std::vector<uint8_t> restart(restartJPEG(true));
+    Parser parser(&restart[0], restart.size());
+    Results results;
+
+    parser.registerCallback(M_EOI,
+        std::bind(&simpleCallback, std::ref(results), std::ref(parser)));
+
+    EXPECT_TRUE(parser.parse());
+    EXPECT_EQ(1u, parser.restartInterval());
+    const QuantTable::Shared quantTable(parser.quantTables()[0]);
+    const HuffTable::Shared huffTable(parser.acHuffTables()[1]);
+
+    parser.reset(&g_SimpleJPEG[0], g_SimpleJPEG.size());
+
+    EXPECT_FALSE(m_sawSOI(parser));
+    EXPECT_FALSE(m_sawSOS(parser));
+    EXPECT_FALSE(m_sawEOI(parser));
+    EXPECT_TRUE(m_frameHeader(parser).get() == NULL);
+    EXPECT_TRUE(m_scanHeader(parser).get() == NULL);
+    EXPECT_TRUE(parser.restartIntervals().empty());
+
+    EXPECT_TRUE(parser.parse());
+
+    // tables are reused, callbacks are kept
+    EXPECT_EQ(quantTable, parser.quantTables()[0]);
+    EXPECT_EQ(huffTable, parser.acHuffTables()[1]);
+    ASSERT_EQ(2u, results[M_EOI].size());
+    EXPECT_EQ(843u, results[M_EOI][1].position);
+
+    checkSimpleJPEG(parser);
+    ASSERT_FALSE(HasFailure());
+}
+
 JPEG_PARSER_TEST(Parse_SimpleTruncated)
 {
     const size_t size(g_SimpleJPEG.size());
@@ -536,5 +593,55 @@ JPEG_PARSER_TEST(Parse_SimpleTruncated)
     }
 }
 
+JPEG_PARSER_TEST(Parse_OverSubscribedDHT)
+{
+    std::vector<uint8_t> jpeg(g_SimpleJPEG.begin(), g_SimpleJPEG.end());
+
+    // three codes of length 1, same number of values
+    ASSERT_EQ(M_DHT, jpeg[178]);
+    jpeg[182] = 3;
+    jpeg[183] = 0;
+    jpeg[184] = 3;
+
+    Parser parser(&jpeg[0], jpeg.size());
+
+    EXPECT_FALSE(parser.parse());
+}
+
+JPEG_PARSER_TEST(Parse_RestartIntervals)
+{
+    const std::vector<uint8_t> jpeg(restartJPEG(true));
+    Parser parser(&jpeg[0], jpeg.size());
+
+    EXPECT_TRUE(parser.parse());
+
+    EXPECT_EQ(1u, parser.restartInterval());
+    EXPECT_EQ(M_EOI, m_current(parser).marker);
+    EXPECT_TRUE(m_input(parser).end());
+
+    const RestartIntervals& intervals = parser.restartIntervals();
+    ASSERT_EQ(3u, intervals.size());
+    EXPECT_EQ(629u, intervals[0].offset);
+    EXPECT_EQ(4u, intervals[0].size);
+    EXPECT_EQ(635u, intervals[1].offset);
+    // a fill byte before the marker is left in the interval
+    EXPECT_EQ(2u, intervals[1].size);
+    EXPECT_EQ(639u, intervals[2].offset);
+    EXPECT_EQ(6u, intervals[2].size);
+}
+
+JPEG_PARSER_TEST(Parse_RestartIntervalsNoEOI)
+{
+    const std::vector<uint8_t> jpeg(restartJPEG(false));
+    Parser parser(&jpeg[0], jpeg.size());
+
+    EXPECT_TRUE(parser.parse());
+
+    const RestartIntervals& intervals = parser.restartIntervals();
+    ASSERT_EQ(3u, intervals.size());
+    EXPECT_EQ(639u, intervals[2].offset);
+    EXPECT_EQ(jpeg.size() - 639u, intervals[2].size);
+}
+
 } // namespace JPEG
 } // namespace YamiParser
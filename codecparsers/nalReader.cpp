@@ -20,6 +20,7 @@
 
 #include <assert.h>
 #include "nalReader.h"
+#include "common/bytescan.h"
 
 namespace YamiParser {
 
@@ -31,40 +32,91 @@ uint32_t getHalfCeil(uint32_t n)
 
 NalReader::NalReader(const uint8_t *pdata, uint32_t size)
     : BitReader(pdata, size)
+    , m_nextEpb(0)
+    , m_scanned(0)
 {
 }
 
-inline bool NalReader::isEmulationBytes(const uint8_t *p) const
+/*scan in small chunks as the reads get there, most users only read the
+  headers at the start of a big nal*/
+static const uint32_t EPB_SCAN_CHUNK = 128;
+
+void NalReader::findNextEmulationByte(uint32_t from, uint32_t need) const
 {
-    return *p == 0x03
-            && (p - m_stream) >= 2
-            && *(p - 1) == 0x00 && *(p - 2) == 0x00;
+    /*an emulation prevention byte is the 0x03 in 0x00 0x00 0x03*/
+    const uint32_t prefix = 2;
+    const uint32_t limit = std::min(m_size, std::max(need, from + EPB_SCAN_CHUNK));
+    const uint8_t* pEnd = m_stream + limit;
+    const uint8_t* start = m_stream + std::max(from, prefix) - prefix;
+    const uint8_t* p = YamiMediaCodec::findZeroZeroByte(start, pEnd, 0x03);
+    if (p == pEnd) {
+        m_nextEpb = m_scanned = limit;
+    } else {
+        m_nextEpb = (p - m_stream) + prefix;
+        m_scanned = m_nextEpb + 1;
+    }
 }
 
-void NalReader::loadDataToCache(uint32_t nbytes)
+/*offset must not go backwards between calls*/
+bool NalReader::isEmulationByte(uint32_t offset) const
 {
+    if (offset == m_scanned)
+        findNextEmulationByte(offset, offset + 1);
+    if (offset != m_nextEpb)
+        return false;
+    m_nextEpb = m_scanned = offset + 1;
+    return true;
+}
+
+void NalReader::loadDataToCache(uint32_t nbytes) const
+{
+    uint32_t need = m_loadBytes + nbytes;
+    if (need > m_nextEpb && m_nextEpb == m_scanned)
+        findNextEmulationByte(m_scanned, need);
+
+    /*no emulation prevention byte in this block, load it directly*/
+    if (need <= m_nextEpb) {
+        BitReader::loadDataToCache(nbytes);
+        return;
+    }
+
     const uint8_t *pStart = m_stream + m_loadBytes;
     const uint8_t *p;
     const uint8_t *pEnd = m_stream + m_size;
-    /*the numbers of emulation prevention three byte in current load block*/
 
-    unsigned long int tmp = 0;
+    uint64_t tmp = 0;
     uint32_t size = 0;
     for (p = pStart; p < pEnd && size < nbytes; p++) {
-        if(!isEmulationBytes(p)) {
-            tmp <<= 8;
-            tmp |= *p;
+        if (!isEmulationByte(p - m_stream)) {
+            tmp |= (uint64_t)*p << ((CACHEBYTES - 1 - size) << 3);
             size++;
         }
     }
-    m_cache = tmp;
+    m_cache |= tmp >> m_bitsInCache;
     m_loadBytes += p - pStart;
-    m_bitsInCache = size << 3;
+    m_bitsInCache += size << 3;
 }
 
-/*according to 9.1 of h264 spec*/
 bool NalReader::readUe(uint32_t& v)
 {
+    /*fast path, the whole codeword is in cache.
+      m_cache is msb first with unused bits zeroed, so counting its leading
+      zeros gives the prefix length as long as a 1 bit is cached*/
+    if (m_bitsInCache < MAX_READ_BITS)
+        reload();
+    if (m_cache) {
+        uint32_t leadingZeroBits = __builtin_clzll(m_cache);
+        uint32_t codeLen = (leadingZeroBits << 1) + 1;
+        if (codeLen <= MAX_READ_BITS && codeLen <= m_bitsInCache) {
+            uint64_t code;
+            read(code, codeLen);
+            /*code is 1 followed by the leadingZeroBits bits suffix*/
+            v = code - 1;
+            return true;
+        }
+    }
+
+    /*slow path, for long codes and codes straddling the end of data*/
     int32_t leadingZeroBits = -1;
 
     for (uint32_t b = 0; !b; leadingZeroBits++) {
@@ -106,27 +158,21 @@ int32_t NalReader::readSe()
 
 bool NalReader::moreRbspData() const
 {
-    BitReader tmp(*this);
-    uint32_t remainingBits = (m_size << 3) - ((m_loadBytes << 3) - m_bitsInCache);
-    if(remainingBits == 0)
+    reload();
+    if (!m_bitsInCache)
         return false;
 
-    /* If next bit is equal to 0, that means there is more data in RBSP before the
-     * rbsp_trailing_bits() syntax structure.
-     * If next bit is equal to 1 and existing another one bit equal to 1 in the
-     * remaining bits means more data, otherwise means no more data.
+    /* The last bit equal to 1 in the nal is rbsp_stop_one_bit. If it is not
+     * loaded yet, there is more data in RBSP before the rbsp_trailing_bits()
+     * syntax structure. Otherwise it is in the cache, and there is no more
+     * data only when it is the next bit.
      */
-    uint8_t nextBit = tmp.read(1);
-    if(nextBit == 0)
+    const uint8_t* p = m_stream + m_size;
+    while (p > m_stream + m_loadBytes && !*(p - 1))
+        p--;
+    if (p > m_stream + m_loadBytes)
         return true;
-
-    while(--remainingBits) {
-        nextBit = tmp.read(1);
-        if(nextBit)
-            return true;
-    }
-
-    return false;
+    return m_cache != (uint64_t)1 << ((CACHEBYTES << 3) - 1);
 }
 
 void NalReader::rbspTrailingBits()
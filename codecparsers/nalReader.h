@@ -40,8 +40,15 @@ public:
     bool moreRbspData() const;
     void rbspTrailingBits();
 private:
-    void loadDataToCache(uint32_t nbytes);
-    inline bool isEmulationBytes(const uint8_t *p) const;
+    void loadDataToCache(uint32_t nbytes) const;
+    void findNextEmulationByte(uint32_t from, uint32_t need) const;
+    bool isEmulationByte(uint32_t offset) const;
+
+    /*bytes before m_nextEpb are not emulation prevention bytes and can be
+      loaded directly. if m_nextEpb < m_scanned, it is an emulation prevention
+      byte, otherwise nothing from m_scanned on has been scanned yet*/
+    mutable uint32_t m_nextEpb;
+    mutable uint32_t m_scanned;
 };
 
 bool NalReader::readUe(uint8_t& v)
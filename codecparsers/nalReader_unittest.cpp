@@ -24,6 +24,9 @@
 // library headers
 #include "common/unittest.h"
 
+// system headers
+#include <vector>
+
 namespace YamiParser {
 
 class NalReaderTest
@@ -113,4 +116,143 @@ NALREADER_TEST(GetPosForEPB)
     EXPECT_EQ(1u, b);
 }
 
+NALREADER_TEST(ReadExpGolomb)
+{
+    //ue(v) codes of all lengths, back to back so they straddle cache refills
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 32; i++) {
+        values.push_back((1u << i) - 1);
+        values.push_back(i * 3);
+        if (i)
+            values.push_back((1u << i) + i);
+    }
+    values.push_back(0xfffffffe);
+
+    std::vector<uint8_t> rbsp;
+    uint32_t bits = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t code = (uint64_t)values[i] + 1;
+        uint32_t len = 0;
+        while (code >> (len + 1))
+            len++;
+        //len zeros, then the len + 1 bits of code
+        for (int32_t b = len * 2; b >= 0; b--, bits++) {
+            if (!(bits & 7))
+                rbsp.push_back(0);
+            if ((b <= (int32_t)len) && ((code >> b) & 1))
+                rbsp.back() |= 0x80 >> (bits & 7);
+        }
+    }
+
+    //the long prefixes need emulation prevention
+    std::vector<uint8_t> data;
+    uint32_t zeros = 0;
+    for (size_t i = 0; i < rbsp.size(); i++) {
+        if (zeros == 2 && rbsp[i] <= 3) {
+            data.push_back(0x03);
+            zeros = 0;
+        }
+        data.push_back(rbsp[i]);
+        zeros = rbsp[i] ? 0 : zeros + 1;
+    }
+
+    NalReader r(&data[0], data.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        uint32_t v;
+        ASSERT_TRUE(r.readUe(v));
+        EXPECT_EQ(values[i], v);
+    }
+    EXPECT_EQ(bits, r.getPos());
+}
+
+NALREADER_TEST(ReadExpGolombAtEnd)
+{
+    //0b00100 = 3, 0b011 = -1 as se(v), 0b1 = 0
+    const uint8_t data[] = { 0x23, 0x80 };
+    NalReader r(data, sizeof(data));
+    uint32_t u;
+    int32_t s;
+    EXPECT_TRUE(r.readUe(u));
+    EXPECT_EQ(3u, u);
+    EXPECT_TRUE(r.readSe(s));
+    EXPECT_EQ(-1, s);
+    EXPECT_TRUE(r.readUe(u));
+    EXPECT_EQ(0u, u);
+    //7 zero bits, no prefix terminator
+    EXPECT_FALSE(r.readUe(u));
+    EXPECT_TRUE(r.end());
+}
+
+NALREADER_TEST(PeekSkipsEPB)
+{
+    const uint8_t data[] = {
+        0x0, 0x0, 0x3, 0x1,
+        0x80
+    };
+    NalReader r(data, sizeof(data));
+    EXPECT_EQ(0x00000180u, r.peek(32));
+    EXPECT_EQ(0u, r.getPos());
+    EXPECT_TRUE(r.moreRbspData());
+    r.skip(24);
+    EXPECT_FALSE(r.moreRbspData());
+    EXPECT_EQ(0x80u, r.read(8));
+}
+
+static void checkReadAll(const std::vector<uint8_t>& nal, const std::vector<uint8_t>& rbsp)
+{
+    NalReader r(&nal[0], nal.size());
+    BitReader expected(&rbsp[0], rbsp.size());
+    for (uint32_t nbits = 1; !expected.end(); nbits = nbits % 32 + 1) {
+        uint32_t u, v;
+        if (!expected.read(u, nbits)) {
+            EXPECT_FALSE(r.read(v, nbits));
+            break;
+        }
+        ASSERT_TRUE(r.read(v, nbits));
+        EXPECT_EQ(u, v);
+        EXPECT_EQ(expected.getPos(), r.getPos());
+    }
+    EXPECT_TRUE(r.end());
+}
+
+NALREADER_TEST(ReadAcrossEPB)
+{
+    //emulation prevention bytes at every offset of the cache block
+    std::vector<uint8_t> nal, rbsp;
+    for (uint32_t i = 0; i < 200; i++) {
+        uint8_t v = i * 37 + 1;
+        nal.push_back(v);
+        rbsp.push_back(v);
+        if (i % 7 == 3) {
+            nal.push_back(0x00);
+            nal.push_back(0x00);
+            nal.push_back(0x03);
+            rbsp.push_back(0x00);
+            rbsp.push_back(0x00);
+        }
+    }
+    checkReadAll(nal, rbsp);
+}
+
+NALREADER_TEST(ReadSparseEPB)
+{
+    //few emulation prevention bytes far apart, some straddle a scan chunk
+    for (uint32_t shift = 0; shift < 4; shift++) {
+        std::vector<uint8_t> nal, rbsp;
+        for (uint32_t i = 0; i < 1000; i++) {
+            uint8_t v = i * 37 + 1;
+            nal.push_back(v);
+            rbsp.push_back(v);
+            if (i == 124 + shift || i == 253 + shift || i == 900) {
+                nal.push_back(0x00);
+                nal.push_back(0x00);
+                nal.push_back(0x03);
+                rbsp.push_back(0x00);
+                rbsp.push_back(0x00);
+            }
+        }
+        checkReadAll(nal, rbsp);
+    }
+}
+
 } // namespace YamiParser
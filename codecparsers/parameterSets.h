@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef parameterSets_h
+#define parameterSets_h
+
+#include "VideoCommonDefs.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace YamiParser {
+
+/* parsed parameter sets (vps, sps or pps) indexed by id.
+ * It also remembers the bytes each one was parsed from, so a parameter set
+ * resent unchanged (before every idr in broadcast or rtsp streams) can be
+ * recognised by a hash and byte compare instead of being parsed again */
+template <class T, uint32_t N>
+class ParameterSets {
+public:
+    ParameterSets()
+        : m_hash()
+    {
+    }
+
+    SharedPtr<T> get(uint32_t id) const
+    {
+        if (id >= N)
+            return SharedPtr<T>();
+        return m_sets[id];
+    }
+
+    /* find the parameter set parsed from exactly the same bytes */
+    SharedPtr<T> find(const uint8_t* data, uint32_t size) const
+    {
+        uint32_t hash = calcHash(data, size);
+        for (size_t i = 0; i < m_ids.size(); i++) {
+            uint32_t id = m_ids[i];
+            const std::vector<uint8_t>& bytes = m_bytes[id];
+            if (m_hash[id] == hash && bytes.size() == size
+                && !memcmp(bytes.data(), data, size))
+                return m_sets[id];
+        }
+        return SharedPtr<T>();
+    }
+
+    void set(uint32_t id, const SharedPtr<T>& set, const uint8_t* data, uint32_t size)
+    {
+        if (id >= N)
+            return;
+        if (!m_sets[id])
+            m_ids.push_back(id);
+        m_sets[id] = set;
+        m_hash[id] = calcHash(data, size);
+        m_bytes[id].assign(data, data + size);
+    }
+
+private:
+    /* FNV-1a */
+    static uint32_t calcHash(const uint8_t* data, uint32_t size)
+    {
+        uint32_t hash = 2166136261u;
+        for (uint32_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    SharedPtr<T> m_sets[N];
+    uint32_t m_hash[N];
+    std::vector<uint8_t> m_bytes[N];
+    /* ids in use, usually only a few of N */
+    std::vector<uint32_t> m_ids;
+};
+
+} /*namespace YamiParser*/
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "h264Parser.h"
+#include "h265Parser.h"
+
+#include "common/benchmark.h"
+#include "common/nalreader.h"
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+
+//slice header parse cost and allocations per slice, with a new header per
+//slice as the h264 and h265 decoders used to do, and with one reused header.
+//usage: sliceHeader_bench [-n loops] [-c 264|265] annexb file
+
+static const int DEFAULT_LOOPS = 20;
+
+static uint64_t allocations;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+typedef std::vector<std::pair<const uint8_t*, int32_t> > Nals;
+
+static uint32_t parseH264(const Nals& nals, bool reuse)
+{
+    using namespace YamiParser::H264;
+    Parser parser;
+    SharedPtr<SliceHeader> reused(new SliceHeader);
+    uint32_t slices = 0;
+    for (size_t i = 0; i < nals.size(); i++) {
+        NalUnit nalu;
+        if (!nalu.parseNalUnit(nals[i].first, nals[i].second))
+            continue;
+        uint8_t type = nalu.nal_unit_type;
+        if (type == NAL_SPS) {
+            SharedPtr<SPS> sps;
+            parser.parseSps(sps, &nalu);
+        }
+        else if (type == NAL_PPS) {
+            SharedPtr<PPS> pps;
+            parser.parsePps(pps, &nalu);
+        }
+        else if (NAL_SLICE_NONIDR <= type && type <= NAL_SLICE_IDR) {
+            SharedPtr<SliceHeader> slice = reused;
+            if (reuse) {
+                slice->reset();
+            }
+            else {
+                slice.reset(new SliceHeader);
+                *slice = SliceHeader();
+            }
+            if (slice->parseHeader(&parser, &nalu))
+                slices++;
+        }
+    }
+    return slices;
+}
+
+static uint32_t parseH265(const Nals& nals, bool reuse)
+{
+    using namespace YamiParser::H265;
+    Parser parser;
+    SharedPtr<SliceHeader> curr(new SliceHeader);
+    SharedPtr<SliceHeader> prev(new SliceHeader);
+    uint32_t slices = 0;
+    for (size_t i = 0; i < nals.size(); i++) {
+        NalUnit nalu;
+        if (!nalu.parseNaluHeader(nals[i].first, nals[i].second))
+            continue;
+        uint8_t type = nalu.nal_unit_type;
+        if (type == NalUnit::VPS_NUT)
+            parser.parseVps(&nalu);
+        else if (type == NalUnit::SPS_NUT)
+            parser.parseSps(&nalu);
+        else if (type == NalUnit::PPS_NUT)
+            parser.parsePps(&nalu);
+        else if (type <= NalUnit::CRA_NUT) {
+            if (reuse)
+                curr->reset();
+            else
+                curr.reset(new SliceHeader);
+            if (!parser.parseSlice(&nalu, curr.get()))
+                continue;
+            slices++;
+            if (!curr->dependent_slice_segment_flag)
+                std::swap(curr, prev);
+        }
+    }
+    return slices;
+}
+
+static void run(const char* name, bool hevc, bool reuse, const Nals& nals, int loops)
+{
+    uint64_t slices = 0;
+    uint64_t before = allocations;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++)
+        slices += hevc ? parseH265(nals, reuse) : parseH264(nals, reuse);
+    t = benchNow() - t;
+    if (!slices) {
+        fprintf(stderr, "no slices\n");
+        return;
+    }
+    printf("%-8s %llu slices, %6.1f ns/slice, %.2f allocations/slice\n", name,
+        (unsigned long long)slices, t * 1e9 / slices,
+        (double)(allocations - before) / slices);
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    bool hevc = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+        switch (opt) {
+        case 'n':
+            loops = atoi(optarg);
+            break;
+        case 'c':
+            hevc = !strcmp(optarg, "265");
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n loops] [-c 264|265] annexb file\n", argv[0]);
+            return -1;
+        }
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+    if (optind == argc) {
+        fprintf(stderr, "usage: %s [-n loops] [-c 264|265] annexb file\n", argv[0]);
+        return -1;
+    }
+
+    std::vector<uint8_t> data;
+    if (!benchReadFile(argv[optind], data) || data.empty())
+        return -1;
+    Nals nals;
+    NalReader reader(&data[0], data.size());
+    const uint8_t* nal;
+    int32_t size;
+    while (reader.read(nal, size))
+        nals.push_back(std::make_pair(nal, size));
+
+    run("new", hevc, false, nals, loops);
+    run("reused", hevc, true, nals, loops);
+    return 0;
+}
@@ -21,6 +21,7 @@
 #include "vc1Parser.h"
 #include "common/log.h"
 #include "common/common_def.h"
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 
@@ -166,6 +167,228 @@ namespace VC1 {
         {0x7f, 7}
     };
 
+    /* writes one plane into BitPlanes::packed, values are inverted on the way */
+    class BitPlaneWriter {
+    public:
+        BitPlaneWriter(uint8_t* packed, uint32_t bit, uint32_t width, uint32_t height, uint8_t invert)
+            : m_packed(packed)
+            , m_bit(bit)
+            , m_width(width)
+            , m_height(height)
+            , m_invert(invert)
+        {
+        }
+        uint32_t width() const { return m_width; }
+        uint32_t height() const { return m_height; }
+
+        void set(uint32_t x, uint32_t y, uint32_t v)
+        {
+            uint32_t i = y * m_width + x;
+            m_packed[i >> 1] |= (v ^ m_invert) << shift(i);
+        }
+        uint32_t get(uint32_t x, uint32_t y) const
+        {
+            uint32_t i = y * m_width + x;
+            return (m_packed[i >> 1] >> shift(i)) & 1;
+        }
+        void flip(uint32_t x, uint32_t y, uint32_t v)
+        {
+            uint32_t i = y * m_width + x;
+            m_packed[i >> 1] ^= v << shift(i);
+        }
+        void clear()
+        {
+            const uint8_t mask = ~((1 << m_bit) | (1 << (m_bit + 4)));
+            for (uint32_t i = 0; i < (m_width * m_height + 1) >> 1; i++)
+                m_packed[i] &= mask;
+        }
+
+    private:
+        uint32_t shift(uint32_t i) const { return m_bit + ((~i & 1) << 2); }
+
+        uint8_t* m_packed;
+        uint32_t m_bit;
+        uint32_t m_width;
+        uint32_t m_height;
+        uint8_t m_invert;
+    };
+
+    /* peek nbits, zero padded after the end of data */
+    static uint32_t peekPadded(BitReader* br, uint32_t nbits)
+    {
+        uint64_t left = br->getRemainingBitsCount();
+        if (left >= nbits)
+            return br->peek(nbits);
+        return br->peek(left) << (nbits - left);
+    }
+
+    /* Table 80: Norm-2/Diff-2 Code Table, indexed by the next 3 bits,
+     * length << 2 | first << 1 | second */
+    static const uint8_t Norm2Lookup[8] = {
+        1 << 2, 1 << 2, 1 << 2, 1 << 2,
+        3 << 2 | 2, 3 << 2 | 1, 2 << 2 | 3, 2 << 2 | 3
+    };
+
+    /* Table 81 turned into a lookup on the next NORM6_BITS bits,
+     * length << 8 | value, 0 for invalid codes */
+#define NORM6_BITS 13
+    struct Norm6Lookup {
+        uint16_t entries[1 << NORM6_BITS];
+        Norm6Lookup()
+        {
+            memset(entries, 0, sizeof(entries));
+            for (uint32_t v = 0; v < N_ELEMENTS(Norm6VLCTable); v++) {
+                const VLCTable& code = Norm6VLCTable[v];
+                uint32_t unused = NORM6_BITS - code.codeLength;
+                uint32_t first = code.codeWord << unused;
+                for (uint32_t i = 0; i < (1u << unused); i++)
+                    entries[first + i] = code.codeLength << 8 | v;
+            }
+        }
+    };
+
+    static const Norm6Lookup& norm6Lookup()
+    {
+        static const Norm6Lookup lookup;
+        return lookup;
+    }
+
+    /* 8.7.3.6 Row-skip mode*/
+    static bool decodeRowskipMode(BitReader* br, BitPlaneWriter& plane,
+        uint32_t x0, uint32_t y0, uint32_t width, uint32_t height)
+    {
+        for (uint32_t y = y0; y < y0 + height; y++) {
+            bool rowSkip;
+            READ(rowSkip);
+            if (rowSkip) {
+                for (uint32_t x = 0; x < width;) {
+                    uint32_t n = std::min(width - x, 24u), bits;
+                    READ_BITS(bits, n);
+                    while (n--)
+                        plane.set(x0 + x++, y, (bits >> n) & 1);
+                }
+            }
+            else {
+                for (uint32_t x = 0; x < width; x++)
+                    plane.set(x0 + x, y, 0);
+            }
+        }
+        return true;
+    }
+
+    /* 8.7.3.7 Column-skip mode*/
+    static bool decodeColskipMode(BitReader* br, BitPlaneWriter& plane,
+        uint32_t x0, uint32_t y0, uint32_t width, uint32_t height)
+    {
+        for (uint32_t x = x0; x < x0 + width; x++) {
+            bool columnSkip;
+            READ(columnSkip);
+            if (columnSkip) {
+                for (uint32_t y = 0; y < height;) {
+                    uint32_t n = std::min(height - y, 24u), bits;
+                    READ_BITS(bits, n);
+                    while (n--)
+                        plane.set(x, y0 + y++, (bits >> n) & 1);
+                }
+            }
+            else {
+                for (uint32_t y = 0; y < height; y++)
+                    plane.set(x, y0 + y, 0);
+            }
+        }
+        return true;
+    }
+
+    /* 8.7.3.4 Normal-2 mode, pairs of macroblocks in raster order */
+    static bool decodeNorm2Mode(BitReader* br, BitPlaneWriter& plane)
+    {
+        uint32_t width = plane.width();
+        uint32_t count = width * plane.height();
+        uint32_t i = 0;
+        if (count & 1) {
+            uint32_t v;
+            READ_BITS(v, 1);
+            plane.set(0, 0, v);
+            i++;
+        }
+        for (; i < count; i += 2) {
+            uint8_t code = Norm2Lookup[peekPadded(br, 3)];
+            SKIP(code >> 2);
+            plane.set(i % width, i / width, (code >> 1) & 1);
+            plane.set((i + 1) % width, (i + 1) / width, code & 1);
+        }
+        return true;
+    }
+
+    static bool decodeNorm6Tile(BitReader* br, uint32_t& tile)
+    {
+        uint16_t entry = norm6Lookup().entries[peekPadded(br, NORM6_BITS)];
+        if (!entry) {
+            ERROR("invalid norm6 code");
+            return false;
+        }
+        SKIP(entry >> 8);
+        tile = entry & 0x3f;
+        return true;
+    }
+
+    /* 8.7.3.5 Normal-6 mode */
+    static bool decodeNorm6Mode(BitReader* br, BitPlaneWriter& plane)
+    {
+        uint32_t width = plane.width();
+        uint32_t height = plane.height();
+        uint32_t tile;
+        if ((width % 3) && !(height % 3)) {
+            /* 2x3 tiles, the columns left over on the left are column-skip coded */
+            for (uint32_t y = 0; y < height; y += 3) {
+                for (uint32_t x = width & 1; x < width; x += 2) {
+                    if (!decodeNorm6Tile(br, tile))
+                        return false;
+                    for (uint32_t k = 0; k < 6; k++)
+                        plane.set(x + (k & 1), y + (k >> 1), (tile >> k) & 1);
+                }
+            }
+            if (width & 1)
+                return decodeColskipMode(br, plane, 0, 0, 1, height);
+            return true;
+        }
+        /* 3x2 tiles, the columns on the left and the row on the top left over */
+        uint32_t cols = width % 3;
+        uint32_t rows = height & 1;
+        for (uint32_t y = rows; y < height; y += 2) {
+            for (uint32_t x = cols; x < width; x += 3) {
+                if (!decodeNorm6Tile(br, tile))
+                    return false;
+                for (uint32_t k = 0; k < 6; k++)
+                    plane.set(x + k % 3, y + k / 3, (tile >> k) & 1);
+            }
+        }
+        if (cols && !decodeColskipMode(br, plane, 0, 0, cols, height))
+            return false;
+        if (rows && !decodeRowskipMode(br, plane, cols, 0, width - cols, rows))
+            return false;
+        return true;
+    }
+
+    /* 8.7.3.8 Diff: Inverse differential decoding */
+    static void inverseDiff(BitPlaneWriter& plane, uint32_t invert)
+    {
+        for (uint32_t y = 0; y < plane.height(); y++) {
+            for (uint32_t x = 0; x < plane.width(); x++) {
+                uint32_t pred;
+                if (!x && !y)
+                    pred = invert;
+                else if (!x)
+                    pred = plane.get(0, y - 1);
+                else if (y && plane.get(x, y - 1) != plane.get(x - 1, y))
+                    pred = invert;
+                else
+                    pred = plane.get(x - 1, y);
+                plane.flip(x, y, pred);
+            }
+        }
+    }
+
     Parser::Parser()
     {
         memset(&m_seqHdr, 0, sizeof(m_seqHdr));
@@ -209,7 +432,7 @@ namespace VC1 {
         bool ret = false;
         m_mbWidth = (m_seqHdr.coded_width + 15) >> 4;
         m_mbHeight = (m_seqHdr.coded_height + 15) >> 4;
-        mallocBitPlanes();
+        resetBitPlanes();
         memset(&m_frameHdr, 0, sizeof(m_frameHdr));
         if (!convertToRbdu(data, size))
             return false;
@@ -431,23 +654,18 @@ namespace VC1 {
         br = &bitReader;
         READ_BITS(m_sliceHdr.slice_addr, 9);
         READ(temp);
-        if (temp)
+        if (temp) {
+            resetBitPlanes();
             ret = parseFrameHeaderAdvanced(&bitReader);
+        }
 
         m_sliceHdr.macroblock_offset = bitReader.getPos();
         return ret;
     }
 
-    void Parser::mallocBitPlanes()
+    void Parser::resetBitPlanes()
     {
-        uint32_t size = m_mbHeight * m_mbWidth;
-        m_bitPlanes.acpred.resize(size);
-        m_bitPlanes.fieldtx.resize(size);
-        m_bitPlanes.overflags.resize(size);
-        m_bitPlanes.mvtypemb.resize(size);
-        m_bitPlanes.skipmb.resize(size);
-        m_bitPlanes.directmb.resize(size);
-        m_bitPlanes.forwardmb.resize(size);
+        m_bitPlanes.packed.assign((m_mbHeight * m_mbWidth + 1) >> 1, 0);
     }
 
     bool Parser::decodeVLCTable(BitReader* br, uint16_t* out,
@@ -471,153 +689,9 @@ namespace VC1 {
         return (i < tableLen) ? true : false;
     }
 
-    /* 8.7.3.6 Row-skip mode*/
-    bool Parser::decodeRowskipMode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
-    {
-        uint32_t i, j;
-        for (j = 0; j < height; j++) {
-            bool rowSkip;
-            READ(rowSkip);
-            if (rowSkip) {
-                for (i = 0; i < width; i++)
-                    READ_BITS(data[i], 1);
-            }
-            else {
-                memset(data, 0, width);
-            }
-            data += m_mbWidth;
-        }
-        return true;
-    }
-
-    /* 8.7.3.7 Column-skip mode*/
-    bool Parser::decodeColskipMode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
-    {
-        uint32_t i, j;
-        for (i = 0; i < width; i++) {
-            bool columnSkip;
-            READ(columnSkip);
-            if (columnSkip) {
-                for (j = 0; j < height; j++)
-                    READ_BITS(data[j * m_mbWidth], 1);
-            }
-            else {
-                for (j = 0; j < height; j++)
-                    data[j * m_mbWidth] = 0;
-            }
-            data++;
-        }
-        return true;
-    }
-
-    /* Table 80: Norm-2/Diff-2 Code Table */
-    bool Parser::decodeNorm2Mode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
-    {
-        uint32_t i;
-        bool temp;
-        uint8_t* out = data;
-        if ((height * width) & 1) {
-            READ_BITS(*out, 1);
-            out++;
-        }
-        for (i = (height * width) & 1; i < height * width; i += 2) {
-            READ(temp);
-            if (temp == 0) {
-                *out++ = 0;
-                *out++ = 0;
-            }
-            else {
-                READ(temp);
-                if (temp) {
-                    *out++ = 1;
-                    *out++ = 1;
-                }
-                else {
-                    READ(temp);
-                    if (temp == 0) {
-                        *out++ = 1;
-                        *out++ = 0;
-                    }
-                    else {
-                        *out++ = 0;
-                        *out++ = 1;
-                    }
-                }
-            }
-        }
-        return true;
-    }
-
-    bool Parser::decodeNorm6Mode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
+    bool Parser::decodeBitPlane(BitReader* br, BitPlanes::Bit bit, bool* isRaw)
     {
-        uint32_t i = 0, j = 0;
-        uint16_t temp;
-        uint8_t* out = data;
-        bool is2x3Tiled = (((width % 3) != 0) && ((height % 3) == 0));
-        if (is2x3Tiled) {
-            for (j = 0; j < height; j += 3) {
-                for (i = width & 1; i < width; i += 2) {
-                    if (!decodeVLCTable(br, &temp, Norm6VLCTable, 64))
-                        return false;
-                    out[i] = temp & 1;
-                    out[i + 1] = (temp & 2) >> 1;
-                    out[i + width] = (temp & 4) >> 2;
-                    out[i + width + 1] = (temp & 8) >> 3;
-                    out[i + width * 2] = (temp & 16) >> 4;
-                    out[i + width * 2 + 1] = (temp & 32) >> 5;
-                }
-                out += 3 * width;
-            }
-            if (width & 1)
-                decodeColskipMode(br, data, width & 1, height);
-        }
-        else {
-            out += (height & 1) * width;
-            for (j = height & 1; j < height; j += 2) {
-                for (i = width % 3; i < width; i += 3) {
-                    if (!decodeVLCTable(br, &temp, Norm6VLCTable, 64))
-                        return false;
-                    out[i] = temp & 1;
-                    out[i + 1] = (temp & 2) >> 1;
-                    out[i + 2] = (temp & 4) >> 2;
-                    out[i + width] = (temp & 8) >> 3;
-                    out[i + width + 1] = (temp & 16) >> 4;
-                    out[i + width + 2] = (temp & 32) >> 5;
-                }
-                out += 2 * width;
-            }
-            if (width % 3)
-                decodeColskipMode(br, data, width % 3, height);
-            if (height & 1)
-                decodeRowskipMode(br, data + (width % 3), width - (width % 3), height & 1);
-        }
-        return true;
-    }
-
-    /* 8.7.3.8 Diff: Inverse differential decoding */
-    void Parser::inverseDiff(uint8_t* data, uint32_t width, uint32_t height, uint32_t invert)
-    {
-        uint32_t i, j;
-        for (j = 0; j < height; j++)
-            for (i = 0; i < width; i++) {
-                if ((i == 0) && (j == 0)) {
-                    data[j * width + i] ^= invert;
-                }
-                else if (i == 0) {
-                    data[j * width + i] ^= data[(j - 1) * width];
-                }
-                else if ((j > 0) && (data[(j - 1) * width + i] != data[j * width + i - 1])) {
-                    data[j * width + i] ^= invert;
-                }
-                else {
-                    data[j * width + i] ^= data[j * width + i - 1];
-                }
-            }
-    }
-
-    bool Parser::decodeBitPlane(BitReader* br, uint8_t* data, bool* isRaw)
-    {
-        uint32_t i, invert;
+        uint8_t invert;
         uint16_t mode;
         *isRaw = false;
         READ_BITS(invert, 1);
@@ -627,32 +701,24 @@ namespace VC1 {
             *isRaw = true;
             return true;
         }
-        else if (mode == IMODE_NORM2) {
-            decodeNorm2Mode(br, data, m_mbWidth, m_mbHeight);
-        }
-        else if (mode == IMODE_NORM6) {
-            decodeNorm6Mode(br, data, m_mbWidth, m_mbHeight);
-        }
-        else if (mode == IMODE_DIFF2) {
-            decodeNorm2Mode(br, data, m_mbWidth, m_mbHeight);
-            inverseDiff(data, m_mbWidth, m_mbHeight, invert);
-        }
-        else if (mode == IMODE_DIFF6) {
-            decodeNorm6Mode(br, data, m_mbWidth, m_mbHeight);
-            inverseDiff(data, m_mbWidth, m_mbHeight, invert);
-        }
-        else if (mode == IMODE_ROWSKIP) {
-            decodeRowskipMode(br, data, m_mbWidth, m_mbHeight);
-        }
-        else if (mode == IMODE_COLSKIP) {
-            decodeColskipMode(br, data, m_mbWidth, m_mbHeight);
-        }
-        /*8.7.1 INVERT*/
-        if ((mode != IMODE_DIFF2) && (mode != IMODE_DIFF6) && invert) {
-            for (i = 0; i < m_mbWidth * m_mbHeight; i++)
-                data[i] = !data[i];
-        }
-        return true;
+
+        /*8.7.1 INVERT, for the diff modes it is the predictor instead*/
+        bool diff = mode == IMODE_DIFF2 || mode == IMODE_DIFF6;
+        BitPlaneWriter plane(m_bitPlanes.packed.data(), bit, m_mbWidth, m_mbHeight, diff ? 0 : invert);
+        bool ret = false;
+        if (mode == IMODE_NORM2 || mode == IMODE_DIFF2)
+            ret = decodeNorm2Mode(br, plane);
+        else if (mode == IMODE_NORM6 || mode == IMODE_DIFF6)
+            ret = decodeNorm6Mode(br, plane);
+        else if (mode == IMODE_ROWSKIP)
+            ret = decodeRowskipMode(br, plane, 0, 0, m_mbWidth, m_mbHeight);
+        else if (mode == IMODE_COLSKIP)
+            ret = decodeColskipMode(br, plane, 0, 0, m_mbWidth, m_mbHeight);
+        if (ret && diff)
+            inverseDiff(plane, invert);
+        if (bit == BitPlanes::UNUSED)
+            plane.clear();
+        return ret;
     }
 
     /*Table 24: VOPDQUANT in picture header(Refer to 7.1.1.31)*/
@@ -847,10 +913,10 @@ namespace VC1 {
             if (m_frameHdr.mv_mode == MVMODE_MIXED_MV
                 || (m_frameHdr.mv_mode == MVMODE_INTENSITY_COMPENSATION
                        && m_frameHdr.mv_mode2 == MVMODE_MIXED_MV)) {
-                if (!decodeBitPlane(br, &m_bitPlanes.mvtypemb[0], &m_frameHdr.mv_type_mb))
+                if (!decodeBitPlane(br, BitPlanes::MVTYPEMB, &m_frameHdr.mv_type_mb))
                     return false;
             }
-            if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+            if (!decodeBitPlane(br, BitPlanes::SKIPMB, &m_frameHdr.skip_mb))
                 return false;
 
             READ_BITS(m_frameHdr.mv_table, 2);
@@ -869,9 +935,9 @@ namespace VC1 {
         else if (m_frameHdr.picture_type == FRAME_B) {
             READ_BITS(m_frameHdr.mv_mode, 1);
             m_frameHdr.mv_mode = !(m_frameHdr.mv_mode);
-            if (!decodeBitPlane(br, &m_bitPlanes.directmb[0], &m_frameHdr.direct_mb))
+            if (!decodeBitPlane(br, BitPlanes::DIRECTMB, &m_frameHdr.direct_mb))
                 return false;
-            if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+            if (!decodeBitPlane(br, BitPlanes::SKIPMB, &m_frameHdr.skip_mb))
                 return false;
             READ_BITS(m_frameHdr.mv_table, 2);
             READ_BITS(m_frameHdr.cbp_table, 2);
@@ -996,16 +1062,16 @@ namespace VC1 {
         if ((m_frameHdr.picture_type == FRAME_I)
             || (m_frameHdr.picture_type == FRAME_BI)) {
             if (m_frameHdr.fcm == FRAME_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.fieldtx[0], &m_frameHdr.fieldtx))
+                if (!decodeBitPlane(br, BitPlanes::UNUSED, &m_frameHdr.fieldtx))
                     return false;
             }
-            if (!decodeBitPlane(br, &m_bitPlanes.acpred[0], &m_frameHdr.ac_pred))
+            if (!decodeBitPlane(br, BitPlanes::ACPRED, &m_frameHdr.ac_pred))
                 return false;
 
             if ((m_entryPointHdr.overlap) && m_frameHdr.pquant <= 8) {
                 m_frameHdr.condover = getFirst01Bit(br, 0, 2);
                 if (m_frameHdr.condover == 2) {
-                    if (!decodeBitPlane(br, &m_bitPlanes.overflags[0], &m_frameHdr.overflags))
+                    if (!decodeBitPlane(br, BitPlanes::OVERFLAGS, &m_frameHdr.overflags))
                         return false;
                 }
             }
@@ -1057,14 +1123,14 @@ namespace VC1 {
                     if (m_frameHdr.mv_mode == MVMODE_MIXED_MV
                         || (m_frameHdr.mv_mode == MVMODE_INTENSITY_COMPENSATION
                                && m_frameHdr.mv_mode2 == MVMODE_MIXED_MV)) {
-                        if (!decodeBitPlane(br, &m_bitPlanes.mvtypemb[0], &m_frameHdr.mv_type_mb))
+                        if (!decodeBitPlane(br, BitPlanes::MVTYPEMB, &m_frameHdr.mv_type_mb))
                             return false;
                     }
                 }
             }
 
             if (m_frameHdr.fcm != FIELD_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+                if (!decodeBitPlane(br, BitPlanes::SKIPMB, &m_frameHdr.skip_mb))
                     return false;
             }
 
@@ -1111,13 +1177,13 @@ namespace VC1 {
                 m_frameHdr.mv_mode = !(m_frameHdr.mv_mode);
             }
             if (m_frameHdr.fcm == FIELD_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.forwardmb[0], &m_frameHdr.forwardmb))
+                if (!decodeBitPlane(br, BitPlanes::UNUSED, &m_frameHdr.forwardmb))
                     return false;
             }
             else {
-                if (!decodeBitPlane(br, &m_bitPlanes.directmb[0], &m_frameHdr.direct_mb))
+                if (!decodeBitPlane(br, BitPlanes::DIRECTMB, &m_frameHdr.direct_mb))
                     return false;
-                if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+                if (!decodeBitPlane(br, BitPlanes::SKIPMB, &m_frameHdr.skip_mb))
                     return false;
             }
             if (m_frameHdr.fcm != PROGRESSIVE) {
@@ -145,14 +145,21 @@ namespace VC1 {
         HrdParam hrd_param;
     };
 
+    /* bitplanes of a picture in the VABitPlaneBuffer layout: a nibble per
+     * macroblock in raster order, even macroblocks in the high nibble.
+     * Each decoded plane sets its bit of the nibble, raw coded planes
+     * are left 0 */
     struct BitPlanes {
-        std::vector<uint8_t> acpred;
-        std::vector<uint8_t> fieldtx;
-        std::vector<uint8_t> overflags;
-        std::vector<uint8_t> mvtypemb;
-        std::vector<uint8_t> skipmb;
-        std::vector<uint8_t> directmb;
-        std::vector<uint8_t> forwardmb;
+        enum Bit {
+            DIRECTMB = 0,
+            SKIPMB = 1,
+            ACPRED = 1,
+            MVTYPEMB = 2,
+            OVERFLAGS = 2,
+            /* fieldtx and forwardmb are not passed to va */
+            UNUSED = 3
+        };
+        std::vector<uint8_t> packed;
     };
 
     struct FrameHdr {
@@ -252,25 +259,22 @@ namespace VC1 {
         uint32_t m_mbHeight;
 
     private:
-        void mallocBitPlanes();
+        void resetBitPlanes();
         bool getRefDist(BitReader*, uint8_t& refDist);
         int32_t getFirst01Bit(BitReader*, bool, uint32_t);
         uint8_t getMVMode(BitReader*, uint8_t, bool);
         bool decodeBFraction(BitReader*);
         bool convertToRbdu(uint8_t*&, uint32_t&);
         bool decodeVLCTable(BitReader*, uint16_t*, const VLCTable*, uint32_t);
-        bool decodeRowskipMode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeColskipMode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeNorm2Mode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeNorm6Mode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeBitPlane(BitReader*, uint8_t*, bool*);
-        void inverseDiff(uint8_t*, uint32_t, uint32_t, uint32_t);
+        bool decodeBitPlane(BitReader*, BitPlanes::Bit, bool*);
         bool parseVopdquant(BitReader*, uint8_t);
         bool parseSequenceHeader(const uint8_t*, uint32_t);
         bool parseEntryPointHeader(const uint8_t*, uint32_t);
         bool parseFrameHeaderSimpleMain(BitReader*);
         bool parseFrameHeaderAdvanced(BitReader*);
         std::vector<uint8_t> m_rbdu;
+
+        friend class VC1ParserTest;
     };
 }
 }
@@ -21,9 +21,13 @@
 #include "vc1Parser.h"
 
 // library headers
+#include "bitWriter.h"
 #include "common/Array.h"
 #include "common/unittest.h"
 
+// system headers
+#include <algorithm>
+
 namespace YamiParser {
 namespace VC1 {
 
@@ -631,6 +635,20 @@ namespace VC1 {
             EXPECT_EQ(0x0, parser.m_frameHdr.intcompfield);
             EXPECT_EQ(0x14u, parser.m_frameHdr.macroblock_offset);
         }
+
+        /* decode one bitplane of width x height macroblocks from bits */
+        bool decodeBitPlane(Parser& parser, uint32_t width, uint32_t height,
+            BitWriter& bits, BitPlanes::Bit bit, bool& isRaw)
+        {
+            parser.m_mbWidth = width;
+            parser.m_mbHeight = height;
+            parser.resetBitPlanes();
+            //pad, so the reader never runs dry
+            bits.writeBits(0, 32);
+            bits.writeToBytesAligned();
+            BitReader br(bits.getBitWriterData(), bits.getCodedBitsCount() / 8);
+            return parser.decodeBitPlane(&br, bit, &isRaw);
+        }
     };
 
 #define VC1_PARSER_TEST(name) TEST_F(VC1ParserTest, name)
@@ -661,6 +679,127 @@ namespace VC1 {
         size = g_MainVC1.size();
         ASSERT_TRUE(parser.parseFrameHeader(data, size));
         checkParamsFrameHeader(parser);
+
+        //intra main profile frames have no coded bitplanes
+        const std::vector<uint8_t>& packed = parser.m_bitPlanes.packed;
+        EXPECT_EQ((parser.m_mbWidth * parser.m_mbHeight + 1) / 2, packed.size());
+        EXPECT_EQ(packed.size(), (size_t)std::count(packed.begin(), packed.end(), 0));
+    }
+
+    VC1_PARSER_TEST(BitPlaneNorm2)
+    {
+        Parser parser;
+        bool isRaw;
+        BitWriter bits;
+        //invert, imode norm2, odd macroblock, pair 0 1
+        bits.writeBits(0, 1);
+        bits.writeBits(2, 2);
+        bits.writeBits(1, 1);
+        bits.writeBits(5, 3);
+        ASSERT_TRUE(decodeBitPlane(parser, 3, 1, bits, BitPlanes::SKIPMB, isRaw));
+        EXPECT_FALSE(isRaw);
+        const uint8_t expected[] = { 0x20, 0x20 };
+        EXPECT_EQ(std::vector<uint8_t>(expected, expected + 2), parser.m_bitPlanes.packed);
+
+        BitWriter inverted;
+        inverted.writeBits(1, 1);
+        inverted.writeBits(2, 2);
+        inverted.writeBits(1, 1);
+        inverted.writeBits(5, 3);
+        ASSERT_TRUE(decodeBitPlane(parser, 3, 1, inverted, BitPlanes::SKIPMB, isRaw));
+        const uint8_t invertedExpected[] = { 0x02, 0x00 };
+        EXPECT_EQ(std::vector<uint8_t>(invertedExpected, invertedExpected + 2), parser.m_bitPlanes.packed);
+    }
+
+    VC1_PARSER_TEST(BitPlaneNorm6)
+    {
+        Parser parser;
+        bool isRaw;
+        //2x3 tiles, tile value 1
+        BitWriter tile2x3;
+        tile2x3.writeBits(0, 1);
+        tile2x3.writeBits(3, 2);
+        tile2x3.writeBits(2, 4);
+        ASSERT_TRUE(decodeBitPlane(parser, 2, 3, tile2x3, BitPlanes::DIRECTMB, isRaw));
+        const uint8_t expected2x3[] = { 0x10, 0x00, 0x00 };
+        EXPECT_EQ(std::vector<uint8_t>(expected2x3, expected2x3 + 3), parser.m_bitPlanes.packed);
+
+        //3x2 tiles below a row-skip coded row, tile value 4, row 1 0 1
+        BitWriter tile3x2;
+        tile3x2.writeBits(0, 1);
+        tile3x2.writeBits(3, 2);
+        tile3x2.writeBits(4, 4);
+        tile3x2.writeBits(1, 1);
+        tile3x2.writeBits(5, 3);
+        ASSERT_TRUE(decodeBitPlane(parser, 3, 3, tile3x2, BitPlanes::MVTYPEMB, isRaw));
+        const uint8_t expected3x2[] = { 0x40, 0x40, 0x04, 0x00, 0x00 };
+        EXPECT_EQ(std::vector<uint8_t>(expected3x2, expected3x2 + 5), parser.m_bitPlanes.packed);
+
+        BitWriter invalid;
+        invalid.writeBits(0, 1);
+        invalid.writeBits(3, 2);
+        invalid.writeBits(0x1e0, 13);
+        EXPECT_FALSE(decodeBitPlane(parser, 3, 2, invalid, BitPlanes::MVTYPEMB, isRaw));
+    }
+
+    VC1_PARSER_TEST(BitPlaneSkipModes)
+    {
+        Parser parser;
+        bool isRaw;
+        //row-skip, rows 1 1 and skipped
+        BitWriter rowskip;
+        rowskip.writeBits(0, 1);
+        rowskip.writeBits(2, 3);
+        rowskip.writeBits(7, 3);
+        rowskip.writeBits(0, 1);
+        ASSERT_TRUE(decodeBitPlane(parser, 2, 2, rowskip, BitPlanes::ACPRED, isRaw));
+        const uint8_t expectedRows[] = { 0x22, 0x00 };
+        EXPECT_EQ(std::vector<uint8_t>(expectedRows, expectedRows + 2), parser.m_bitPlanes.packed);
+
+        //column-skip, columns 1 1 and skipped
+        BitWriter colskip;
+        colskip.writeBits(0, 1);
+        colskip.writeBits(3, 3);
+        colskip.writeBits(7, 3);
+        colskip.writeBits(0, 1);
+        ASSERT_TRUE(decodeBitPlane(parser, 2, 2, colskip, BitPlanes::ACPRED, isRaw));
+        const uint8_t expectedCols[] = { 0x20, 0x20 };
+        EXPECT_EQ(std::vector<uint8_t>(expectedCols, expectedCols + 2), parser.m_bitPlanes.packed);
+    }
+
+    VC1_PARSER_TEST(BitPlaneDiff)
+    {
+        Parser parser;
+        bool isRaw;
+        //inverted diff-2, pair 0 0 predicts 1 1
+        BitWriter diff;
+        diff.writeBits(1, 1);
+        diff.writeBits(1, 3);
+        diff.writeBits(0, 1);
+        ASSERT_TRUE(decodeBitPlane(parser, 2, 1, diff, BitPlanes::DIRECTMB, isRaw));
+        EXPECT_EQ(std::vector<uint8_t>(1, 0x11), parser.m_bitPlanes.packed);
+    }
+
+    VC1_PARSER_TEST(BitPlaneRawAndUnused)
+    {
+        Parser parser;
+        bool isRaw;
+        BitWriter raw;
+        raw.writeBits(1, 1);
+        raw.writeBits(0, 4);
+        ASSERT_TRUE(decodeBitPlane(parser, 3, 3, raw, BitPlanes::SKIPMB, isRaw));
+        EXPECT_TRUE(isRaw);
+        EXPECT_EQ(std::vector<uint8_t>(5, 0), parser.m_bitPlanes.packed);
+
+        //planes va doesn't take are parsed, then dropped
+        BitWriter unused;
+        unused.writeBits(0, 1);
+        unused.writeBits(2, 3);
+        unused.writeBits(7, 3);
+        unused.writeBits(7, 3);
+        ASSERT_TRUE(decodeBitPlane(parser, 2, 2, unused, BitPlanes::UNUSED, isRaw));
+        EXPECT_FALSE(isRaw);
+        EXPECT_EQ(std::vector<uint8_t>(2, 0), parser.m_bitPlanes.packed);
     }
 
 } // namespace VC1
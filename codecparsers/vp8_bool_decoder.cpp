@@ -74,6 +74,7 @@
 #endif
 
 #include <algorithm>
+#include <string.h>
 
 #include "vp8_bool_decoder.h"
 
@@ -86,30 +87,20 @@ namespace YamiParser {
 
 static const int kDefaultProbability = 0x80;  // 0x80 / 256 = 0.5
 
-// This is meant to be a large, positive constant that can still be efficiently
-// loaded as an immediate (on platforms like ARM, for example). Even relatively
-// modest values like 100 would work fine.
-#define VP8_LOTS_OF_BITS (0x40000000)
-
-// The number of leading zeros.
-static const unsigned char kVp8Norm[256] = {
-    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4,
-    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-};
+#define VP8_LOTS_OF_BITS (Vp8BoolDecoder::kLotsOfBits)
+
+// A literal of up to this many bits is read from |value_| without refilling
+// in between, each bit at probability 1/2 consumes at most one bit.
+#define VP8_FAST_LITERAL_BITS (VP8_BD_VALUE_BIT - 16)
+
+static inline size_t LoadWordBE(const uint8_t* p) {
+  size_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  v = sizeof(v) == 8 ? __builtin_bswap64(v) : __builtin_bswap32(v);
+#endif
+  return v;
+}
 
 Vp8BoolDecoder::Vp8BoolDecoder()
     : user_buffer_(NULL),
@@ -135,6 +126,19 @@ void Vp8BoolDecoder::FillDecoder() {
   // DCHECK(user_buffer_ != NULL);
   int shift = VP8_BD_VALUE_BIT - CHAR_BIT - (count_ + CHAR_BIT);
   size_t bytes_left = user_buffer_end_ - user_buffer_;
+
+  if (bytes_left >= sizeof(size_t)) {
+    // all the whole bytes that fit below the bits still in |value_|
+    int bits = ((shift >> 3) + 1) * CHAR_BIT;
+    size_t word = LoadWordBE(user_buffer_);
+    if (bits < VP8_BD_VALUE_BIT)
+      word >>= VP8_BD_VALUE_BIT - bits;
+    value_ |= word << (shift + CHAR_BIT - bits);
+    count_ += bits;
+    user_buffer_ += bits / CHAR_BIT;
+    return;
+  }
+
   size_t bits_left = bytes_left * CHAR_BIT;
   int x = static_cast<int>(shift + CHAR_BIT - bits_left);
   int loop_end = 0;
@@ -154,41 +158,75 @@ void Vp8BoolDecoder::FillDecoder() {
   }
 }
 
-int Vp8BoolDecoder::ReadBit(int probability) {
+// ReadBit() on a copy of the decoder state that the caller keeps in
+// registers, |count| must be non-negative.
+static inline int DecodeBool(size_t& value, int& count, size_t& range,
+                             int probability) {
+  size_t split = 1 + (((range - 1) * probability) >> 8);
+  size_t bigsplit = split << (sizeof(value) * CHAR_BIT - 8);
   int bit = 0;
-  size_t split = 1 + (((range_ - 1) * probability) >> 8);
-  if (count_ < 0)
-    FillDecoder();
-  size_t bigsplit = static_cast<size_t>(split) << (VP8_BD_VALUE_BIT - 8);
-
-  if (value_ >= bigsplit) {
-    range_ -= split;
-    value_ -= bigsplit;
+  if (value >= bigsplit) {
+    range -= split;
+    value -= bigsplit;
     bit = 1;
   } else {
-    range_ = split;
+    range = split;
   }
-
-  size_t shift = kVp8Norm[range_];
-  range_ <<= shift;
-  value_ <<= shift;
-  count_ -= shift;
-
-  //DCHECK_EQ(1U, (range_ >> 7));  // In the range [128, 255].
-
+  int shift = __builtin_clz(static_cast<unsigned int>(range)) - 24;
+  range <<= shift;
+  value <<= shift;
+  count -= shift;
   return bit;
 }
 
 bool Vp8BoolDecoder::ReadLiteral(size_t num_bits, int* out) {
   //DCHECK_LE(num_bits, sizeof(int) * CHAR_BIT);
-  *out = 0;
-  for (; num_bits > 0; --num_bits)
-    *out = (*out << 1) | ReadBit(kDefaultProbability);
+  int v = 0;
+  if (num_bits <= static_cast<size_t>(VP8_FAST_LITERAL_BITS)) {
+    if (count_ < static_cast<int>(num_bits))
+      FillDecoder();
+    size_t value = value_;
+    int count = count_;
+    size_t range = range_;
+    for (; num_bits > 0; --num_bits)
+      v = (v << 1) | DecodeBool(value, count, range, kDefaultProbability);
+    value_ = value;
+    count_ = count;
+    range_ = range;
+  } else {
+    for (; num_bits > 0; --num_bits)
+      v = (v << 1) | ReadBit(kDefaultProbability);
+  }
+  *out = v;
   return !OutOfBuffer();
 }
 
-bool Vp8BoolDecoder::ReadBool(bool* out, uint8_t probability) {
-  *out = !!ReadBit(probability);
+bool Vp8BoolDecoder::ReadProbUpdates(const uint8_t* update_probs,
+                                     uint8_t* probs, size_t count) {
+  // A flag takes at most 7 bits and the literal 8, refill below 16 so that
+  // both are decoded without checking in between.
+  const int kMinBits = 16;
+  size_t value = value_;
+  int bits = count_;
+  size_t range = range_;
+  for (size_t i = 0; i < count; ++i) {
+    if (bits < kMinBits) {
+      value_ = value;
+      count_ = bits;
+      FillDecoder();
+      value = value_;
+      bits = count_;
+    }
+    if (!DecodeBool(value, bits, range, update_probs[i]))
+      continue;
+    int v = 0;
+    for (int n = 0; n < 8; ++n)
+      v = (v << 1) | DecodeBool(value, bits, range, kDefaultProbability);
+    probs[i] = v;
+  }
+  value_ = value;
+  count_ = bits;
+  range_ = range;
   return !OutOfBuffer();
 }
 
@@ -222,19 +260,4 @@ uint8_t Vp8BoolDecoder::GetBottom() {
   return static_cast<uint8_t>(value_ >> (VP8_BD_VALUE_BIT - 8));
 }
 
-inline bool Vp8BoolDecoder::OutOfBuffer() {
-  // Check if we have reached the end of the buffer.
-  //
-  // Variable |count_| stores the number of bits in the |value_| buffer, minus
-  // 8. The top byte is part of the algorithm and the remainder is buffered to
-  // be shifted into it. So, if |count_| == 8, the top 16 bits of |value_| are
-  // occupied, 8 for the algorithm and 8 in the buffer.
-  //
-  // When reading a byte from the user's buffer, |count_| is filled with 8 and
-  // one byte is filled into the |value_| buffer. When we reach the end of the
-  // data, |count_| is additionally filled with VP8_LOTS_OF_BITS. So when
-  // |count_| == VP8_LOTS_OF_BITS - 1, the user's data has been exhausted.
-  return (count_ > VP8_BD_VALUE_BIT) && (count_ < VP8_LOTS_OF_BITS);
-}
-
 }  // namespace YamiParser
@@ -95,7 +95,10 @@ class Vp8BoolDecoder {
   // end of |data| and failed to read the boolean. The probability of |out| to
   // be true is |probability| / 256, e.g., when |probability| is 0x80, the
   // chance is 1/2 (i.e., 0x80 / 256).
-  bool ReadBool(bool* out, uint8_t probability);
+  bool ReadBool(bool* out, uint8_t probability) {
+    *out = !!ReadBit(probability);
+    return !OutOfBuffer();
+  }
 
   // Reads a boolean from the coded stream with the default probability 1/2.
   // Returns false if it has reached the end of |data| and failed to read the
@@ -108,6 +111,13 @@ class Vp8BoolDecoder {
   // literal.
   bool ReadLiteral(size_t num_bits, int* out);
 
+  // Reads |count| probability updates: for each i, a flag coded at probability
+  // |update_probs[i]| / 256 and, if it is set, an 8-bit literal that replaces
+  // |probs[i]|. This is the loop of RFC 6386 section 13.4 with the decoder
+  // state kept in registers. Returns false if it has reached the end of |data|.
+  bool ReadProbUpdates(const uint8_t* update_probs, uint8_t* probs,
+                       size_t count);
+
   // Reads a literal with sign from the coded stream. This is similar to
   // the ReadListeral(), it first read a "num_bits"-wide unsigned value, and
   // then read an extra bit as the sign of the literal. Returns false if it has
@@ -139,14 +149,54 @@ class Vp8BoolDecoder {
  private:
   // Reads the next bit from the coded stream. The probability of the bit to
   // be one is |probability| / 256.
-  int ReadBit(int probability);
-
-  // Fills more bits from |user_buffer_| to |value_|. We shall keep at least 8
-  // bits of the current |user_buffer_| in |value_|.
+  int ReadBit(int probability) {
+    size_t split = 1 + (((range_ - 1) * probability) >> 8);
+    if (count_ < 0)
+      FillDecoder();
+    size_t bigsplit = split << (sizeof(value_) * 8 - 8);
+
+    int bit = 0;
+    if (value_ >= bigsplit) {
+      range_ -= split;
+      value_ -= bigsplit;
+      bit = 1;
+    } else {
+      range_ = split;
+    }
+
+    // renormalize |range_| to [128, 255], it is never 0
+    int shift = __builtin_clz(static_cast<unsigned int>(range_)) - 24;
+    range_ <<= shift;
+    value_ <<= shift;
+    count_ -= shift;
+    return bit;
+  }
+
+  // Fills more bits from |user_buffer_| to |value_|, a word at a time while
+  // there is one left. We shall keep at least 8 bits of the current
+  // |user_buffer_| in |value_|.
   void FillDecoder();
 
   // Returns true iff we have ran out of bits.
-  bool OutOfBuffer();
+  //
+  // Variable |count_| stores the number of bits in the |value_| buffer, minus
+  // 8. The top byte is part of the algorithm and the remainder is buffered to
+  // be shifted into it. So, if |count_| == 8, the top 16 bits of |value_| are
+  // occupied, 8 for the algorithm and 8 in the buffer.
+  //
+  // When reading a byte from the user's buffer, |count_| is filled with 8 and
+  // one byte is filled into the |value_| buffer. When we reach the end of the
+  // data, |count_| is additionally filled with kLotsOfBits. So when
+  // |count_| == kLotsOfBits - 1, the user's data has been exhausted.
+  bool OutOfBuffer() const {
+    return (count_ > static_cast<int>(sizeof(value_) * 8)) &&
+           (count_ < kLotsOfBits);
+  }
+
+  // This is meant to be a large, positive constant that can still be
+  // efficiently loaded as an immediate (on platforms like ARM, for example).
+  // Even relatively modest values like 100 would work fine.
+  enum { kLotsOfBits = 0x40000000 };
 
   const uint8_t* user_buffer_;
   const uint8_t* user_buffer_start_;
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vp8_bool_decoder.h"
+#include "vp8_parser.h"
+
+#include "common/benchmark.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+using YamiParser::Vp8BoolDecoder;
+using YamiParser::Vp8FrameHeader;
+using YamiParser::Vp8Parser;
+
+//the token probability update of RFC 6386 13.4, the heaviest part of a
+//keyframe header, and the whole keyframe header parse around it.
+//usage: vp8_bool_decoder_bench [-n loops]
+
+static const int DEFAULT_LOOPS = 100000;
+static const size_t NUM_PROBS = 4 * 8 * 3 * 11;
+static const size_t DATA_SIZE = 4000;
+
+//update flags are coded at high probabilities, like kCoeffUpdateProbs
+static void fillUpdateProbs(uint8_t* updateProbs)
+{
+    for (size_t i = 0; i < NUM_PROBS; i++)
+        updateProbs[i] = 224 + rand() % 32;
+}
+
+//the loop ParseTokenProbs used before ReadProbUpdates, for comparison
+static bool readPerBool(Vp8BoolDecoder& bd, const uint8_t* updateProbs, uint8_t* probs)
+{
+    for (size_t i = 0; i < NUM_PROBS; i++) {
+        bool update;
+        if (!bd.ReadBool(&update, updateProbs[i]))
+            return false;
+        if (update) {
+            int v;
+            if (!bd.ReadLiteral(8, &v))
+                return false;
+            probs[i] = v;
+        }
+    }
+    return true;
+}
+
+static void runUpdates(const char* name, bool bulk, const std::vector<uint8_t>& data,
+    const uint8_t* updateProbs, int loops)
+{
+    uint8_t probs[NUM_PROBS] = { 0 };
+    uint64_t sum = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++) {
+        Vp8BoolDecoder bd;
+        bd.Initialize(&data[0], data.size());
+        bool ok = bulk ? bd.ReadProbUpdates(updateProbs, probs, NUM_PROBS)
+                       : readPerBool(bd, updateProbs, probs);
+        if (!ok) {
+            fprintf(stderr, "%s: out of data\n", name);
+            return;
+        }
+        sum += probs[i % NUM_PROBS] + bd.BitOffset();
+    }
+    t = benchNow() - t;
+    printf("%-10s %8.3f us/update (checksum %llx)\n", name, t * 1e6 / loops,
+        (unsigned long long)sum);
+}
+
+//a keyframe tag and start code, a first partition of random header bits,
+//then zeros, so every dct partition size is 0 and fits the frame
+static void fillKeyFrame(std::vector<uint8_t>& frame)
+{
+    const uint32_t firstPartSize = (frame.size() - 10) / 2;
+    const uint32_t tag = (1 << 4) | (firstPartSize << 5);
+    const uint8_t header[] = { (uint8_t)tag, (uint8_t)(tag >> 8), (uint8_t)(tag >> 16),
+        0x9d, 0x01, 0x2a, 0x80, 0x07, 0x38, 0x04 };
+    std::fill(frame.begin(), frame.end(), 0);
+    std::copy(header, header + sizeof(header), frame.begin());
+    for (size_t i = sizeof(header); i < sizeof(header) + firstPartSize; i++)
+        frame[i] = rand();
+}
+
+static void runParser(const std::vector<uint8_t>& frame, int loops)
+{
+    Vp8Parser parser;
+    Vp8FrameHeader header;
+    uint64_t sum = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++) {
+        if (parser.ParseFrame(&frame[0], frame.size(), &header) != YamiParser::VP8_PARSER_OK) {
+            fprintf(stderr, "ParseFrame failed\n");
+            return;
+        }
+        sum += header.macroblock_bit_offset;
+    }
+    t = benchNow() - t;
+    printf("%-10s %8.3f us/frame (checksum %llx)\n", "keyframe", t * 1e6 / loops,
+        (unsigned long long)sum);
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n loops]\n", argv[0]);
+            return -1;
+        }
+        loops = atoi(optarg);
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+
+    srand(1);
+    std::vector<uint8_t> data(DATA_SIZE);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = rand();
+    uint8_t updateProbs[NUM_PROBS];
+    fillUpdateProbs(updateProbs);
+
+    runUpdates("per bool", false, data, updateProbs, loops);
+    runUpdates("bulk", true, data, updateProbs, loops);
+
+    std::vector<uint8_t> frame(DATA_SIZE);
+    fillKeyFrame(frame);
+    runParser(frame, loops);
+    return 0;
+}
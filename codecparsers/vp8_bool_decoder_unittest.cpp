@@ -44,6 +44,7 @@
 #include <stdint.h>
 
 #include <limits>
+#include <string.h>
 
 #include "common/unittest.h"
 
@@ -158,4 +159,57 @@ TEST_F(Vp8BoolDecoderTest, DecodeBoolsWithParitiesAndIncreasingProbabilities) {
   }
 }
 
+TEST_F(Vp8BoolDecoderTest, ReadProbUpdatesWithEvenProbabilities) {
+  const size_t kNumProbs = 11;
+  uint8_t update_probs[kNumProbs];
+  uint8_t probs[kNumProbs];
+  memset(update_probs, 0x80, sizeof(update_probs));
+
+  // no flag is set, the probabilities are kept
+  INITIALIZE(kDataZerosAndEvenProbabilities);
+  memset(probs, 0x55, sizeof(probs));
+  ASSERT_TRUE(bd_.ReadProbUpdates(update_probs, probs, kNumProbs));
+  for (size_t i = 0; i < kNumProbs; ++i)
+    EXPECT_EQ(0x55, probs[i]);
+
+  // every flag is set and followed by 0xff
+  INITIALIZE(kDataOnesAndEvenProbabilities);
+  ASSERT_TRUE(bd_.ReadProbUpdates(update_probs, probs, kNumProbs));
+  for (size_t i = 0; i < kNumProbs; ++i)
+    EXPECT_EQ(0xff, probs[i]);
+  EXPECT_EQ(kNumProbs * 9, bd_.BitOffset());
+}
+
+TEST_F(Vp8BoolDecoderTest, ReadProbUpdatesMatchesReadBool) {
+  const size_t kNumProbs = 20;
+  uint8_t update_probs[kNumProbs];
+  uint8_t probs[kNumProbs];
+  uint8_t expected[kNumProbs];
+  for (size_t i = 0; i < kNumProbs; ++i) {
+    update_probs[i] = i * 13;
+    probs[i] = expected[i] = i;
+  }
+
+  Vp8BoolDecoder reference;
+  ASSERT_TRUE(reference.Initialize(kDataParitiesAndIncreasingProbabilities,
+                                   sizeof(kDataParitiesAndIncreasingProbabilities)));
+  for (size_t i = 0; i < kNumProbs; ++i) {
+    bool update;
+    ASSERT_TRUE(reference.ReadBool(&update, update_probs[i]));
+    int value;
+    if (update) {
+      ASSERT_TRUE(reference.ReadLiteral(8, &value));
+      expected[i] = value;
+    }
+  }
+
+  INITIALIZE(kDataParitiesAndIncreasingProbabilities);
+  ASSERT_TRUE(bd_.ReadProbUpdates(update_probs, probs, kNumProbs));
+  for (size_t i = 0; i < kNumProbs; ++i)
+    EXPECT_EQ(expected[i], probs[i]);
+  EXPECT_EQ(reference.BitOffset(), bd_.BitOffset());
+  EXPECT_EQ(reference.GetRange(), bd_.GetRange());
+  EXPECT_EQ(reference.GetBottom(), bd_.GetBottom());
+}
+
 }  // namespace YamiParser
@@ -778,19 +778,11 @@ void Vp8Parser::ResetProbs() {
 
 bool Vp8Parser::ParseTokenProbs(Vp8EntropyHeader* ehdr,
                                 bool update_curr_probs) {
-  for (size_t i = 0; i < kNumBlockTypes; ++i) {
-    for (size_t j = 0; j < kNumCoeffBands; ++j) {
-      for (size_t k = 0; k < kNumPrevCoeffContexts; ++k) {
-        for (size_t l = 0; l < kNumEntropyNodes; ++l) {
-          bool coeff_prob_update_flag;
-          BD_READ_BOOL_WITH_PROB_OR_RETURN(&coeff_prob_update_flag,
-                                           kCoeffUpdateProbs[i][j][k][l]);
-          if (coeff_prob_update_flag)
-            BD_READ_UNSIGNED_OR_RETURN(8, &ehdr->coeff_probs[i][j][k][l]);
-        }
-      }
-    }
-  }
+  // kCoeffUpdateProbs and coeff_probs are laid out alike, one flag per entry
+  if (!bd_.ReadProbUpdates(&kCoeffUpdateProbs[0][0][0][0],
+                           &ehdr->coeff_probs[0][0][0][0],
+                           sizeof(ehdr->coeff_probs)))
+    ERROR_RETURN(ehdr->coeff_probs);
 
   if (update_curr_probs) {
     memcpy(curr_entropy_hdr_.coeff_probs, ehdr->coeff_probs,
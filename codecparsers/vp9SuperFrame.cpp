@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp9SuperFrame.h"
+
+namespace YamiParser {
+
+Vp9SuperFrameIterator::Vp9SuperFrameIterator()
+    : m_data(NULL)
+    , m_count(0)
+    , m_index(0)
+    , m_offset(0)
+{
+}
+
+bool Vp9SuperFrameIterator::init(const uint8_t* data, size_t size)
+{
+    m_data = data;
+    m_count = 0;
+    m_index = 0;
+    m_offset = 0;
+    if (!data || !size)
+        return false;
+
+    // superframe_index(): a marker byte 110mmfff at both ends of the index,
+    // mm + 1 bytes per frame size and fff + 1 frames
+    const uint8_t marker = data[size - 1];
+    if ((marker & 0xe0) != 0xc0) {
+        m_sizes[0] = size;
+        m_count = 1;
+        return true;
+    }
+    const uint32_t frames = (marker & 0x7) + 1;
+    const uint32_t mag = ((marker >> 3) & 0x3) + 1;
+    const size_t indexSize = 2 + mag * frames;
+    if (size < indexSize || data[size - indexSize] != marker)
+        return false;
+
+    const uint8_t* p = data + size - indexSize + 1;
+    const size_t payload = size - indexSize;
+    size_t total = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        uint32_t sz = 0;
+        for (uint32_t j = 0; j < mag; j++)
+            sz |= (*p++) << (j * 8);
+        total += sz;
+        if (!sz || total > payload)
+            return false;
+        m_sizes[i] = sz;
+    }
+    m_count = frames;
+    return true;
+}
+
+bool Vp9SuperFrameIterator::next(const uint8_t*& frame, uint32_t& size)
+{
+    if (m_index >= m_count)
+        return false;
+    frame = m_data + m_offset;
+    size = m_sizes[m_index];
+    m_offset += size;
+    m_index++;
+    return true;
+}
+
+} // namespace YamiParser
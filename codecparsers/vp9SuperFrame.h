@@ -0,0 +1,65 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef vp9SuperFrame_h
+#define vp9SuperFrame_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace YamiParser {
+
+/**
+ * Walks the frames of a vp9 superframe (annex B of the vp9 bitstream spec)
+ * in place.  The index is decoded into a fixed array, so nothing is copied
+ * or allocated per packet.  A packet without an index holds one frame.
+ */
+class Vp9SuperFrameIterator {
+public:
+    enum {
+        MAX_FRAMES = 8
+    };
+
+    Vp9SuperFrameIterator();
+
+    /**
+     * @retval false if data is empty, the index is corrupt or the frames
+     * it lists don't fit in the packet
+     */
+    bool init(const uint8_t* data, size_t size);
+
+    /**
+     * @retval false once all frames are visited
+     */
+    bool next(const uint8_t*& frame, uint32_t& size);
+
+    // number of frames in the packet
+    uint32_t count() const { return m_count; }
+
+    // position of the frame returned by the last next()
+    uint32_t index() const { return m_index - 1; }
+
+private:
+    const uint8_t* m_data;
+    uint32_t m_sizes[MAX_FRAMES];
+    uint32_t m_count;
+    uint32_t m_index;
+    uint32_t m_offset;
+};
+
+} // namespace YamiParser
+
+#endif // vp9SuperFrame_h
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp9SuperFrame.h"
+
+// library headers
+#include "common/unittest.h"
+
+// system headers
+#include <string.h>
+
+namespace YamiParser {
+
+#define VP9_SUPER_FRAME_TEST(name) \
+    TEST(Vp9SuperFrameIteratorTest, name)
+
+// three frames of 3, 1 and 2 bytes, two bytes per size
+static const uint8_t g_SuperFrame[] = {
+    0x11, 0x12, 0x13, 0x21, 0x31, 0x32,
+    0xca, 0x03, 0x00, 0x01, 0x00, 0x02, 0x00, 0xca
+};
+
+VP9_SUPER_FRAME_TEST(SingleFrame)
+{
+    const uint8_t data[] = { 0x82, 0x49, 0x83, 0x42, 0x00 };
+    Vp9SuperFrameIterator it;
+    const uint8_t* frame;
+    uint32_t size;
+
+    ASSERT_TRUE(it.init(data, sizeof(data)));
+    EXPECT_EQ(1u, it.count());
+    ASSERT_TRUE(it.next(frame, size));
+    EXPECT_EQ(data, frame);
+    EXPECT_EQ(sizeof(data), size);
+    EXPECT_EQ(0u, it.index());
+    EXPECT_FALSE(it.next(frame, size));
+}
+
+VP9_SUPER_FRAME_TEST(SuperFrame)
+{
+    const uint32_t sizes[] = { 3, 1, 2 };
+    Vp9SuperFrameIterator it;
+    const uint8_t* frame;
+    uint32_t size;
+
+    ASSERT_TRUE(it.init(g_SuperFrame, sizeof(g_SuperFrame)));
+    EXPECT_EQ(3u, it.count());
+    const uint8_t* expected = g_SuperFrame;
+    for (uint32_t i = 0; i < 3; i++) {
+        ASSERT_TRUE(it.next(frame, size));
+        EXPECT_EQ(i, it.index());
+        EXPECT_EQ(expected, frame);
+        EXPECT_EQ(sizes[i], size);
+        EXPECT_EQ(i + 1, static_cast<uint32_t>(frame[0] >> 4));
+        expected += size;
+    }
+    EXPECT_FALSE(it.next(frame, size));
+
+    //init() starts over
+    ASSERT_TRUE(it.init(g_SuperFrame, sizeof(g_SuperFrame)));
+    ASSERT_TRUE(it.next(frame, size));
+    EXPECT_EQ(g_SuperFrame, frame);
+}
+
+VP9_SUPER_FRAME_TEST(Invalid)
+{
+    Vp9SuperFrameIterator it;
+    uint8_t data[sizeof(g_SuperFrame)];
+    const uint8_t* frame;
+    uint32_t size;
+
+    EXPECT_FALSE(it.init(NULL, 0));
+    EXPECT_FALSE(it.init(g_SuperFrame, 0));
+    EXPECT_FALSE(it.next(frame, size));
+
+    //the index is longer than the packet
+    EXPECT_FALSE(it.init(g_SuperFrame + 7, sizeof(g_SuperFrame) - 7));
+
+    //the markers differ
+    memcpy(data, g_SuperFrame, sizeof(data));
+    data[6] = 0xcb;
+    EXPECT_FALSE(it.init(data, sizeof(data)));
+
+    //the frames overrun the index
+    memcpy(data, g_SuperFrame, sizeof(data));
+    data[7] = 0x04;
+    EXPECT_FALSE(it.init(data, sizeof(data)));
+
+    //a frame is empty
+    memcpy(data, g_SuperFrame, sizeof(data));
+    data[9] = 0x00;
+    EXPECT_FALSE(it.init(data, sizeof(data)));
+    EXPECT_FALSE(it.next(frame, size));
+}
+}
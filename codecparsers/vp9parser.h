@@ -17,12 +17,9 @@
 #ifndef __VP9_PARSER_H__
 #define __VP9_PARSER_H__
 
-#ifdef __cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
 #include <stdint.h>
 #include "common/common_def.h"
+#include "common/NonCopyable.h"
 
 #define VP9_REFS_PER_FRAME 3
 
@@ -43,13 +40,6 @@ extern "C" {
 
 #define VP9_PREDICTION_PROBS 3
 
-typedef struct _Vp9FrameHdr Vp9FrameHdr;
-typedef struct _Vp9Parser Vp9Parser;
-typedef struct _Vp9LoopFilter Vp9LoopFilter;
-typedef struct _Vp9Segmentation Vp9Segmentation;
-typedef struct _Vp9SegmentationInfo Vp9SegmentationInfo;
-typedef struct _Vp9SegmentationInfoData Vp9SegmentationInfoData;
-
 /**
   * Vp9ParseResult:
   * @VP9_PARSER_OK: The parsing went well
@@ -109,69 +99,69 @@ typedef enum {
     VP9_MAX_REF_FRAMES = 4
 } VP9_MV_REFERENCE_FRAME;
 
-struct _Vp9LoopFilter {
+struct Vp9LoopFilter {
     uint8_t filter_level;
     uint8_t sharpness_level;
 
-    BOOL mode_ref_delta_enabled;
-    BOOL mode_ref_delta_update;
-    BOOL update_ref_deltas[VP9_MAX_REF_LF_DELTAS];
+    bool mode_ref_delta_enabled;
+    bool mode_ref_delta_update;
+    bool update_ref_deltas[VP9_MAX_REF_LF_DELTAS];
     int8_t ref_deltas[VP9_MAX_REF_LF_DELTAS];
-    BOOL update_mode_deltas[VP9_MAX_MODE_LF_DELTAS];
+    bool update_mode_deltas[VP9_MAX_MODE_LF_DELTAS];
     int8_t mode_deltas[VP9_MAX_MODE_LF_DELTAS];
 };
 
-struct _Vp9SegmentationInfoData {
+struct Vp9SegmentationInfoData {
     /* SEG_LVL_ALT_Q */
-    BOOL alternate_quantizer_enabled;
+    bool alternate_quantizer_enabled;
     int16_t alternate_quantizer;
 
     /* SEG_LVL_ALT_LF */
-    BOOL alternate_loop_filter_enabled;
+    bool alternate_loop_filter_enabled;
     int8_t alternate_loop_filter;
 
     /* SEG_LVL_REF_FRAME */
-    BOOL reference_frame_enabled;
+    bool reference_frame_enabled;
     uint8_t reference_frame;
 
-    BOOL reference_skip;
+    bool reference_skip;
 };
 
-struct _Vp9SegmentationInfo {
+struct Vp9SegmentationInfo {
     /* segmetation */
     /* enable in setup_segmentation*/
-    BOOL enabled;
+    bool enabled;
     /* update_map in setup_segmentation*/
-    BOOL update_map;
+    bool update_map;
     /* tree_probs exist or not*/
-    BOOL update_tree_probs[VP9_SEG_TREE_PROBS];
+    bool update_tree_probs[VP9_SEG_TREE_PROBS];
     uint8_t tree_probs[VP9_SEG_TREE_PROBS];
     /* pred_probs exist or not*/
-    BOOL update_pred_probs[VP9_PREDICTION_PROBS];
+    bool update_pred_probs[VP9_PREDICTION_PROBS];
     uint8_t pred_probs[VP9_PREDICTION_PROBS];
 
     /* abs_delta in setup_segmentation */
-    BOOL abs_delta;
+    bool abs_delta;
     /* temporal_update in setup_segmentation */
-    BOOL temporal_update;
+    bool temporal_update;
 
     /* update_data in setup_segmentation*/
-    BOOL update_data;
+    bool update_data;
     Vp9SegmentationInfoData data[VP9_MAX_SEGMENTS];
 };
 
-struct _Vp9FrameHdr {
+struct Vp9FrameHdr {
     VP9_PROFILE profile;
-    BOOL show_existing_frame;
+    bool show_existing_frame;
     uint8_t frame_to_show;
     VP9_FRAME_TYPE frame_type;
-    BOOL show_frame;
-    BOOL error_resilient_mode;
-    BOOL subsampling_x;
-    BOOL subsampling_y;
+    bool show_frame;
+    bool error_resilient_mode;
+    bool subsampling_x;
+    bool subsampling_y;
     uint32_t width;
     uint32_t height;
-    BOOL display_size_enabled;
+    bool display_size_enabled;
     uint32_t display_width;
     uint32_t display_height;
     uint8_t frame_context_idx;
@@ -179,19 +169,19 @@ struct _Vp9FrameHdr {
     VP9_BIT_DEPTH bit_depth;
     VP9_COLOR_SPACE color_space;
 
-    BOOL intra_only;
+    bool intra_only;
     uint8_t reset_frame_context;
     uint8_t refresh_frame_flags;
 
     uint8_t ref_frame_indices[VP9_REFS_PER_FRAME];
-    BOOL ref_frame_sign_bias[VP9_REFS_PER_FRAME];
-    BOOL size_from_ref[VP9_REFS_PER_FRAME];
-    BOOL allow_high_precision_mv;
+    bool ref_frame_sign_bias[VP9_REFS_PER_FRAME];
+    bool size_from_ref[VP9_REFS_PER_FRAME];
+    bool allow_high_precision_mv;
     VP9_INTERP_FILTER mcomp_filter_type;
 
-    BOOL refresh_frame_context;
+    bool refresh_frame_context;
     /* frame_parallel_decoding_mode in vp9 code*/
-    BOOL frame_parallel_decoding_mode;
+    bool frame_parallel_decoding_mode;
 
     //quant
     uint8_t base_qindex;
@@ -209,40 +199,95 @@ struct _Vp9FrameHdr {
     uint32_t frame_header_length_in_bytes;
 };
 
-struct _Vp9Segmentation {
+struct Vp9Segmentation {
     uint8_t filter_level[4][2];
     int16_t luma_ac_quant_scale;
     int16_t luma_dc_quant_scale;
     int16_t chroma_ac_quant_scale;
     int16_t chroma_dc_quant_scale;
 
-    BOOL reference_frame_enabled;
+    bool reference_frame_enabled;
     uint8_t reference_frame;
 
-    BOOL reference_skip;
+    bool reference_skip;
 };
 
-struct _Vp9Parser {
-    BOOL lossless_flag;
-    VP9_BIT_DEPTH bit_depth;
-
-    uint8_t mb_segment_tree_probs[VP9_SEG_TREE_PROBS];
-    uint8_t segment_pred_probs[VP9_PREDICTION_PROBS];
-    Vp9Segmentation segmentation[VP9_MAX_SEGMENTS];
 
-    /* private data */
-    void* priv;
+namespace YamiParser {
+
+class BitReader;
+
+/* Parses the uncompressed header of vp9 frames and keeps the state that
+ * lasts across frames.  The per segment quantizer scales and loop filter
+ * levels are derived from that state, they are only recomputed when
+ * something they depend on changes. */
+class Vp9Parser {
+public:
+    Vp9Parser();
+
+    Vp9ParseResult parse(Vp9FrameHdr& hdr, const uint8_t* data, uint32_t size);
+
+    VP9_BIT_DEPTH bitDepth() const { return m_bitDepth; }
+    bool losslessFlag() const { return m_losslessFlag; }
+    const uint8_t* segmentTreeProbs() const { return m_segmentTreeProbs; }
+    const uint8_t* segmentPredProbs() const { return m_segmentPredProbs; }
+    const Vp9Segmentation& segmentation(uint32_t id) const { return m_segmentation[id]; }
+
+private:
+    struct ReferenceSize {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    Vp9ParseResult parseColorConfig(Vp9FrameHdr& hdr, BitReader& br);
+    void readFrameSizeFromRefs(Vp9FrameHdr& hdr, BitReader& br) const;
+    void setBitDepth(VP9_BIT_DEPTH bitDepth);
+    void resetSegmentation();
+    void setupPastIndependence(Vp9FrameHdr& hdr);
+    void update(Vp9FrameHdr& hdr);
+    void loopFilterUpdate(const Vp9LoopFilter& lf);
+    void quantizationUpdate(const Vp9FrameHdr& hdr);
+    void segmentationSave(const Vp9SegmentationInfo& info);
+    void segmentationUpdate(const Vp9FrameHdr& hdr);
+    void referenceUpdate(const Vp9FrameHdr& hdr);
+    uint8_t segBaseQindex(const Vp9FrameHdr& hdr, uint32_t id) const;
+    uint8_t segFilterLevel(const Vp9FrameHdr& hdr, uint32_t id) const;
+
+    bool m_losslessFlag;
+    VP9_BIT_DEPTH m_bitDepth;
+    uint8_t m_segmentTreeProbs[VP9_SEG_TREE_PROBS];
+    uint8_t m_segmentPredProbs[VP9_PREDICTION_PROBS];
+    Vp9Segmentation m_segmentation[VP9_MAX_SEGMENTS];
+
+    bool m_subsamplingX;
+    bool m_subsamplingY;
+    VP9_COLOR_SPACE m_colorSpace;
+
+    int8_t m_yDcDeltaQ;
+    int8_t m_uvDcDeltaQ;
+    int8_t m_uvAcDeltaQ;
+
+    int8_t m_refDeltas[VP9_MAX_REF_LF_DELTAS];
+    int8_t m_modeDeltas[VP9_MAX_MODE_LF_DELTAS];
+
+    bool m_segmentationAbsDelta;
+    Vp9SegmentationInfoData m_segmentationData[VP9_MAX_SEGMENTS];
+
+    ReferenceSize m_reference[VP9_REF_FRAMES];
+
+    /* what m_segmentation was last built from */
+    uint8_t m_baseQindex;
+    uint8_t m_filterLevel;
+    bool m_modeRefDeltaEnabled;
+    bool m_segmentationEnabled;
+
+    /* the quantizer scales or the filter levels in m_segmentation are stale */
+    bool m_quantDirty;
+    bool m_filterDirty;
+
+    DISALLOW_COPY_AND_ASSIGN(Vp9Parser);
 };
 
-Vp9ParseResult
-vp9_parse_frame_header(Vp9Parser* parser, Vp9FrameHdr* frame_hdr, const uint8_t* data, uint32_t size);
-
-Vp9Parser* vp9_parser_new();
-
-void vp9_parser_free(Vp9Parser* parser);
-
-#ifdef __cplusplus
-}
-#endif /* __cplusplus */
+} // namespace YamiParser
 
 #endif /* __VP9_PARSER_H__ */
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vp9parser.h"
+#include "vp9SuperFrame.h"
+#include "bitWriter.h"
+
+#include "common/benchmark.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+using YamiParser::BitWriter;
+using YamiParser::Vp9Parser;
+using YamiParser::Vp9SuperFrameIterator;
+
+//uncompressed header parse cost per frame over a long vp9 stream.
+//usage: vp9parser_bench [-n loops] [file.ivf]
+//without a file, a 1080p stream with a key frame every 300 frames, fixed
+//quantizer and loop filter and segmentation enabled is synthesized.
+
+static const int DEFAULT_LOOPS = 20;
+static const uint32_t SYNTHETIC_FRAMES = 30000;
+static const uint32_t KEY_FRAME_INTERVAL = 300;
+
+typedef std::vector<std::vector<uint8_t> > Frames;
+
+static uint32_t readLe32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//splits an ivf file into frames, superframes are split as well
+static bool readIvf(const char* fileName, Frames& frames)
+{
+    std::vector<uint8_t> data;
+    if (!benchReadFile(fileName, data))
+        return false;
+    if (data.size() < 32 || memcmp(&data[0], "DKIF", 4)) {
+        fprintf(stderr, "%s is not an ivf file\n", fileName);
+        return false;
+    }
+    size_t pos = data[6] | (data[7] << 8);
+    while (data.size() >= pos + 12) {
+        uint32_t size = readLe32(&data[pos]);
+        pos += 12;
+        if (size > data.size() - pos)
+            break;
+        Vp9SuperFrameIterator it;
+        if (it.init(&data[pos], size)) {
+            const uint8_t* frame;
+            uint32_t frameSize;
+            while (it.next(frame, frameSize))
+                frames.push_back(std::vector<uint8_t>(frame, frame + frameSize));
+        }
+        pos += size;
+    }
+    return true;
+}
+
+static void writeSigned(BitWriter& bw, int32_t value, uint32_t bits)
+{
+    bw.writeBits(abs(value), bits);
+    bw.writeBits(value < 0, 1);
+}
+
+static void writeFrame(BitWriter& bw, bool key)
+{
+    bw.writeBits(2, 2); //frame marker
+    bw.writeBits(0, 2); //profile 0
+    bw.writeBits(0, 1); //show_existing_frame
+    bw.writeBits(!key, 1);
+    bw.writeBits(1, 1); //show_frame
+    bw.writeBits(0, 1); //error_resilient_mode
+    if (key) {
+        bw.writeBits(0x498342, 24);
+        bw.writeBits(1, 3); //color space
+        bw.writeBits(0, 1); //color range
+        bw.writeBits(1920 - 1, 16);
+        bw.writeBits(1080 - 1, 16);
+        bw.writeBits(0, 1); //render_and_frame_size_different
+    }
+    else {
+        bw.writeBits(0, 2); //reset_frame_context
+        bw.writeBits(1, 8); //refresh_frame_flags
+        for (uint32_t i = 0; i < 3; i++) {
+            bw.writeBits(i, 3); //ref_frame_idx
+            bw.writeBits(0, 1); //sign_bias
+        }
+        bw.writeBits(1, 1); //found_ref
+        bw.writeBits(0, 1); //render_and_frame_size_different
+        bw.writeBits(0, 1); //allow_high_precision_mv
+        bw.writeBits(1, 1); //is_filter_switchable
+    }
+    bw.writeBits(1, 1); //refresh_frame_context
+    bw.writeBits(1, 1); //frame_parallel_decoding_mode
+    bw.writeBits(0, 2); //frame_context_idx
+
+    bw.writeBits(20, 6); //filter_level
+    bw.writeBits(0, 3); //sharpness_level
+    bw.writeBits(1, 1); //mode_ref_delta_enabled
+    bw.writeBits(key, 1); //mode_ref_delta_update
+    if (key) {
+        for (uint32_t i = 0; i < 6; i++) {
+            bw.writeBits(1, 1);
+            writeSigned(bw, i - 3, 6);
+        }
+    }
+
+    bw.writeBits(100, 8); //base_q_idx
+    bw.writeBits(0, 3); //no delta_q
+
+    bw.writeBits(1, 1); //segmentation_enabled
+    bw.writeBits(key, 1); //update_map
+    if (key) {
+        for (uint32_t i = 0; i < 7; i++) {
+            bw.writeBits(1, 1);
+            bw.writeBits(128 + i, 8);
+        }
+        bw.writeBits(0, 1); //temporal_update
+    }
+    bw.writeBits(key, 1); //update_data
+    if (key) {
+        bw.writeBits(0, 1); //abs_or_delta_update
+        for (uint32_t i = 0; i < 8; i++) {
+            bw.writeBits(1, 1);
+            writeSigned(bw, i * 4, 8); //alt q
+            bw.writeBits(1, 1);
+            writeSigned(bw, i, 6); //alt lf
+            bw.writeBits(0, 1); //ref frame
+            bw.writeBits(0, 1); //skip
+        }
+    }
+
+    bw.writeBits(0, 1); //tile columns, as few as 1080p allows
+    bw.writeBits(0, 1); //tile_rows
+    bw.writeBits(0x1000, 16); //header_size_in_bytes
+    bw.writeBits(0, 32); //something for the compressed header
+}
+
+static void synthesize(Frames& frames)
+{
+    for (uint32_t i = 0; i < SYNTHETIC_FRAMES; i++) {
+        BitWriter bw;
+        writeFrame(bw, !(i % KEY_FRAME_INTERVAL));
+        bw.writeToBytesAligned();
+        const uint8_t* data = bw.getBitWriterData();
+        frames.push_back(std::vector<uint8_t>(data, data + bw.getCodedBitsCount() / 8));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n loops] [file.ivf]\n", argv[0]);
+            return -1;
+        }
+        loops = atoi(optarg);
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+
+    Frames frames;
+    if (optind < argc) {
+        if (!readIvf(argv[optind], frames))
+            return -1;
+    }
+    else {
+        synthesize(frames);
+    }
+    if (frames.empty()) {
+        fprintf(stderr, "no frames\n");
+        return -1;
+    }
+
+    Vp9Parser parser;
+    Vp9FrameHdr header;
+    uint32_t errors = 0;
+    uint64_t sum = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++) {
+        for (size_t j = 0; j < frames.size(); j++) {
+            if (parser.parse(header, &frames[j][0], frames[j].size()) != VP9_PARSER_OK)
+                errors++;
+            sum += parser.segmentation(1).luma_ac_quant_scale;
+        }
+    }
+    t = benchNow() - t;
+    printf("%u frames, %u errors, %.1f ns/frame (checksum %llx)\n",
+        (uint32_t)frames.size(), errors / loops, t * 1e9 / loops / frames.size(),
+        (unsigned long long)sum);
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp9parser.h"
+
+// library headers
+#include "bitWriter.h"
+#include "vp9quant.h"
+#include "common/unittest.h"
+
+// system headers
+#include <stdlib.h>
+#include <vector>
+
+namespace YamiParser {
+
+#define VP9_PARSER_TEST(name) \
+    TEST(Vp9ParserTest, name)
+
+struct HeaderParams {
+    bool keyFrame;
+    uint32_t width;
+    uint32_t height;
+    uint8_t filterLevel;
+    bool modeRefDeltaEnabled;
+    // -1 keeps the previous delta
+    int refDelta[VP9_MAX_REF_LF_DELTAS];
+    uint8_t baseQindex;
+    int8_t yDcDeltaQ;
+    bool segmentation;
+    bool segmentationUpdateData;
+    int16_t segmentationAltQ[VP9_MAX_SEGMENTS];
+};
+
+static HeaderParams defaultParams(bool keyFrame)
+{
+    HeaderParams p = {};
+    p.keyFrame = keyFrame;
+    p.width = 352;
+    p.height = 288;
+    p.filterLevel = 10;
+    p.baseQindex = 60;
+    for (int i = 0; i < VP9_MAX_REF_LF_DELTAS; i++)
+        p.refDelta[i] = -1;
+    return p;
+}
+
+static void writeSigned(BitWriter& bw, int value, uint32_t bits)
+{
+    bw.writeBits(abs(value), bits);
+    bw.writeBits(value < 0, 1);
+}
+
+// profile 0 uncompressed header, inter frames take their size from the first reference
+static std::vector<uint8_t> writeHeader(const HeaderParams& p)
+{
+    BitWriter bw;
+    bw.writeBits(2, 2); //frame_marker
+    bw.writeBits(0, 2); //profile
+    bw.writeBits(0, 1); //show_existing_frame
+    bw.writeBits(!p.keyFrame, 1);
+    bw.writeBits(1, 1); //show_frame
+    bw.writeBits(0, 1); //error_resilient_mode
+    if (p.keyFrame) {
+        bw.writeBits(0x498342, 24);
+        bw.writeBits(VP9_BT_601, 3);
+        bw.writeBits(0, 1); //color_range
+        bw.writeBits(p.width - 1, 16);
+        bw.writeBits(p.height - 1, 16);
+        bw.writeBits(0, 1); //display_size_enabled
+    }
+    else {
+        bw.writeBits(0, 2); //reset_frame_context
+        bw.writeBits(1, 8); //refresh_frame_flags
+        for (int i = 0; i < VP9_REFS_PER_FRAME; i++) {
+            bw.writeBits(i, 3);
+            bw.writeBits(0, 1);
+        }
+        bw.writeBits(1, 1); //found_ref
+        bw.writeBits(0, 1); //display_size_enabled
+        bw.writeBits(0, 1); //allow_high_precision_mv
+        bw.writeBits(1, 1); //switchable interp filter
+    }
+    bw.writeBits(1, 1); //refresh_frame_context
+    bw.writeBits(0, 1); //frame_parallel_decoding_mode
+    bw.writeBits(0, 2); //frame_context_idx
+
+    bw.writeBits(p.filterLevel, 6);
+    bw.writeBits(0, 3); //sharpness_level
+    bw.writeBits(p.modeRefDeltaEnabled, 1);
+    if (p.modeRefDeltaEnabled) {
+        bw.writeBits(1, 1); //mode_ref_delta_update
+        for (int i = 0; i < VP9_MAX_REF_LF_DELTAS; i++) {
+            bw.writeBits(p.refDelta[i] >= 0, 1);
+            if (p.refDelta[i] >= 0)
+                writeSigned(bw, p.refDelta[i], 6);
+        }
+        for (int i = 0; i < VP9_MAX_MODE_LF_DELTAS; i++)
+            bw.writeBits(0, 1);
+    }
+
+    bw.writeBits(p.baseQindex, 8);
+    bw.writeBits(p.yDcDeltaQ != 0, 1);
+    if (p.yDcDeltaQ)
+        writeSigned(bw, p.yDcDeltaQ, 4);
+    bw.writeBits(0, 2); //uv delta q
+
+    bw.writeBits(p.segmentation, 1);
+    if (p.segmentation) {
+        bw.writeBits(0, 1); //update_map
+        bw.writeBits(p.segmentationUpdateData, 1);
+        if (p.segmentationUpdateData) {
+            bw.writeBits(0, 1); //abs_delta
+            for (int i = 0; i < VP9_MAX_SEGMENTS; i++) {
+                bw.writeBits(p.segmentationAltQ[i] != 0, 1);
+                if (p.segmentationAltQ[i])
+                    writeSigned(bw, p.segmentationAltQ[i], 8);
+                bw.writeBits(0, 3); //no alt lf, ref frame or skip
+            }
+        }
+    }
+
+    bw.writeBits(0, 1); //log2_tile_rows
+    bw.writeBits(0x100, 16); //first_partition_size
+    bw.writeToBytesAligned();
+    uint64_t bytes = bw.getCodedBitsCount() / 8;
+    uint8_t* data = bw.getBitWriterData();
+    return std::vector<uint8_t>(data, data + bytes);
+}
+
+static Vp9ParseResult parse(Vp9Parser& parser, Vp9FrameHdr& hdr, const HeaderParams& p)
+{
+    std::vector<uint8_t> data = writeHeader(p);
+    return parser.parse(hdr, &data[0], data.size());
+}
+
+VP9_PARSER_TEST(KeyFrame)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    HeaderParams p = defaultParams(true);
+
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(VP9_KEY_FRAME, hdr.frame_type);
+    EXPECT_EQ(VP9_PROFILE_0, hdr.profile);
+    EXPECT_EQ(352u, hdr.width);
+    EXPECT_EQ(288u, hdr.height);
+    EXPECT_TRUE(hdr.subsampling_x);
+    EXPECT_TRUE(hdr.subsampling_y);
+    EXPECT_EQ(10, hdr.loopfilter.filter_level);
+    EXPECT_EQ(60, hdr.base_qindex);
+    EXPECT_EQ(0x100u, hdr.first_partition_size);
+    EXPECT_EQ(VP9_BITS_8, parser.bitDepth());
+    EXPECT_FALSE(parser.losslessFlag());
+    for (uint32_t i = 0; i < VP9_MAX_SEGMENTS; i++) {
+        const Vp9Segmentation& seg = parser.segmentation(i);
+        EXPECT_EQ(vp9_dc_quant(VP9_BITS_8, 60, 0), seg.luma_dc_quant_scale);
+        EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 60, 0), seg.luma_ac_quant_scale);
+        EXPECT_EQ(10, seg.filter_level[VP9_LAST_FRAME][1]);
+    }
+
+    p.baseQindex = 0;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_TRUE(parser.losslessFlag());
+}
+
+VP9_PARSER_TEST(SizeFromReference)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    HeaderParams p = defaultParams(true);
+    p.width = 176;
+    p.height = 144;
+
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, defaultParams(false)));
+    EXPECT_EQ(VP9_INTER_FRAME, hdr.frame_type);
+    EXPECT_TRUE(hdr.size_from_ref[0]);
+    EXPECT_EQ(176u, hdr.width);
+    EXPECT_EQ(144u, hdr.height);
+    EXPECT_EQ(VP9_BT_601, hdr.color_space);
+}
+
+VP9_PARSER_TEST(QuantizerTables)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    HeaderParams p = defaultParams(true);
+
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    p = defaultParams(false);
+    p.yDcDeltaQ = -3;
+    p.baseQindex = 100;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_dc_quant(VP9_BITS_8, 100, -3), parser.segmentation(0).luma_dc_quant_scale);
+
+    //the delta stays in the tables until a frame changes it
+    p.yDcDeltaQ = 0;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_dc_quant(VP9_BITS_8, 100, 0), parser.segmentation(0).luma_dc_quant_scale);
+
+    //a key frame starts over
+    p = defaultParams(true);
+    p.yDcDeltaQ = 2;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_dc_quant(VP9_BITS_8, 60, 2), parser.segmentation(7).luma_dc_quant_scale);
+}
+
+VP9_PARSER_TEST(SegmentationPersists)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    HeaderParams p = defaultParams(true);
+    p.segmentation = true;
+    p.segmentationUpdateData = true;
+    p.segmentationAltQ[1] = 20;
+    p.segmentationAltQ[2] = -70;
+
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 60, 0), parser.segmentation(0).luma_ac_quant_scale);
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 80, 0), parser.segmentation(1).luma_ac_quant_scale);
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 0, 0), parser.segmentation(2).luma_ac_quant_scale);
+
+    //no update_data, the saved data applies to the new base_qindex
+    p = defaultParams(false);
+    p.segmentation = true;
+    p.baseQindex = 100;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 120, 0), parser.segmentation(1).luma_ac_quant_scale);
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 30, 0), parser.segmentation(2).luma_ac_quant_scale);
+
+    //segmentation off, every segment uses base_qindex
+    p.segmentation = false;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 100, 0), parser.segmentation(1).luma_ac_quant_scale);
+
+    //and back on, the data is still there
+    p.segmentation = true;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(vp9_ac_quant(VP9_BITS_8, 120, 0), parser.segmentation(1).luma_ac_quant_scale);
+}
+
+VP9_PARSER_TEST(LoopFilterDeltas)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    HeaderParams p = defaultParams(true);
+    p.modeRefDeltaEnabled = true;
+
+    //default deltas are 1, 0, -1, -1
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(11, parser.segmentation(0).filter_level[VP9_INTRA_FRAME][0]);
+    EXPECT_EQ(10, parser.segmentation(0).filter_level[VP9_LAST_FRAME][0]);
+    EXPECT_EQ(9, parser.segmentation(0).filter_level[VP9_GOLDEN_FRAME][1]);
+
+    p = defaultParams(false);
+    p.modeRefDeltaEnabled = true;
+    p.refDelta[VP9_LAST_FRAME] = 5;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(15, parser.segmentation(3).filter_level[VP9_LAST_FRAME][0]);
+
+    //deltas persist
+    p.refDelta[VP9_LAST_FRAME] = -1;
+    p.filterLevel = 40;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(50, parser.segmentation(3).filter_level[VP9_LAST_FRAME][0]);
+    EXPECT_EQ(38, parser.segmentation(3).filter_level[VP9_ALTREF_FRAME][1]);
+
+    p.modeRefDeltaEnabled = false;
+    ASSERT_EQ(VP9_PARSER_OK, parse(parser, hdr, p));
+    EXPECT_EQ(40, parser.segmentation(3).filter_level[VP9_LAST_FRAME][0]);
+}
+
+VP9_PARSER_TEST(Invalid)
+{
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    const uint8_t badMarker[] = { 0x02, 0x49, 0x83, 0x42, 0x00 };
+    const uint8_t badSync[] = { 0x80, 0x49, 0x83, 0x43, 0x00 };
+
+    EXPECT_EQ(VP9_PARSER_ERROR, parser.parse(hdr, badMarker, sizeof(badMarker)));
+    EXPECT_EQ(VP9_PARSER_ERROR, parser.parse(hdr, badSync, sizeof(badSync)));
+}
+}
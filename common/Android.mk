@@ -13,6 +13,7 @@ LOCAL_SRC_FILES := \
         log.cpp \
         utils.cpp \
         nalreader.cpp \
+        bytescan.cpp \
         surfacepool.cpp \
         PooledFrameAllocator.cpp \
         YamiVersion.cpp \
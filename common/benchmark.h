@@ -0,0 +1,55 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef benchmark_h
+#define benchmark_h
+
+//helpers shared by the *_bench programs, they are not built by default,
+//run "make <name>_bench" in the source directory to get one.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+inline double benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+inline bool benchReadFile(const char* fileName, std::vector<uint8_t>& data)
+{
+    FILE* fp = fopen(fileName, "rb");
+    if (!fp) {
+        fprintf(stderr, "can't open %s\n", fileName);
+        return false;
+    }
+    data.clear();
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+} //namespace YamiMediaCodec
+
+#endif //benchmark_h
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef boundedqueue_h
+#define boundedqueue_h
+
+#include "common/condition.h"
+#include "common/lock.h"
+
+#include <deque>
+
+namespace YamiMediaCodec {
+
+/* blocking fifo between two threads, push waits when it holds capacity items.
+ * close() wakes up both sides, every push and pop fails until open() */
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity(capacity)
+        , m_closed(false)
+        , m_notEmpty(m_lock)
+        , m_notFull(m_lock)
+    {
+    }
+
+    bool push(const T& t)
+    {
+        AutoLock lock(m_lock);
+        while (!m_closed && m_queue.size() >= m_capacity)
+            m_notFull.wait();
+        if (m_closed)
+            return false;
+        m_queue.push_back(t);
+        m_notEmpty.signal();
+        return true;
+    }
+
+    bool pop(T& t)
+    {
+        AutoLock lock(m_lock);
+        while (!m_closed && m_queue.empty())
+            m_notEmpty.wait();
+        if (m_closed)
+            return false;
+        t = m_queue.front();
+        m_queue.pop_front();
+        m_notFull.signal();
+        return true;
+    }
+
+    void close()
+    {
+        AutoLock lock(m_lock);
+        m_closed = true;
+        m_notEmpty.broadcast();
+        m_notFull.broadcast();
+    }
+
+    //drop everything left and accept items again
+    void open()
+    {
+        AutoLock lock(m_lock);
+        m_queue.clear();
+        m_closed = false;
+    }
+
+private:
+    const size_t m_capacity;
+    bool m_closed;
+    std::deque<T> m_queue;
+
+    Lock m_lock;
+    Condition m_notEmpty;
+    Condition m_notFull;
+
+    DISALLOW_COPY_AND_ASSIGN(BoundedQueue);
+};
+}
+
+#endif
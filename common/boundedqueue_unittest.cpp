@@ -0,0 +1,103 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "boundedqueue.h"
+
+#include "common/Thread.h"
+#include "common/unittest.h"
+
+namespace YamiMediaCodec {
+
+using std::bind;
+using std::ref;
+
+#define BOUNDED_QUEUE_TEST(name) \
+    TEST(BoundedQueueTest, name)
+
+static void produce(BoundedQueue<int>& queue, int count)
+{
+    for (int i = 0; i < count; i++)
+        EXPECT_TRUE(queue.push(i));
+    EXPECT_TRUE(queue.push(-1));
+}
+
+static void closeQueue(BoundedQueue<int>& queue)
+{
+    queue.close();
+}
+
+BOUNDED_QUEUE_TEST(Fifo)
+{
+    BoundedQueue<int> queue(3);
+    int v;
+
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_TRUE(queue.pop(v));
+    EXPECT_EQ(1, v);
+    EXPECT_TRUE(queue.push(3));
+    EXPECT_TRUE(queue.pop(v));
+    EXPECT_EQ(2, v);
+    EXPECT_TRUE(queue.pop(v));
+    EXPECT_EQ(3, v);
+}
+
+BOUNDED_QUEUE_TEST(ProducerBlocksWhenFull)
+{
+    BoundedQueue<int> queue(2);
+    Thread producer;
+    const int count = 1000;
+
+    EXPECT_TRUE(producer.start());
+    producer.post(bind(produce, ref(queue), count));
+
+    int v;
+    for (int i = 0; i < count; i++) {
+        EXPECT_TRUE(queue.pop(v));
+        EXPECT_EQ(i, v);
+    }
+    EXPECT_TRUE(queue.pop(v));
+    EXPECT_EQ(-1, v);
+    producer.stop();
+}
+
+BOUNDED_QUEUE_TEST(CloseAndOpen)
+{
+    BoundedQueue<int> queue(1);
+    Thread closer;
+    int v;
+
+    EXPECT_TRUE(queue.push(1));
+
+    //close() wakes up a blocked push
+    EXPECT_TRUE(closer.start());
+    closer.post(bind(closeQueue, ref(queue)));
+    EXPECT_FALSE(queue.push(2));
+    closer.stop();
+    EXPECT_FALSE(queue.pop(v));
+
+    //open() drops what was left
+    queue.open();
+    EXPECT_TRUE(queue.push(3));
+    EXPECT_TRUE(queue.pop(v));
+    EXPECT_EQ(3, v);
+}
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2016 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bytescan.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define YAMI_BYTESCAN_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define YAMI_BYTESCAN_X86_SIMD 0
+#endif
+
+namespace YamiMediaCodec {
+
+static const int PATTERN_SIZE = 3;
+
+typedef const uint8_t* (*ZeroZeroByteScanner)(const uint8_t* begin, const uint8_t* end, uint8_t third);
+typedef const uint8_t* (*JpegMarkerScanner)(const uint8_t* begin, const uint8_t* end);
+
+static const uint8_t MARKER_PREFIX = 0xFF;
+static const uint8_t MIN_MARKER_CODE = 0xC0;
+
+static const uint8_t* scanScalar(const uint8_t* begin, const uint8_t* end, uint8_t third)
+{
+    const uint8_t pattern[PATTERN_SIZE] = { 0, 0, third };
+    return std::search(begin, end, pattern, pattern + PATTERN_SIZE);
+}
+
+static const uint8_t* scanMarkerScalar(const uint8_t* begin, const uint8_t* end)
+{
+    for (const uint8_t* p = begin; p + 1 < end; p++) {
+        if (p[0] == MARKER_PREFIX && p[1] >= MIN_MARKER_CODE && p[1] != MARKER_PREFIX)
+            return p;
+    }
+    return end;
+}
+
+#if YAMI_BYTESCAN_X86_SIMD
+//a match at offset i of the block means
+//p[i] == 0 && p[i + 1] == 0 && p[i + 2] == third,
+//so we compare three overlapping loads and take the lowest set bit.
+__attribute__((target("sse2"))) static const uint8_t* scanSse2(const uint8_t* begin, const uint8_t* end, uint8_t third)
+{
+    const uint8_t* p = begin;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i last = _mm_set1_epi8(third);
+    while (end - p >= 16 + PATTERN_SIZE - 1) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 2));
+        __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                        _mm_cmpeq_epi8(b1, zero)),
+            _mm_cmpeq_epi8(b2, last));
+        uint32_t mask = _mm_movemask_epi8(hit);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return scanScalar(p, end, third);
+}
+
+__attribute__((target("avx2"))) static const uint8_t* scanAvx2(const uint8_t* begin, const uint8_t* end, uint8_t third)
+{
+    const uint8_t* p = begin;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i last = _mm256_set1_epi8(third);
+    while (end - p >= 32 + PATTERN_SIZE - 1) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(p + 1));
+        __m256i b2 = _mm256_loadu_si256((const __m256i*)(p + 2));
+        __m256i hit = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero),
+                                           _mm256_cmpeq_epi8(b1, zero)),
+            _mm256_cmpeq_epi8(b2, last));
+        uint32_t mask = _mm256_movemask_epi8(hit);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scanSse2(p, end, third);
+}
+
+//a match at offset i of the block means p[i] == 0xFF and 0xC0 <= p[i + 1] < 0xFF,
+//max(x, 0xC0) == x is the unsigned x >= 0xC0.
+__attribute__((target("sse2"))) static const uint8_t* scanMarkerSse2(const uint8_t* begin, const uint8_t* end)
+{
+    const uint8_t* p = begin;
+    const __m128i prefix = _mm_set1_epi8((char)MARKER_PREFIX);
+    const __m128i minCode = _mm_set1_epi8((char)MIN_MARKER_CODE);
+    while (end - p >= 16 + 1) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 1));
+        __m128i code = _mm_andnot_si128(_mm_cmpeq_epi8(b1, prefix),
+            _mm_cmpeq_epi8(_mm_max_epu8(b1, minCode), b1));
+        __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(b0, prefix), code);
+        uint32_t mask = _mm_movemask_epi8(hit);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return scanMarkerScalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const uint8_t* scanMarkerAvx2(const uint8_t* begin, const uint8_t* end)
+{
+    const uint8_t* p = begin;
+    const __m256i prefix = _mm256_set1_epi8((char)MARKER_PREFIX);
+    const __m256i minCode = _mm256_set1_epi8((char)MIN_MARKER_CODE);
+    while (end - p >= 32 + 1) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(p + 1));
+        __m256i code = _mm256_andnot_si256(_mm256_cmpeq_epi8(b1, prefix),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(b1, minCode), b1));
+        __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(b0, prefix), code);
+        uint32_t mask = _mm256_movemask_epi8(hit);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scanMarkerSse2(p, end);
+}
+#endif
+
+static ZeroZeroByteScanner selectScanner()
+{
+#if YAMI_BYTESCAN_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scanAvx2;
+    if (__builtin_cpu_supports("sse2"))
+        return scanSse2;
+#endif
+    return scanScalar;
+}
+
+static JpegMarkerScanner selectMarkerScanner()
+{
+#if YAMI_BYTESCAN_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scanMarkerAvx2;
+    if (__builtin_cpu_supports("sse2"))
+        return scanMarkerSse2;
+#endif
+    return scanMarkerScalar;
+}
+
+const uint8_t* findZeroZeroByte(const uint8_t* begin, const uint8_t* end, uint8_t third)
+{
+    static const ZeroZeroByteScanner scan = selectScanner();
+    if (begin >= end)
+        return end;
+    return scan(begin, end, third);
+}
+
+const uint8_t* findJpegMarker(const uint8_t* begin, const uint8_t* end)
+{
+    static const JpegMarkerScanner scan = selectMarkerScanner();
+    if (begin >= end)
+        return end;
+    return scan(begin, end);
+}
+
+} //namespace YamiMediaCodec
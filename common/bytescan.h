@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2016 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef bytescan_h
+#define bytescan_h
+
+#include <stdint.h>
+
+namespace YamiMediaCodec {
+
+/* find the first 0x00 0x00 |third| sequence in [begin, end), return end if there is none.
+ * third is 0x01 for a start code prefix and 0x03 for an emulation prevention byte.
+ * uses SSE2/AVX2 when the cpu supports them */
+const uint8_t* findZeroZeroByte(const uint8_t* begin, const uint8_t* end, uint8_t third);
+
+/* find the first 0xFF followed by a jpeg marker code (0xC0 to 0xFE) in [begin, end),
+ * return end if there is none. Stuffed 0xFF 0x00 and 0xFF fill bytes are skipped.
+ * uses SSE2/AVX2 when the cpu supports them */
+const uint8_t* findJpegMarker(const uint8_t* begin, const uint8_t* end);
+
+} //namespace YamiMediaCodec
+
+#endif //bytescan_h
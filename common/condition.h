@@ -21,6 +21,9 @@
 
 #include "lock.h"
 
+#include <errno.h>
+#include <time.h>
+
 namespace YamiMediaCodec{
 
 class Condition
@@ -28,7 +31,12 @@ class Condition
 public:
     explicit Condition(Lock& lock):m_lock(lock)
     {
-        pthread_cond_init(&m_cond, NULL);
+        //timedwait deadlines are on the monotonic clock
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&m_cond, &attr);
+        pthread_condattr_destroy(&attr);
     }
 
     ~Condition()
@@ -41,6 +49,12 @@ public:
         pthread_cond_wait(&m_cond, &m_lock.m_lock);
     }
 
+    //return false if deadline (CLOCK_MONOTONIC) passed before we got signaled
+    bool timedwait(const struct timespec& deadline)
+    {
+        return pthread_cond_timedwait(&m_cond, &m_lock.m_lock, &deadline) != ETIMEDOUT;
+    }
+
     void signal()
     {
         pthread_cond_signal(&m_cond);
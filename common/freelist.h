@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef freelist_h
+#define freelist_h
+
+#include "common/NonCopyable.h"
+
+#include <atomic>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace YamiMediaCodec {
+
+/* bounded multi-producer multi-consumer fifo without locks, used for the
+ * free items of the pools. every cell carries a sequence number telling
+ * which round of push or pop may use it next, so a stale index can never
+ * be mistaken for a fresh one (no ABA). push fails only when full, pop
+ * only when empty; one meeting a cell that another thread has claimed but
+ * not finished retries until that thread is done with it. */
+template <class T>
+class FreeList {
+public:
+    //room for at least capacity items
+    explicit FreeList(size_t capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        m_mask = size - 1;
+        m_cells = new Cell[size];
+        for (size_t i = 0; i < size; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~FreeList()
+    {
+        delete[] m_cells;
+    }
+
+    bool push(const T& t)
+    {
+        Cell* cell;
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (!diff) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                if ((intptr_t)(pos - m_head.load(std::memory_order_acquire)) > (intptr_t)m_mask)
+                    return false;
+                //still being popped, let that thread finish
+                sched_yield();
+                pos = m_tail.load(std::memory_order_relaxed);
+            } else {
+                //taken by another push
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = t;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& t)
+    {
+        Cell* cell;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (!diff) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                if (m_tail.load(std::memory_order_acquire) == pos)
+                    return false;
+                //still being pushed, let that thread finish
+                sched_yield();
+                pos = m_head.load(std::memory_order_relaxed);
+            } else {
+                //taken by another pop
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        t = cell->data;
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    //keep the two ends on their own cache lines
+    enum { CACHE_LINE = 64 };
+    Cell* m_cells;
+    size_t m_mask;
+    char m_pad0[CACHE_LINE];
+    std::atomic<size_t> m_head;
+    char m_pad1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail;
+    char m_pad2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    DISALLOW_COPY_AND_ASSIGN(FreeList);
+};
+}
+
+#endif
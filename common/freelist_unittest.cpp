@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "freelist.h"
+
+#include "common/Thread.h"
+#include "common/unittest.h"
+
+#include <vector>
+
+namespace YamiMediaCodec {
+
+using std::bind;
+using std::ref;
+
+#define FREE_LIST_TEST(name) \
+    TEST(FreeListTest, name)
+
+FREE_LIST_TEST(Fifo)
+{
+    FreeList<int> list(3);
+    int v;
+
+    EXPECT_FALSE(list.pop(v));
+    EXPECT_TRUE(list.push(1));
+    EXPECT_TRUE(list.push(2));
+    EXPECT_TRUE(list.pop(v));
+    EXPECT_EQ(1, v);
+    EXPECT_TRUE(list.push(3));
+    EXPECT_TRUE(list.pop(v));
+    EXPECT_EQ(2, v);
+    EXPECT_TRUE(list.pop(v));
+    EXPECT_EQ(3, v);
+    EXPECT_FALSE(list.pop(v));
+}
+
+FREE_LIST_TEST(Full)
+{
+    //rounded up to a power of two
+    FreeList<int> list(3);
+    int v;
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++)
+            EXPECT_TRUE(list.push(i));
+        EXPECT_FALSE(list.push(4));
+        for (int i = 0; i < 4; i++) {
+            EXPECT_TRUE(list.pop(v));
+            EXPECT_EQ(i, v);
+        }
+        EXPECT_FALSE(list.pop(v));
+    }
+}
+
+static void takeAndGiveBack(FreeList<int>& list, std::vector<int>& owners,
+    int id, int count, bool& ok)
+{
+    for (int i = 0; i < count; i++) {
+        int v;
+        if (!list.pop(v))
+            continue;
+        //nobody else may hold v now
+        if (__sync_val_compare_and_swap(&owners[v], -1, id) != -1)
+            ok = false;
+        if (__sync_val_compare_and_swap(&owners[v], id, -1) != id)
+            ok = false;
+        if (!list.push(v))
+            ok = false;
+    }
+}
+
+FREE_LIST_TEST(Contention)
+{
+    const int items = 8;
+    const int threads = 8;
+    const int count = 20000;
+    FreeList<int> list(items);
+    std::vector<int> owners(items, -1);
+    for (int i = 0; i < items; i++)
+        EXPECT_TRUE(list.push(i));
+
+    std::vector<SharedPtr<Thread> > workers;
+    bool ok[threads];
+    for (int i = 0; i < threads; i++) {
+        ok[i] = true;
+        workers.push_back(SharedPtr<Thread>(new Thread));
+        ASSERT_TRUE(workers[i]->start());
+        workers[i]->post(bind(takeAndGiveBack, ref(list), ref(owners), i, count, ref(ok[i])));
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i]->stop();
+        EXPECT_TRUE(ok[i]);
+    }
+
+    //every item is back, exactly once
+    std::vector<int> seen(items, 0);
+    int v;
+    while (list.pop(v))
+        seen[v]++;
+    for (int i = 0; i < items; i++)
+        EXPECT_EQ(1, seen[i]);
+}
+}
@@ -18,8 +18,8 @@
 #include "config.h"
 #endif
 
-#include <algorithm>
 #include "nalreader.h"
+#include "bytescan.h"
 
 namespace YamiMediaCodec{
 
@@ -55,11 +55,10 @@ bool NalReader::read(const uint8_t*& nal, int32_t& nalSize)
 
 static const uint8_t START_CODE[] = { 0, 0, 1 };
 static const int START_CODE_SIZE = 3;
-static const uint8_t* START_CODE_END = START_CODE + START_CODE_SIZE;
 
 const uint8_t* NalReader::searchStartCode()
 {
-    m_begin = std::search(m_next, m_end, START_CODE, START_CODE_END);
+    m_begin = findZeroZeroByte(m_next, m_end, START_CODE[START_CODE_SIZE - 1]);
 
     if (m_begin != m_end) {
         m_next = m_begin + START_CODE_SIZE;
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "nalreader.h"
+
+#include "common/benchmark.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+
+//start code search throughput of NalReader against the byte loop it replaced.
+//usage: nalreader_bench [-n loops] [annexb file ...]
+//without files it scans 64 MiB of random data with a start code every 50000 bytes.
+
+static const int DEFAULT_LOOPS = 20;
+
+static uint32_t countScalar(const std::vector<uint8_t>& data)
+{
+    static const uint8_t startCode[] = { 0, 0, 1 };
+    const uint8_t* p = &data[0];
+    const uint8_t* end = p + data.size();
+    uint32_t nals = 0;
+    while ((p = std::search(p, end, startCode, startCode + 3)) != end) {
+        nals++;
+        p += 3;
+    }
+    return nals;
+}
+
+static uint32_t countNalReader(const std::vector<uint8_t>& data)
+{
+    NalReader reader(&data[0], data.size());
+    const uint8_t* nal;
+    int32_t size;
+    uint32_t nals = 0;
+    while (reader.read(nal, size))
+        nals++;
+    return nals;
+}
+
+static void run(const char* name, const std::vector<uint8_t>& data, int loops)
+{
+    uint32_t scalarNals = 0, nals = 0;
+    double t = benchNow();
+    for (int i = 0; i < loops; i++)
+        scalarNals = countScalar(data);
+    double scalar = benchNow() - t;
+
+    t = benchNow();
+    for (int i = 0; i < loops; i++)
+        nals = countNalReader(data);
+    double reader = benchNow() - t;
+
+    double bytes = (double)data.size() * loops;
+    printf("%s: %zu bytes, %u nals, byte loop %.2f GB/s, NalReader %.2f GB/s%s\n",
+        name, data.size(), nals, bytes / scalar / 1e9, bytes / reader / 1e9,
+        scalarNals == nals ? "" : " (nal count mismatch)");
+}
+
+int main(int argc, char** argv)
+{
+    int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n loops] [annexb file ...]\n", argv[0]);
+            return -1;
+        }
+        loops = atoi(optarg);
+    }
+    if (loops < 1)
+        loops = DEFAULT_LOOPS;
+
+    std::vector<uint8_t> data;
+    if (optind == argc) {
+        //entropy coded like, no zero pairs except the start codes
+        data.resize(64 << 20);
+        srand(1);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = rand() % 255 + 1;
+        for (size_t i = 100; i < data.size(); i += 97)
+            data[i] = 0;
+        for (size_t i = 0; i + 3 <= data.size(); i += 50000) {
+            data[i] = 0;
+            data[i + 1] = 0;
+            data[i + 2] = 1;
+        }
+        run("synthetic", data, loops);
+        return 0;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (!benchReadFile(argv[i], data) || data.empty())
+            return -1;
+        run(argv[i], data, loops);
+    }
+    return 0;
+}
@@ -25,6 +25,9 @@
 #include "common/Array.h"
 #include "common/unittest.h"
 
+// system headers
+#include <vector>
+
 namespace YamiMediaCodec {
 
 #define NALREADER_TEST(name) \
@@ -121,4 +124,32 @@ NALREADER_TEST(ReadNoPrefix) {
     EXPECT_FALSE(reader.read(nal, size));
 }
 
+NALREADER_TEST(ReadStartCodeAtAnyOffset) {
+    //start codes may sit anywhere inside or across the blocks the
+    //vectorized scanner examines, including the unaligned tail.
+    for (size_t len(3); len < 100; ++len) {
+        for (size_t pos(0); pos + 3 <= len; ++pos) {
+            std::vector<uint8_t> data(len, 0xff);
+            data[pos] = 0x00;
+            data[pos + 1] = 0x00;
+            data[pos + 2] = 0x01;
+            //lone zeros next to the start code must not confuse the scan
+            if (pos + 4 < len)
+                data[pos + 4] = 0x00;
+            const uint8_t* nal;
+            int32_t size;
+
+            NalReader reader(&data[0], data.size(), 0, false);
+            if (pos + 3 == len) {
+                EXPECT_FALSE(reader.read(nal, size));
+                continue;
+            }
+            EXPECT_TRUE(reader.read(nal, size));
+            EXPECT_EQ(&data[pos + 3], nal);
+            EXPECT_EQ(int32_t(len - pos - 3), size);
+            EXPECT_FALSE(reader.read(nal, size));
+        }
+    }
+}
+
 }
@@ -16,7 +16,8 @@
 #ifndef videopool_h
 #define videopool_h
 #include "VideoCommonDefs.h"
-#include "common/lock.h"
+#include "common/freelist.h"
+#include <assert.h>
 #include <deque>
 
 namespace YamiMediaCodec{
@@ -26,31 +27,31 @@ class VideoPool : public EnableSharedFromThis<VideoPool<T> >
 {
 public:
     VideoPool(std::deque<SharedPtr<T> >& buffers)
+        : m_freed(buffers.size())
     {
             m_holder.swap(buffers);
             for (size_t i = 0; i < m_holder.size(); i++) {
-                m_freed.push_back(m_holder[i].get());
+                m_freed.push(m_holder[i].get());
             }
     }
 
     SharedPtr<T> alloc()
     {
         SharedPtr<T> ret;
-        AutoLock _l(m_lock);
-        if (!m_freed.empty()) {
-            T* p = m_freed.front();
-            m_freed.pop_front();
+        T* p;
+        if (m_freed.pop(p))
             ret.reset(p, Recycler(this->shared_from_this()));
-        }
         return ret;
     }
 
 private:
 
+    //called from whichever thread drops the last reference
     void recycle(T* ptr)
     {
-        AutoLock _l(m_lock);
-        m_freed.push_back(ptr);
+        bool ret = m_freed.push(ptr);
+        assert(ret && "recycled more than allocated");
+        (void)ret;
     }
 
     class Recycler
@@ -68,8 +69,7 @@ private:
         SharedPtr<VideoPool<T> > m_pool;
     };
 
-    Lock m_lock;
-    std::deque<T*> m_freed;
+    FreeList<T*> m_freed;
     std::deque<SharedPtr<T> > m_holder;
 };
 
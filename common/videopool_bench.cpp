@@ -0,0 +1,104 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "videopool.h"
+
+#include "common/Thread.h"
+#include "common/benchmark.h"
+#include "common/common_def.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace YamiMediaCodec;
+using std::bind;
+using std::ref;
+
+//VideoPool alloc and recycle from 1 to 16 threads sharing one pool.
+//usage: videopool_bench [-n allocs per thread]
+
+static const int DEFAULT_COUNT = 100000;
+static const int POOL_SIZE = 16;
+
+typedef VideoPool<int> IntPool;
+
+static void hammer(const SharedPtr<IntPool>& pool, int count, int& allocated)
+{
+    SharedPtr<int> held;
+    for (int i = 0; i < count; i++) {
+        SharedPtr<int> p = pool->alloc();
+        if (!p)
+            continue;
+        allocated++;
+        //hold every other one until the next, so items change hands unevenly
+        if (i & 1)
+            held.swap(p);
+    }
+}
+
+static void run(int threads, int count)
+{
+    std::deque<SharedPtr<int> > buffers;
+    for (int i = 0; i < POOL_SIZE; i++)
+        buffers.push_back(SharedPtr<int>(new int(i)));
+    SharedPtr<IntPool> pool(new IntPool(buffers));
+
+    std::vector<SharedPtr<Thread> > workers;
+    std::vector<int> allocated(threads, 0);
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(SharedPtr<Thread>(new Thread));
+        if (!workers[i]->start()) {
+            fprintf(stderr, "can't start thread\n");
+            return;
+        }
+    }
+
+    double t = benchNow();
+    for (int i = 0; i < threads; i++)
+        workers[i]->post(bind(hammer, pool, count, ref(allocated[i])));
+    int total = 0;
+    for (int i = 0; i < threads; i++) {
+        workers[i]->stop();
+        total += allocated[i];
+    }
+    t = benchNow() - t;
+    printf("%2d threads: %6.1f ns per alloc, %d of %d succeeded\n", threads,
+        t * 1e9 / (threads * count), total, threads * count);
+}
+
+int main(int argc, char** argv)
+{
+    int count = DEFAULT_COUNT;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt != 'n') {
+            fprintf(stderr, "usage: %s [-n allocs per thread]\n", argv[0]);
+            return -1;
+        }
+        count = atoi(optarg);
+    }
+    if (count < 1)
+        count = DEFAULT_COUNT;
+
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    for (size_t i = 0; i < N_ELEMENTS(threadCounts); i++)
+        run(threadCounts[i], count);
+    return 0;
+}
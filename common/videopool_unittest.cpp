@@ -0,0 +1,121 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "videopool.h"
+
+#include "common/Thread.h"
+#include "common/common_def.h"
+#include "common/unittest.h"
+
+#include <atomic>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+using std::bind;
+using std::ref;
+
+#define VIDEO_POOL_TEST(name) \
+    TEST(VideoPoolTest, name)
+
+typedef VideoPool<int> IntPool;
+
+static SharedPtr<IntPool> createPool(int size)
+{
+    std::deque<SharedPtr<int> > buffers;
+    for (int i = 0; i < size; i++)
+        buffers.push_back(SharedPtr<int>(new int(i)));
+    return SharedPtr<IntPool>(new IntPool(buffers));
+}
+
+VIDEO_POOL_TEST(AllocAndRecycle)
+{
+    SharedPtr<IntPool> pool = createPool(2);
+
+    SharedPtr<int> a = pool->alloc();
+    SharedPtr<int> b = pool->alloc();
+    ASSERT_TRUE(bool(a));
+    ASSERT_TRUE(bool(b));
+    EXPECT_EQ(0, *a);
+    EXPECT_EQ(1, *b);
+    EXPECT_FALSE(pool->alloc());
+
+    //first recycled, first reused
+    b.reset();
+    a.reset();
+    SharedPtr<int> c = pool->alloc();
+    ASSERT_TRUE(bool(c));
+    EXPECT_EQ(1, *c);
+}
+
+typedef std::vector<SharedPtr<std::atomic<int> > > Owners;
+
+//every item must have one owner at a time
+static void hammer(const SharedPtr<IntPool>& pool, int count, Owners& owners, int& errors)
+{
+    SharedPtr<int> held;
+    for (int i = 0; i < count; i++) {
+        SharedPtr<int> p = pool->alloc();
+        if (!p)
+            continue;
+        if (owners[*p]->exchange(1))
+            errors++;
+        //hold every other one until the next, so items change hands unevenly
+        if (i & 1)
+            held.swap(p);
+        if (p)
+            owners[*p]->store(0);
+    }
+    if (held)
+        owners[*held]->store(0);
+}
+
+//alloc and recycle from several threads, see videopool_bench for timing
+VIDEO_POOL_TEST(Contention)
+{
+    const int size = 4;
+    const int threads = 4;
+    const int count = 2000;
+
+    SharedPtr<IntPool> pool = createPool(size);
+    Owners owners;
+    for (int i = 0; i < size; i++)
+        owners.push_back(SharedPtr<std::atomic<int> >(new std::atomic<int>(0)));
+    std::vector<SharedPtr<Thread> > workers;
+    std::vector<int> errors(threads, 0);
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(SharedPtr<Thread>(new Thread));
+        ASSERT_TRUE(workers[i]->start());
+    }
+    for (int i = 0; i < threads; i++)
+        workers[i]->post(bind(hammer, pool, count, ref(owners), ref(errors[i])));
+    for (int i = 0; i < threads; i++) {
+        workers[i]->stop();
+        EXPECT_EQ(0, errors[i]);
+    }
+
+    //everything came back
+    std::vector<SharedPtr<int> > all;
+    SharedPtr<int> p;
+    while ((p = pool->alloc()))
+        all.push_back(p);
+    EXPECT_EQ((size_t)size, all.size());
+}
+}
@@ -42,6 +42,9 @@
 #include <algorithm>
 #include <stdint.h>
 #include <deque>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
 
 namespace YamiMediaCodec {
 
@@ -456,6 +459,234 @@ TEST_P(DecodeApiTest, Flush)
     EXPECT_EQ(outFrames, size);
 }
 
+TEST_P(DecodeApiTest, GetOutputs)
+{
+    NativeDisplay nativeDisplay;
+    memset(&nativeDisplay, 0, sizeof(nativeDisplay));
+    DisplayPtr display = VaapiDisplay::create(nativeDisplay);
+
+    SharedPtr<IVideoDecoder> decoder;
+    TestDecodeFrames frames = *GetParam();
+    decoder.reset(createVideoDecoder(frames.getMime()), releaseVideoDecoder);
+    ASSERT_TRUE(bool(decoder));
+    DecodeSurfaceAllocator* allocator = new DecodeSurfaceAllocator(display);
+
+    decoder->setAllocator(allocator);
+
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    ASSERT_EQ(YAMI_SUCCESS, decoder->start(&config));
+
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    FrameInfo info;
+    uint32_t inFrames = 0;
+    uint32_t outFrames = 0;
+    std::vector<SharedPtr<VideoFrame> > outputs;
+
+    while (frames.getFrame(buffer, info)) {
+        YamiStatus status = decoder->decode(&buffer);
+        if (status == YAMI_DECODE_FORMAT_CHANGE) {
+            allocator->onFormatChange(decoder->getFormatInfo());
+            status = decoder->decode(&buffer);
+            if (YAMI_UNSUPPORTED == status) {
+                RecordProperty("skipped", true);
+                std::cout << "[  SKIPPED ] " << getFullTestName()
+                          << " Hw does not support this decoder." << std::endl;
+                return;
+            }
+        }
+        EXPECT_EQ(YAMI_SUCCESS, status);
+        inFrames++;
+        //frames are appended
+        outputs.resize(1);
+        uint32_t n = decoder->getOutputs(2, outputs);
+        EXPECT_LE(n, 2u);
+        EXPECT_EQ(n + 1, outputs.size());
+        outFrames += n;
+        outputs.clear();
+    }
+    EXPECT_EQ(YAMI_SUCCESS, decoder->decode(NULL));
+    uint32_t n = decoder->getOutputs(UINT32_MAX, outputs);
+    EXPECT_EQ(n, outputs.size());
+    outFrames += n;
+    EXPECT_EQ(0u, decoder->getOutputs(UINT32_MAX, outputs));
+    EXPECT_FALSE(decoder->getOutput());
+    EXPECT_EQ(inFrames, outFrames);
+}
+
+TEST_P(DecodeApiTest, PackedSlices)
+{
+    NativeDisplay nativeDisplay;
+    memset(&nativeDisplay, 0, sizeof(nativeDisplay));
+    DisplayPtr display = VaapiDisplay::create(nativeDisplay);
+
+    SharedPtr<IVideoDecoder> decoder;
+    TestDecodeFrames frames = *GetParam();
+    decoder.reset(createVideoDecoder(frames.getMime()), releaseVideoDecoder);
+    ASSERT_TRUE(bool(decoder));
+    DecodeSurfaceAllocator* allocator = new DecodeSurfaceAllocator(display);
+
+    decoder->setAllocator(allocator);
+
+    //decoders without packed slices support ignore the flag
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    config.flag = ENABLE_PACKED_SLICES;
+    ASSERT_EQ(YAMI_SUCCESS, decoder->start(&config));
+
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    FrameInfo info;
+    uint32_t inFrames = 0;
+    uint32_t outFrames = 0;
+
+    while (frames.getFrame(buffer, info)) {
+        YamiStatus status = decoder->decode(&buffer);
+        if (status == YAMI_DECODE_FORMAT_CHANGE) {
+            allocator->onFormatChange(decoder->getFormatInfo());
+            status = decoder->decode(&buffer);
+            if (YAMI_UNSUPPORTED == status) {
+                RecordProperty("skipped", true);
+                std::cout << "[  SKIPPED ] " << getFullTestName()
+                          << " Hw does not support this decoder." << std::endl;
+                return;
+            }
+        }
+        EXPECT_EQ(YAMI_SUCCESS, status);
+        inFrames++;
+        while (decoder->getOutput())
+            outFrames++;
+    }
+    EXPECT_EQ(YAMI_SUCCESS, decoder->decode(NULL));
+    while (decoder->getOutput())
+        outFrames++;
+    EXPECT_EQ(inFrames, outFrames);
+}
+
+TEST_P(DecodeApiTest, PipelinedRestart)
+{
+    NativeDisplay nativeDisplay;
+    memset(&nativeDisplay, 0, sizeof(nativeDisplay));
+    DisplayPtr display = VaapiDisplay::create(nativeDisplay);
+
+    SharedPtr<IVideoDecoder> decoder;
+    TestDecodeFrames frames = *GetParam();
+    decoder.reset(createVideoDecoder(frames.getMime()), releaseVideoDecoder);
+    ASSERT_TRUE(bool(decoder));
+    DecodeSurfaceAllocator* allocator = new DecodeSurfaceAllocator(display);
+
+    decoder->setAllocator(allocator);
+
+    //turning the pipeline off and on again must not block,
+    //decoders without pipelined parsing ignore the flag
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    config.flag = ENABLE_PIPELINED_PARSING;
+    ASSERT_EQ(YAMI_SUCCESS, decoder->start(&config));
+    config.flag = 0;
+    ASSERT_EQ(YAMI_SUCCESS, decoder->reset(&config));
+    config.flag = ENABLE_PIPELINED_PARSING;
+    ASSERT_EQ(YAMI_SUCCESS, decoder->reset(&config));
+
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    FrameInfo info;
+    uint32_t inFrames = 0;
+    uint32_t outFrames = 0;
+
+    while (frames.getFrame(buffer, info)) {
+        YamiStatus status = decoder->decode(&buffer);
+        if (status == YAMI_DECODE_FORMAT_CHANGE) {
+            allocator->onFormatChange(decoder->getFormatInfo());
+            status = decoder->decode(&buffer);
+            if (YAMI_UNSUPPORTED == status) {
+                RecordProperty("skipped", true);
+                std::cout << "[  SKIPPED ] " << getFullTestName()
+                          << " Hw does not support this decoder." << std::endl;
+                return;
+            }
+        }
+        EXPECT_EQ(YAMI_SUCCESS, status);
+        inFrames++;
+        while (decoder->getOutput())
+            outFrames++;
+    }
+    EXPECT_EQ(YAMI_SUCCESS, decoder->decode(NULL));
+    while (decoder->getOutput())
+        outFrames++;
+    EXPECT_EQ(inFrames, outFrames);
+}
+
+static void countOutput(void* user)
+{
+    __sync_fetch_and_add((int32_t*)user, 1);
+}
+
+TEST_P(DecodeApiTest, AsyncOutput)
+{
+    NativeDisplay nativeDisplay;
+    memset(&nativeDisplay, 0, sizeof(nativeDisplay));
+    DisplayPtr display = VaapiDisplay::create(nativeDisplay);
+
+    SharedPtr<IVideoDecoder> decoder;
+    TestDecodeFrames frames = *GetParam();
+    decoder.reset(createVideoDecoder(frames.getMime()), releaseVideoDecoder);
+    ASSERT_TRUE(bool(decoder));
+    DecodeSurfaceAllocator* allocator = new DecodeSurfaceAllocator(display);
+
+    decoder->setAllocator(allocator);
+
+    EXPECT_EQ(-1, decoder->getOutputEventFd());
+    int32_t ready = 0;
+    ASSERT_EQ(YAMI_SUCCESS, decoder->enableAsyncOutput(countOutput, &ready));
+    int fd = decoder->getOutputEventFd();
+    ASSERT_NE(-1, fd);
+
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    ASSERT_EQ(YAMI_SUCCESS, decoder->start(&config));
+    EXPECT_NE(YAMI_SUCCESS, decoder->enableAsyncOutput(countOutput, &ready));
+
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    FrameInfo info;
+    int32_t inFrames = 0;
+    int32_t outFrames = 0;
+    SharedPtr<VideoFrame> output;
+
+    while (frames.getFrame(buffer, info)) {
+        YamiStatus status = decoder->decode(&buffer);
+        if (status == YAMI_DECODE_FORMAT_CHANGE) {
+            allocator->onFormatChange(decoder->getFormatInfo());
+            status = decoder->decode(&buffer);
+            if (YAMI_UNSUPPORTED == status) {
+                RecordProperty("skipped", true);
+                std::cout << "[  SKIPPED ] " << getFullTestName()
+                          << " Hw does not support this decoder." << std::endl;
+                return;
+            }
+        }
+        EXPECT_EQ(YAMI_SUCCESS, status);
+        inFrames++;
+        while ((output = decoder->getOutput()))
+            outFrames++;
+    }
+    EXPECT_EQ(YAMI_SUCCESS, decoder->decode(NULL));
+
+    //the event fd wakes us up until all frames are out
+    while (outFrames < inFrames) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        ASSERT_EQ(1, poll(&pfd, 1, 5000));
+        uint64_t count;
+        ASSERT_EQ((ssize_t)sizeof(count), read(fd, &count, sizeof(count)));
+        while ((output = decoder->getOutput()))
+            outFrames++;
+    }
+    EXPECT_EQ(inFrames, outFrames);
+    EXPECT_EQ(outFrames, __sync_fetch_and_add(&ready, 0));
+}
+
 TEST_P(DecodeApiTestLowlatency, Format_Change)
 {
     SharedPtr<IVideoDecoder> decoder;
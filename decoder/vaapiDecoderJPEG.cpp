@@ -22,19 +22,26 @@
 #include "vaapiDecoderJPEG.h"
 
 // library headers
+#include "codecparsers/jpegDecoder.h"
 #include "codecparsers/jpegParser.h"
 #include "common/common_def.h"
+#include "vaapi/VaapiUtils.h"
 
 // system headers
+#include <algorithm>
 #include <cassert>
+#include <stdlib.h>
+#include <unistd.h>
 
 using ::YamiParser::JPEG::Component;
+using ::YamiParser::JPEG::Decoder;
 using ::YamiParser::JPEG::FrameHeader;
 using ::YamiParser::JPEG::HuffTable;
 using ::YamiParser::JPEG::HuffTables;
 using ::YamiParser::JPEG::Parser;
 using ::YamiParser::JPEG::QuantTable;
 using ::YamiParser::JPEG::QuantTables;
+using ::YamiParser::JPEG::RestartIntervals;
 using ::YamiParser::JPEG::ScanHeader;
 using ::YamiParser::JPEG::Defaults;
 using ::std::function;
@@ -45,6 +52,16 @@ namespace YamiMediaCodec {
 
 #define JPEG_SURFACE_NUM 2
 
+//restart intervals are grouped into at most this many slices
+#define JPEG_MAX_SLICES 32
+
+//images up to this size are decoded on the cpu. off by default until the
+//VA round trip is measured on real hardware, LIBYAMI_JPEG_CPU_PIXELS sets it
+#define JPEG_CPU_MAX_PIXELS 0
+
+//threads decoding the restart intervals of a cpu decoded image
+#define JPEG_CPU_MAX_THREADS 4
+
 struct Slice {
     Slice() : data(NULL), start(0) , length(0) { }
 
@@ -79,18 +96,23 @@ public:
         if (!data || !size)
             return YAMI_SUCCESS;
 
-        Parser::Callback defaultCallback =
-            bind(&Impl::onMarker, ref(*this));
-        Parser::Callback sofCallback =
-            bind(&Impl::onStartOfFrame, ref(*this));
         m_slice.data = data;
-        m_parser.reset(new Parser(data, size));
-        m_parser->registerCallback(M_SOI, defaultCallback);
-        m_parser->registerCallback(M_EOI, defaultCallback);
-        m_parser->registerCallback(M_SOS, defaultCallback);
-        m_parser->registerCallback(M_DHT, defaultCallback);
-        m_parser->registerCallback(M_DQT, defaultCallback);
-        m_parser->registerStartOfFrameCallback(sofCallback);
+        if (m_parser) {
+            // keep the callbacks and tables, mjpeg frames come one by one
+            m_parser->reset(data, size);
+        } else {
+            Parser::Callback defaultCallback =
+                bind(&Impl::onMarker, ref(*this));
+            Parser::Callback sofCallback =
+                bind(&Impl::onStartOfFrame, ref(*this));
+            m_parser.reset(new Parser(data, size));
+            m_parser->registerCallback(M_SOI, defaultCallback);
+            m_parser->registerCallback(M_EOI, defaultCallback);
+            m_parser->registerCallback(M_SOS, defaultCallback);
+            m_parser->registerCallback(M_DHT, defaultCallback);
+            m_parser->registerCallback(M_DQT, defaultCallback);
+            m_parser->registerStartOfFrameCallback(sofCallback);
+        }
 
         if (!m_parser->parse())
             m_decodeStatus = YAMI_FAIL;
@@ -113,6 +135,13 @@ public:
         return m_parser->restartInterval();
     }
 
+    // entropy coded segments of the last scan, each one can be decoded
+    // independently of the others
+    const RestartIntervals& restartIntervals() const
+    {
+        return m_parser->restartIntervals();
+    }
+
     const HuffTables& dcHuffmanTables() const { return m_dcHuffmanTables; }
     const HuffTables& acHuffmanTables() const { return m_acHuffmanTables; }
     const QuantTables& quantTables() const { return m_quantizationTables; }
@@ -180,10 +209,22 @@ private:
     YamiStatus m_decodeStatus;
 };
 
+//a picture decoded on the cpu, it only carries the surface to the output
+class CpuDecPicture : public VaapiDecPicture {
+public:
+    CpuDecPicture(const SurfacePtr& surface, int64_t timeStamp)
+    {
+        setSurface(surface);
+        m_timeStamp = timeStamp;
+    }
+};
+
 VaapiDecoderJPEG::VaapiDecoderJPEG()
     : VaapiDecoderBase::VaapiDecoderBase()
     , m_impl()
     , m_picture()
+    , m_vaUnsupported(false)
+    , m_upsample(false)
 {
     return;
 }
@@ -223,24 +264,8 @@ YamiStatus VaapiDecoderJPEG::fillSliceParam()
     const ScanHeader::Shared scan = m_impl->scanHeader();
     const FrameHeader::Shared frame = m_impl->frameHeader();
     const Slice& slice = m_impl->slice();
-    VASliceParameterBufferJPEGBaseline *sliceParam(NULL);
-
-    if (!m_picture->newSlice(sliceParam, slice.data + slice.start, slice.length))
-        return YAMI_FAIL;
-
-    for (size_t i(0); i < scan->numComponents; ++i) {
-        sliceParam->components[i].component_selector =
-            scan->components[i]->id;
-        sliceParam->components[i].dc_table_selector =
-            scan->components[i]->dcTableNumber;
-        sliceParam->components[i].ac_table_selector =
-            scan->components[i]->acTableNumber;
-    }
-
-    sliceParam->restart_interval = m_impl->restartInterval();
-    sliceParam->num_components = scan->numComponents;
-    sliceParam->slice_horizontal_position = 0;
-    sliceParam->slice_vertical_position = 0;
+    const RestartIntervals& intervals = m_impl->restartIntervals();
+    const uint32_t restartInterval = m_impl->restartInterval();
 
     int width = frame->imageWidth;
     int height = frame->imageHeight;
@@ -264,7 +289,55 @@ YamiStatus VaapiDecoderJPEG::fillSliceParam()
         codedHeight = (height + maxVSample - 1) / maxVSample;
     }
 
-    sliceParam->num_mcus = codedWidth * codedHeight;
+    const uint32_t numMcus = codedWidth * codedHeight;
+
+    /* each restart interval starts on a known mcu, so the scan can be
+     * sent as several slices the driver may decode in parallel. Fall back
+     * to one slice if the index doesn't match the image (missing or extra
+     * RSTn markers) */
+    uint32_t numIntervals = 1;
+    uint32_t intervalsPerSlice = 1;
+    if (restartInterval && codedWidth) {
+        numIntervals = (numMcus + restartInterval - 1) / restartInterval;
+        if (numIntervals > 1 && numIntervals == intervals.size())
+            intervalsPerSlice = (numIntervals + JPEG_MAX_SLICES - 1) / JPEG_MAX_SLICES;
+        else
+            numIntervals = 1;
+    }
+
+    for (uint32_t first = 0; first < numIntervals; first += intervalsPerSlice) {
+        const uint32_t last = std::min(first + intervalsPerSlice, numIntervals) - 1;
+        const uint8_t* data = slice.data + slice.start;
+        uint32_t size = slice.length;
+        uint32_t mcu = 0;
+        if (numIntervals > 1) {
+            data = slice.data + intervals[first].offset;
+            size = intervals[last].offset + intervals[last].size
+                - intervals[first].offset;
+            mcu = first * restartInterval;
+        }
+
+        VASliceParameterBufferJPEGBaseline* sliceParam(NULL);
+        if (!m_picture->newSlice(sliceParam, data, size))
+            return YAMI_FAIL;
+
+        for (size_t i(0); i < scan->numComponents; ++i) {
+            sliceParam->components[i].component_selector =
+                scan->components[i]->id;
+            sliceParam->components[i].dc_table_selector =
+                scan->components[i]->dcTableNumber;
+            sliceParam->components[i].ac_table_selector =
+                scan->components[i]->acTableNumber;
+        }
+
+        sliceParam->restart_interval = restartInterval;
+        sliceParam->num_components = scan->numComponents;
+        sliceParam->slice_horizontal_position = codedWidth ? mcu % codedWidth : 0;
+        sliceParam->slice_vertical_position = codedWidth ? mcu / codedWidth : 0;
+        sliceParam->num_mcus = numIntervals > 1
+            ? std::min((last - first + 1) * restartInterval, numMcus - mcu)
+            : numMcus;
+    }
 
     return YAMI_SUCCESS;
 }
@@ -366,7 +439,7 @@ static uint32_t getFourcc(const FrameHeader::Shared& frame)
         RETURN_FORMAT(YAMI_FOURCC_Y800);
 
     if (frame->components.size() != 3) {
-        ERROR("unsupported component size %d", (int)frame->components.size());
+        DEBUG("no format for %d components", (int)frame->components.size());
         return 0;
     }
     int h1 = frame->components[0]->hSampleFactor;
@@ -376,7 +449,7 @@ static uint32_t getFourcc(const FrameHeader::Shared& frame)
     int v2 = frame->components[1]->vSampleFactor;
     int v3 = frame->components[2]->vSampleFactor;
     if (h2 != h3 || v2 != v3) {
-        ERROR("unsupported format h1 = %d, h2 = %d, h3 = %d, v1 = %d, v2 = %d, v3 = %d", h1, h2, h3, v1, v2, v3);
+        DEBUG("no format for h1 = %d, h2 = %d, h3 = %d, v1 = %d, v2 = %d, v3 = %d", h1, h2, h3, v1, v2, v3);
         return 0;
     }
     if (h1 == h2) {
@@ -391,7 +464,7 @@ static uint32_t getFourcc(const FrameHeader::Shared& frame)
         if (v1 == 2 * v2)
             RETURN_FORMAT(YAMI_FOURCC_IMC3);
     }
-    ERROR("unsupported format h1 = %d, h2 = %d, h3 = %d, v1 = %d, v2 = %d, v3 = %d", h1, h2, h3, v1, v2, v3);
+    DEBUG("no format for h1 = %d, h2 = %d, h3 = %d, v1 = %d, v2 = %d, v3 = %d", h1, h2, h3, v1, v2, v3);
     return 0;
 }
 
@@ -402,6 +475,149 @@ YamiStatus VaapiDecoderJPEG::start(VideoConfigBuffer* buffer)
     return YAMI_SUCCESS;
 }
 
+static uint32_t readCpuMaxPixels()
+{
+    const char* env = getenv("LIBYAMI_JPEG_CPU_PIXELS");
+    return env ? strtoul(env, NULL, 10) : JPEG_CPU_MAX_PIXELS;
+}
+
+static uint32_t cpuMaxPixels()
+{
+    //decoders may start on several threads, c++11 runs this once
+    static const uint32_t pixels = readCpuMaxPixels();
+    return pixels;
+}
+
+bool VaapiDecoderJPEG::useCpu() const
+{
+    const FrameHeader::Shared frame = m_impl->frameHeader();
+    if (!Decoder::isSupported(*frame, *m_impl->scanHeader()))
+        return false;
+    return m_upsample || m_vaUnsupported
+        || frame->imageWidth * frame->imageHeight <= cpuMaxPixels();
+}
+
+//a component plane is this big, see Decoder::decode
+static void getComponentSize(const FrameHeader& frame, const Component& component,
+    uint32_t& width, uint32_t& height)
+{
+    width = (frame.imageWidth * component.hSampleFactor + frame.maxHSampleFactor - 1)
+        / frame.maxHSampleFactor;
+    height = (frame.imageHeight * component.vSampleFactor + frame.maxVSampleFactor - 1)
+        / frame.maxVSampleFactor;
+}
+
+static bool isFullSize(const FrameHeader& frame, const Component& component)
+{
+    return component.hSampleFactor == frame.maxHSampleFactor
+        && component.vSampleFactor == frame.maxVSampleFactor;
+}
+
+//repeat the samples of a subsampled plane to the full image size
+static void upsamplePlane(const FrameHeader& frame, const Component& component,
+    const Decoder::Plane& src, const Decoder::Plane& dest)
+{
+    const uint32_t h = component.hSampleFactor;
+    const uint32_t v = component.vSampleFactor;
+    for (uint32_t y = 0; y < frame.imageHeight; y++) {
+        const uint8_t* s = src.data + (y * v / frame.maxVSampleFactor) * src.pitch;
+        uint8_t* d = dest.data + y * dest.pitch;
+        for (uint32_t x = 0; x < frame.imageWidth; x++)
+            d[x] = s[x * h / frame.maxHSampleFactor];
+    }
+}
+
+//subsampled components are decoded to buffer first
+static void setUpsamplePlanes(const FrameHeader::Shared& frame,
+    std::vector<uint8_t>& buffer, Decoder::Plane planes[])
+{
+    size_t size = 0;
+    for (size_t i(0); i < frame->components.size(); ++i) {
+        const Component& component = *frame->components[i];
+        uint32_t width, height;
+        getComponentSize(*frame, component, width, height);
+        if (!isFullSize(*frame, component))
+            size += width * height;
+    }
+    if (buffer.size() < size)
+        buffer.resize(size);
+
+    uint8_t* p = &buffer[0];
+    for (size_t i(0); i < frame->components.size(); ++i) {
+        const Component& component = *frame->components[i];
+        if (isFullSize(*frame, component))
+            continue;
+        uint32_t width, height;
+        getComponentSize(*frame, component, width, height);
+        planes[i].data = p;
+        planes[i].pitch = width;
+        p += width * height;
+    }
+}
+
+YamiStatus VaapiDecoderJPEG::finishOnCpu()
+{
+    const FrameHeader::Shared frame = m_impl->frameHeader();
+
+    if (!m_cpuDecoder) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        cpus = std::min(std::max(cpus, 1L), (long)JPEG_CPU_MAX_THREADS);
+        m_cpuDecoder.reset(new Decoder(cpus));
+    }
+
+    SurfacePtr surface = createSurface();
+    if (!surface)
+        return YAMI_DECODE_NO_SURFACE;
+    surface->setCrop(0, 0, m_videoFormatInfo.width, m_videoFormatInfo.height);
+
+    VAImage image;
+    VADisplay display = getDisplayID();
+    uint8_t* p = mapSurfaceToImage(display, surface->getID(), image);
+    if (!p) {
+        ERROR("map image failed");
+        return YAMI_FAIL;
+    }
+
+    const size_t numComponents = frame->components.size();
+    if (image.num_planes < numComponents) {
+        ERROR("surface has %d planes for %d components", image.num_planes,
+            (int)numComponents);
+        unmapImage(display, image);
+        return YAMI_FAIL;
+    }
+    Decoder::Plane planes[YamiParser::JPEG::MAX_COMPS_IN_SCAN];
+    for (size_t i(0); i < numComponents; ++i) {
+        planes[i].data = p + image.offsets[i];
+        planes[i].pitch = image.pitches[i];
+    }
+    //cr before cb
+    if (image.format.fourcc == YAMI_FOURCC_YV12)
+        std::swap(planes[1], planes[2]);
+    Decoder::Plane decoded[YamiParser::JPEG::MAX_COMPS_IN_SCAN];
+    std::copy(planes, planes + numComponents, decoded);
+    if (m_upsample)
+        setUpsamplePlanes(frame, m_upsampleBuffer, decoded);
+
+    const Slice& slice = m_impl->slice();
+    bool ok = m_cpuDecoder->decode(slice.data, *frame,
+        *m_impl->scanHeader(), m_impl->quantTables(),
+        m_impl->dcHuffmanTables(), m_impl->acHuffmanTables(),
+        m_impl->restartInterval(), m_impl->restartIntervals(), decoded);
+    if (ok && m_upsample) {
+        for (size_t i(0); i < numComponents; ++i) {
+            const Component& component = *frame->components[i];
+            if (!isFullSize(*frame, component))
+                upsamplePlane(*frame, component, decoded[i], planes[i]);
+        }
+    }
+    unmapImage(display, image);
+    if (!ok)
+        return YAMI_FAIL;
+
+    PicturePtr picture(new CpuDecPicture(surface, m_currentPTS));
+    return outputPicture(picture);
+}
+
 YamiStatus VaapiDecoderJPEG::finish()
 {
     if (!m_impl->frameHeader()) {
@@ -419,6 +635,9 @@ YamiStatus VaapiDecoderJPEG::finish()
     if (status != YAMI_SUCCESS) {
         return status;
     }
+
+    if (useCpu())
+        return finishOnCpu();
     status = createPicture(m_picture, m_currentPTS);
     if (status != YAMI_SUCCESS) {
         ERROR("Could not create a VAAPI picture.");
@@ -484,13 +703,31 @@ YamiStatus VaapiDecoderJPEG::ensureContext()
         return YAMI_FAIL;
     }
 
-    if (!getFourcc(frame)) {
+    uint32_t fourcc = getFourcc(frame);
+    //other 3 component samplings, such as 4:1:1 or cb and cr sampled
+    //differently, have no surface format. we upsample them to 4:4:4
+    m_upsample = !fourcc && frame->components.size() == 3
+        && Decoder::isSupported(*frame, *m_impl->scanHeader());
+    if (m_upsample)
+        fourcc = YAMI_FOURCC_444P;
+    if (!fourcc) {
+        ERROR("unsupported jpeg, %d components", (int)frame->components.size());
         return YAMI_UNSUPPORTED;
     }
     if (setFormat(frame->imageWidth, frame->imageHeight, frame->imageWidth,
-            frame->imageHeight, JPEG_SURFACE_NUM, getFourcc(frame))) {
+            frame->imageHeight, JPEG_SURFACE_NUM, fourcc)) {
         return YAMI_DECODE_FORMAT_CHANGE;
     }
-    return ensureProfile(VAProfileJPEGBaseline);
+    if (useCpu())
+        return ensureSurfacePool();
+
+    YamiStatus status = ensureProfile(VAProfileJPEGBaseline);
+    if (status != YAMI_SUCCESS
+        && Decoder::isSupported(*frame, *m_impl->scanHeader())) {
+        WARNING("no VA jpeg decoding, decoding on the cpu");
+        m_vaUnsupported = true;
+        return ensureSurfacePool();
+    }
+    return status;
 }
 }
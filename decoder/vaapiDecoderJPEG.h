@@ -21,6 +21,12 @@
 #include "vaapidecpicture.h"
 #include "vaapidecoder_base.h"
 
+namespace YamiParser {
+namespace JPEG {
+    class Decoder;
+}
+}
+
 namespace YamiMediaCodec {
 
 class VaapiDecoderJPEG
@@ -46,12 +52,21 @@ private:
     YamiStatus loadHuffmanTables();
 
     YamiStatus finish();
+    YamiStatus finishOnCpu();
 
     YamiStatus ensureContext();
+    bool useCpu() const;
 
     SharedPtr<VaapiDecoderJPEG::Impl> m_impl;
     PicturePtr m_picture;
 
+    // decodes small images, and all of them if VA has no jpeg decoding
+    SharedPtr<YamiParser::JPEG::Decoder> m_cpuDecoder;
+    bool m_vaUnsupported;
+    // sampling with no surface format, decoded on the cpu and upsampled to 444P
+    bool m_upsample;
+    std::vector<uint8_t> m_upsampleBuffer;
+
     /**
      * VaapiDecoderFactory registration result. This decoder is registered in
      * vaapidecoder_host.cpp
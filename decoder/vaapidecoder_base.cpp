@@ -29,6 +29,10 @@
 #include <stdlib.h> // for setenv
 #include <va/va_backend.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+
+using std::bind;
 
 namespace YamiMediaCodec{
 typedef VaapiDecoderBase::PicturePtr PicturePtr;
@@ -41,6 +45,10 @@ inline void unrefAllocator(SurfaceAllocator* allocator)
 VaapiDecoderBase::VaapiDecoderBase()
     : m_VAStarted(false)
     , m_currentPTS(INVALID_PTS)
+    , m_outputCallback(NULL)
+    , m_outputUser(NULL)
+    , m_outputEventFd(-1)
+    , m_surfaceWaitMs(0)
 {
     INFO("base: construct()");
     m_externalDisplay.handle = 0,
@@ -54,6 +62,10 @@ VaapiDecoderBase::~VaapiDecoderBase()
 {
     INFO("base: deconstruct()");
     stop();
+    if (m_outputThread)
+        m_outputThread->stop();
+    if (m_outputEventFd != -1)
+        close(m_outputEventFd);
 }
 
 YamiStatus VaapiDecoderBase::createPicture(PicturePtr& picture, int64_t timeStamp /* , VaapiPictureStructure structure = VAAPI_PICTURE_STRUCTURE_FRAME */)
@@ -164,7 +176,17 @@ void VaapiDecoderBase::flush(void)
 {
 
     INFO("base: flush()");
-    m_output.clear();
+    drainAsyncOutput();
+    {
+        AutoLock lock(m_outputLock);
+        m_output.clear();
+        m_pendingOutput.clear();
+    }
+    if (m_outputEventFd != -1) {
+        uint64_t count;
+        if (read(m_outputEventFd, &count, sizeof(count)) < 0)
+            DEBUG("no frames were signaled");
+    }
 
     m_currentPTS = INVALID_PTS;
 }
@@ -172,6 +194,7 @@ void VaapiDecoderBase::flush(void)
 SharedPtr<VideoFrame> VaapiDecoderBase::getOutput()
 {
     SharedPtr<VideoFrame> frame;
+    AutoLock lock(m_outputLock);
     if (m_output.empty())
         return frame;
     frame = m_output.front();
@@ -179,6 +202,84 @@ SharedPtr<VideoFrame> VaapiDecoderBase::getOutput()
     return frame;
 }
 
+uint32_t VaapiDecoderBase::getOutputs(uint32_t max, std::vector<SharedPtr<VideoFrame> >& frames)
+{
+    AutoLock lock(m_outputLock);
+    uint32_t n = std::min(max, (uint32_t)m_output.size());
+    if (!n)
+        return 0;
+    OutputQueue::iterator end = m_output.begin() + n;
+    frames.insert(frames.end(), m_output.begin(), end);
+    m_output.erase(m_output.begin(), end);
+    return n;
+}
+
+YamiStatus VaapiDecoderBase::enableAsyncOutput(DecodeOutputCallback callback, void* user)
+{
+    if (m_outputThread) {
+        ERROR("async output is enabled already");
+        return YAMI_FAIL;
+    }
+    if (m_VAStarted) {
+        ERROR("enable async output before start()");
+        return YAMI_FAIL;
+    }
+    m_outputEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_outputEventFd == -1) {
+        ERROR("failed to create eventfd");
+        return YAMI_FAIL;
+    }
+    m_outputThread.reset(new Thread("decoder output"));
+    if (!m_outputThread->start()) {
+        ERROR("failed to start output thread");
+        m_outputThread.reset();
+        close(m_outputEventFd);
+        m_outputEventFd = -1;
+        return YAMI_FAIL;
+    }
+    m_outputCallback = callback;
+    m_outputUser = user;
+    return YAMI_SUCCESS;
+}
+
+int VaapiDecoderBase::getOutputEventFd()
+{
+    return m_outputEventFd;
+}
+
+void VaapiDecoderBase::setSurfaceWaitTimeout(uint32_t timeoutMs)
+{
+    m_surfaceWaitMs = timeoutMs;
+}
+
+void VaapiDecoderBase::waitOutput(const DisplayPtr& display, VASurfaceID id)
+{
+    if (display)
+        checkVaapiStatus(vaSyncSurface(display->getID(), id), "vaSyncSurface");
+    {
+        AutoLock lock(m_outputLock);
+        if (m_pendingOutput.empty())
+            return;
+        m_output.push_back(m_pendingOutput.front());
+        m_pendingOutput.pop_front();
+    }
+    uint64_t one = 1;
+    if (write(m_outputEventFd, &one, sizeof(one)) != sizeof(one))
+        ERROR("failed to signal output eventfd");
+    if (m_outputCallback)
+        m_outputCallback(m_outputUser);
+}
+
+static void doNothing()
+{
+}
+
+void VaapiDecoderBase::drainAsyncOutput()
+{
+    if (m_outputThread)
+        m_outputThread->send(doNothing);
+}
+
 const VideoFormatInfo *VaapiDecoderBase::getFormatInfo(void)
 {
     INFO("base: getFormatInfo()");
@@ -356,7 +457,12 @@ YamiStatus VaapiDecoderBase::ensureProfile(VAProfile profile)
 YamiStatus VaapiDecoderBase::terminateVA(void)
 {
     INFO("base: terminate VA");
-    m_output.clear();
+    drainAsyncOutput();
+    {
+        AutoLock lock(m_outputLock);
+        m_output.clear();
+        m_pendingOutput.clear();
+    }
     m_config.resetConfig();
     m_surfacePool.reset();
     m_allocator.reset();
@@ -393,6 +499,16 @@ SurfacePtr VaapiDecoderBase::createSurface()
     SurfacePtr surface;
     if (m_surfacePool) {
         surface = m_surfacePool->acquire();
+        if (!surface && m_surfaceWaitMs) {
+            //only surfaces held by the client can come back while we wait
+            bool outputReady;
+            {
+                AutoLock lock(m_outputLock);
+                outputReady = !m_output.empty() || !m_pendingOutput.empty();
+            }
+            if (!outputReady)
+                surface = m_surfacePool->acquire(m_surfaceWaitMs);
+        }
     }
     return surface;
 }
@@ -412,6 +528,15 @@ YamiStatus VaapiDecoderBase::outputPicture(const PicturePtr& picture)
     SurfacePtr surface = picture->getSurface();
     SharedPtr<VideoFrame> frame(surface->m_frame.get(), VideoFrameRecycler(surface));
     frame->timeStamp = picture->m_timeStamp;
+    AutoLock lock(m_outputLock);
+    if (m_outputThread) {
+        //jobs run in order, each one moves the front pending frame to m_output.
+        //the job does not hold the frame, so the client returns the surface
+        //to us as soon as it drops the frame.
+        m_pendingOutput.push_back(frame);
+        m_outputThread->post(bind(&VaapiDecoderBase::waitOutput, this, m_display, surface->getID()));
+        return YAMI_SUCCESS;
+    }
     m_output.push_back(frame);
     return YAMI_SUCCESS;
 }
@@ -20,6 +20,8 @@
 
 #include "common/log.h"
 #include "common/common_def.h"
+#include "common/lock.h"
+#include "common/Thread.h"
 #include "VideoDecoderInterface.h"
 #include "vaapi/vaapiptrs.h"
 #include "vaapidecpicture.h"
@@ -78,6 +80,10 @@ class VaapiDecoderBase:public IVideoDecoder {
     virtual void flush(void);
     virtual const VideoFormatInfo *getFormatInfo(void);
     virtual SharedPtr<VideoFrame> getOutput();
+    virtual uint32_t getOutputs(uint32_t max, std::vector<SharedPtr<VideoFrame> >& frames);
+    virtual YamiStatus enableAsyncOutput(DecodeOutputCallback callback, void* user);
+    virtual int getOutputEventFd();
+    virtual void setSurfaceWaitTimeout(uint32_t timeoutMs);
 
     /* native window related functions */
     void setNativeDisplay(NativeDisplay * nativeDisplay);
@@ -94,6 +100,8 @@ class VaapiDecoderBase:public IVideoDecoder {
       YamiStatus outputPicture(const PicturePtr& picture);
     SurfacePtr createSurface();
     YamiStatus ensureProfile(VAProfile profile);
+    //surfaces only, for decoders that can fill them without a VA context
+    YamiStatus ensureSurfacePool();
 
     //set format to m_videoFormatInfo, return true if something changed.
     bool setFormat(uint32_t width, uint32_t height, uint32_t surfaceWidth, uint32_t surfaceHeight,
@@ -116,9 +124,12 @@ class VaapiDecoderBase:public IVideoDecoder {
     SharedPtr<SurfaceAllocator> m_allocator;
     SharedPtr<SurfaceAllocator> m_externalAllocator;
 
-    /* output queue*/
+    /* output queue, frames in it are finished by the hardware in async mode */
     typedef std::deque<SharedPtr<VideoFrame> > OutputQueue;
     OutputQueue m_output;
+    //frames submitted to the hardware, not finished yet
+    OutputQueue m_pendingOutput;
+    Lock m_outputLock;
 
 
     bool m_VAStarted;
@@ -127,9 +138,21 @@ class VaapiDecoderBase:public IVideoDecoder {
 
   private:
       bool createAllocator();
-      YamiStatus ensureSurfacePool();
+      //runs on m_outputThread
+      void waitOutput(const DisplayPtr&, VASurfaceID);
+      //wait for the frames posted to m_outputThread
+      void drainAsyncOutput();
       VideoDecoderConfig m_config;
 
+      /* async output, frames wait for the hardware on m_outputThread */
+      SharedPtr<Thread> m_outputThread;
+      DecodeOutputCallback m_outputCallback;
+      void* m_outputUser;
+      int m_outputEventFd;
+
+      //see setSurfaceWaitTimeout
+      uint32_t m_surfaceWaitMs;
+
       struct VideoFrameRecycler;
 
 #ifdef __ENABLE_DEBUG__
@@ -311,10 +311,52 @@ inline bool ascComparePoc(const PicturePtr& picture1,
     return picture1->m_poc < picture2->m_poc;
 }
 
-inline bool VaapiDecoderH264::DPB::PocLess::
-operator()(const PicturePtr& left, const PicturePtr& right) const
+VaapiDecoderH264::DPB::PictureList::PictureList()
+    : m_size(0)
 {
-    return left->m_poc <= right->m_poc;
+}
+
+bool VaapiDecoderH264::DPB::PictureList::insert(const PicturePtr& picture)
+{
+    if (full()) {
+        ERROR("dpb overflow");
+        return false;
+    }
+    iterator pos = std::lower_bound(begin(), end(), picture, ascComparePoc);
+    //move the tail one step back, pointers only
+    for (iterator it = end(); it != pos; --it)
+        it->swap(*(it - 1));
+    *pos = picture;
+    m_size++;
+    return true;
+}
+
+void VaapiDecoderH264::DPB::PictureList::erase(iterator pos)
+{
+    pos->reset();
+    for (iterator it = pos + 1; it != end(); ++it)
+        it->swap(*(it - 1));
+    m_size--;
+}
+
+template <class P>
+void VaapiDecoderH264::DPB::PictureList::removeIf(P pred)
+{
+    iterator dst = begin();
+    for (iterator it = begin(); it != end(); ++it) {
+        if (pred(*it))
+            it->reset();
+        else
+            (dst++)->swap(*it);
+    }
+    m_size = dst - begin();
+}
+
+void VaapiDecoderH264::DPB::PictureList::clear()
+{
+    for (iterator it = begin(); it != end(); ++it)
+        it->reset();
+    m_size = 0;
 }
 
 bool checkMMCO5(DecRefPicMarking decRefPicMarking)
@@ -337,18 +379,19 @@ VaapiDecoderH264::DPB::DPB(OutputCallback output)
     , m_maxNumRefFrames(0)
     , m_maxDecFrameBuffering(H264_MAX_REFRENCE_SURFACE_NUMBER)
 {
+    //field pictures take two entries, so the sets never grow after this
+    const size_t refs = H264_MAX_DPB_SIZE * 2;
+    m_refList0.reserve(refs);
+    m_refList1.reserve(refs);
+    m_shortTermList.reserve(refs);
+    m_shortTermList1.reserve(refs);
+    m_longTermList.reserve(refs);
 }
 
 void VaapiDecoderH264::DPB::removeUnused()
 {
     /* Remove unused pictures from DPB */
-    PictureList::iterator it;
-    for (it = m_pictures.begin(); it != m_pictures.end();) {
-        if (isUnusedPicture(*it))
-            m_pictures.erase(it++);
-        else
-            ++it;
-    }
+    m_pictures.removeIf(isUnusedPicture);
 }
 
 void VaapiDecoderH264::DPB::clearRefSet()
@@ -401,7 +444,7 @@ void VaapiDecoderH264::DPB::printRefList()
 
 static void calcShortTermPicNum(vector<PicturePtr>& shortRefSet,
                                 const PicturePtr& picture,
-                                PicturePtr& refPicture, uint32_t maxFrameNum)
+                                const PicturePtr& refPicture, uint32_t maxFrameNum)
 {
     if (refPicture->m_frameNum > picture->m_frameNum)
         refPicture->m_frameNumWrap = refPicture->m_frameNum - maxFrameNum;
@@ -424,7 +467,7 @@ static void calcShortTermPicNum(vector<PicturePtr>& shortRefSet,
 
 static void calcLongTermPicNum(vector<PicturePtr>& longRefSet,
                                const PicturePtr& picture,
-                               PicturePtr& refPicture)
+                               const PicturePtr& refPicture)
 {
     if (isFrame(refPicture))
         refPicture->m_longTermPicNum = refPicture->m_longTermFrameIdx;
@@ -444,7 +487,6 @@ void VaapiDecoderH264::DPB::calcPicNum(const PicturePtr& picture,
                                        const SliceHeader* const slice)
 {
     PictureList::iterator it;
-    PicturePtr refPicture;
 
     m_shortTermList.clear();
     m_longTermList.clear();
@@ -453,7 +495,7 @@ void VaapiDecoderH264::DPB::calcPicNum(const PicturePtr& picture,
                                          : 2 * picture->m_frameNum + 1;
 
     for (it = m_pictures.begin(); it != m_pictures.end(); it++) {
-        refPicture = *it;
+        const PicturePtr& refPicture = *it;
         if (isShortTermReference(refPicture)) {
             calcShortTermPicNum(m_shortTermList, picture, refPicture,
                                 m_maxFrameNum);
@@ -983,7 +1025,7 @@ bool VaapiDecoderH264::DPB::init(const PicturePtr& picture,
     m_maxFrameNum = 1 << (sps->log2_max_frame_num_minus4 + 4);
     m_decRefPicMarking = slice->dec_ref_pic_marking;
     m_maxNumRefFrames = MAX(sps->num_ref_frames, 1);
-    m_maxDecFrameBuffering = maxDecFrameBuffering;
+    m_maxDecFrameBuffering = MIN(maxDecFrameBuffering, H264_MAX_DPB_SIZE);
     if (isField(picture))
         m_maxNumRefFrames *= 2;
 
@@ -1055,8 +1097,6 @@ void resetPictureHasMmco5(const PicturePtr& picture)
 
 bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
 {
-    PictureList::iterator it = m_pictures.begin(); // picture with minimum poc
-
     /*(8.2.1)*/
     if (picture->m_hasMmco5)
         resetPictureHasMmco5(picture);
@@ -1080,7 +1120,9 @@ bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
         m_pictures.clear();
     }
 
-    if (!picture->m_isReference && isFull() && picture->m_poc < (*it)->m_poc) {
+    // m_pictures.begin() is the picture with minimum poc
+    if (!picture->m_isReference && isFull()
+        && picture->m_poc < (*m_pictures.begin())->m_poc) {
         DEBUG("Derectly output picture(Poc:%d)", picture->m_poc);
         return output(picture);
     }
@@ -1090,9 +1132,10 @@ bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
             return false;
     }
 
-    if (!isSecondField(picture))
-        m_pictures.insert(picture);
-    else {
+    if (!isSecondField(picture)) {
+        if (!m_pictures.insert(picture))
+            return false;
+    } else {
         // since the second field use same surface as the first field, no need
         // to add second filed into DPB buffer.
         PicturePtr compPicture = picture->m_complementField;
@@ -1131,6 +1174,10 @@ VaapiDecoderH264::VaapiDecoderH264()
     , m_dpb(bind(&VaapiDecoderH264::outputPicture, this, _1))
     , m_nalLengthSize(0)
     , m_contextChanged(false)
+    , m_packSlices(false)
+    , m_slice(new SliceHeader)
+    , m_freeNalus(H264_PIPELINE_DEPTH)
+    , m_readyNalus(H264_PIPELINE_DEPTH + 1)
 {
 }
 
@@ -1206,14 +1253,45 @@ YamiStatus VaapiDecoderH264::start(VideoConfigBuffer* buffer)
     }
 
     m_dpb.m_isLowLatencymode = buffer->enableLowLatency;
+    m_packSlices = buffer->flag & ENABLE_PACKED_SLICES;
+    m_checkedSps.reset();
+    if (buffer->flag & ENABLE_PIPELINED_PARSING)
+        startPipeline();
+    else
+        m_parseThread.reset();
     return YAMI_SUCCESS;
 }
 
+void VaapiDecoderH264::startPipeline()
+{
+    if (m_parseThread)
+        return;
+    m_parseThread.reset(new Thread("h264 parser"));
+    if (!m_parseThread->start()) {
+        //not fatal, we just decode on the caller's thread
+        m_parseThread.reset();
+        return;
+    }
+    if (m_parsedNalus.empty()) {
+        for (int i = 0; i < H264_PIPELINE_DEPTH; i++)
+            m_parsedNalus.push_back(ParsedNaluPtr(new ParsedNalu));
+    }
+    //the queues may still hold the units of an earlier pipeline
+    resetNaluQueues();
+}
+
+void VaapiDecoderH264::resetNaluQueues()
+{
+    m_freeNalus.open();
+    m_readyNalus.open();
+    for (size_t i = 0; i < m_parsedNalus.size(); i++)
+        m_freeNalus.push(m_parsedNalus[i].get());
+}
+
 YamiStatus VaapiDecoderH264::decodeSps(NalUnit* nalu)
 {
-    SharedPtr<SPS> sps(new SPS());
+    SharedPtr<SPS> sps;
 
-    memset(sps.get(), 0, sizeof(SPS));
     if (!m_parser.parseSps(sps, nalu)) {
         return YAMI_DECODE_INVALID_DATA;
     }
@@ -1223,7 +1301,7 @@ YamiStatus VaapiDecoderH264::decodeSps(NalUnit* nalu)
 
 YamiStatus VaapiDecoderH264::decodePps(NalUnit* nalu)
 {
-    SharedPtr<PPS> pps(new PPS());
+    SharedPtr<PPS> pps;
 
     if (!m_parser.parsePps(pps, nalu)) {
         return YAMI_DECODE_INVALID_DATA;
@@ -1597,6 +1675,11 @@ uint32_t calcMaxDecFrameBufferingNum(const SharedPtr<SPS>& sps)
 
 bool VaapiDecoderH264::isDecodeContextChanged(const SharedPtr<SPS>& sps)
 {
+    //the parser hands back the same sps for a resent one,
+    //no need to check it again
+    if (sps == m_checkedSps)
+        return false;
+
     uint32_t maxDecFrameBuffering;
 
     maxDecFrameBuffering = calcMaxDecFrameBufferingNum(sps);
@@ -1610,6 +1693,8 @@ bool VaapiDecoderH264::isDecodeContextChanged(const SharedPtr<SPS>& sps)
                                               : sps->m_width;
     uint32_t height = sps->frame_cropping_flag ? sps->m_cropRectHeight
                                                : sps->m_height;
+    //the format is this sps' from here on, changed or not
+    m_checkedSps = sps;
     if (setFormat(width, height, sps->m_width, sps->m_height, maxDecFrameBuffering + 1)) {
         if (isSurfaceGeometryChanged()) {
             decodeCurrent();
@@ -1681,6 +1766,7 @@ YamiStatus VaapiDecoderH264::createPicture(const SliceHeader* const slice,
             new VaapiDecPictureH264(m_context, m_currSurface, m_currentPTS));
     }
 
+    m_currPic->setPackedSlices(m_packSlices);
     m_currPic->m_picOutputFlag = true;
     m_currPic->m_idrFlag = nalu->m_idrPicFlag;
     m_currPic->m_frameNum = slice->frame_num;
@@ -1706,17 +1792,10 @@ YamiStatus VaapiDecoderH264::createPicture(const SliceHeader* const slice,
     return status;
 }
 
-YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu)
+YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu, SliceHeader* slice)
 {
-    SharedPtr<SliceHeader> currSlice(new SliceHeader);
-    SliceHeader* slice = currSlice.get();
     YamiStatus status;
 
-    *slice = SliceHeader();
-
-    if (!slice->parseHeader(&m_parser, nalu))
-        return YAMI_DECODE_INVALID_DATA;
-
     status = ensureContext(slice->m_pps->m_sps);
     if (status != YAMI_SUCCESS) {
         return status;
@@ -1752,23 +1831,45 @@ YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu)
 }
 
 YamiStatus VaapiDecoderH264::decodeNalu(NalUnit* nalu)
+{
+    //nothing refers to the slice header once we return,
+    //so the same one is reused for every slice
+    SliceHeader* slice = m_slice.get();
+    YamiStatus status = parseNalu(nalu, slice);
+    if (status != YAMI_SUCCESS)
+        return status;
+    return submitNalu(nalu, slice);
+}
+
+YamiStatus VaapiDecoderH264::parseNalu(NalUnit* nalu, SliceHeader* slice)
+{
+    uint8_t type = nalu->nal_unit_type;
+
+    if (NAL_SLICE_NONIDR <= type && type <= NAL_SLICE_IDR) {
+        slice->reset();
+        if (!slice->parseHeader(&m_parser, nalu))
+            return YAMI_DECODE_INVALID_DATA;
+        return YAMI_SUCCESS;
+    }
+    if (type == NAL_SPS)
+        return decodeSps(nalu);
+    if (type == NAL_PPS)
+        return decodePps(nalu);
+    return YAMI_SUCCESS;
+}
+
+YamiStatus VaapiDecoderH264::submitNalu(NalUnit* nalu, SliceHeader* slice)
 {
     uint8_t type = nalu->nal_unit_type;
     YamiStatus status = YAMI_SUCCESS;
 
     if (NAL_SLICE_NONIDR <= type && type <= NAL_SLICE_IDR) {
-        status = decodeSlice(nalu);
+        status = decodeSlice(nalu, slice);
     } else {
         status = decodeCurrent();
         if (status != YAMI_SUCCESS)
             return status;
         switch (type) {
-        case NAL_SPS:
-            status = decodeSps(nalu);
-            break;
-        case NAL_PPS:
-            status = decodePps(nalu);
-            break;
         case NAL_STREAM_END:
             m_endOfStream = true;
             break;
@@ -1794,6 +1895,7 @@ void VaapiDecoderH264::flush(void)
     m_prevPic.reset();
     m_currSurface.reset();
     m_contextChanged = false;
+    m_checkedSps.reset();
     VaapiDecoderBase::flush();
 }
 
@@ -1813,6 +1915,9 @@ YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
     }
     m_currentPTS = buffer->timeStamp;
 
+    if (m_parseThread)
+        return decodePipelined(buffer);
+
     int32_t size;
     NalUnit nalu;
     YamiStatus lastError = YAMI_SUCCESS;
@@ -1838,4 +1943,99 @@ YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
     return lastError;
 }
 
+/* runs on m_parseThread, the nal units of the buffer go to m_readyNalus
+ * in stream order. while it runs, decode() submits the units parsed so far
+ * on the caller's thread. submitNalu() does not touch m_parser, it sees sps
+ * and pps only through the slice headers. parsing a sps or pps changes the
+ * parser's tables though, so it waits until every unit before it has been
+ * submitted: if one of them fails, decode() returns and the buffer may be
+ * resent, and the parser must be where the serial path would have left it.
+ * the job is done before decode() returns, so units only overlap within
+ * one buffer */
+void VaapiDecoderH264::parseBuffer(const uint8_t* data, size_t size)
+{
+    NalReader nr(data, size, m_nalLengthSize);
+    const uint8_t* nal;
+    int32_t nalSize;
+    ParsedNalu* parsed;
+
+    while (nr.read(nal, nalSize)) {
+        if (!m_freeNalus.pop(parsed))
+            return;
+        if (!parsed->nalu.parseNalUnit(nal, nalSize)) {
+            m_freeNalus.push(parsed);
+            continue;
+        }
+        uint8_t type = parsed->nalu.nal_unit_type;
+        if ((type == NAL_SPS || type == NAL_PPS) && !waitSubmitted(parsed))
+            return;
+        parsed->status = parseNalu(&parsed->nalu, &parsed->slice);
+        if (!m_readyNalus.push(parsed))
+            return;
+    }
+    m_readyNalus.push(NULL);
+}
+
+/* runs on m_parseThread, holding one unit. decode() gives a unit back only
+ * once it is submitted without a fatal error, so when all the others are
+ * free, everything queued before is done. false if decode() stopped. */
+bool VaapiDecoderH264::waitSubmitted(ParsedNalu* held)
+{
+    ParsedNalu* parsed;
+    for (size_t i = 1; i < m_parsedNalus.size(); i++) {
+        if (!m_freeNalus.pop(parsed))
+            return false;
+    }
+    for (size_t i = 0; i < m_parsedNalus.size(); i++) {
+        if (m_parsedNalus[i].get() != held)
+            m_freeNalus.push(m_parsedNalus[i].get());
+    }
+    return true;
+}
+
+static void parseDone()
+{
+}
+
+//wait the parse job, after this the data of the buffer is not referred
+void VaapiDecoderH264::stopParsing()
+{
+    m_freeNalus.close();
+    m_readyNalus.close();
+    //jobs run in order, so the parse job is done once this one is
+    m_parseThread->send(parseDone);
+    resetNaluQueues();
+}
+
+YamiStatus VaapiDecoderH264::decodePipelined(VideoDecodeBuffer* buffer)
+{
+    YamiStatus lastError = YAMI_SUCCESS;
+    YamiStatus status = YAMI_SUCCESS;
+    ParsedNalu* parsed;
+
+    m_parseThread->post(bind(&VaapiDecoderH264::parseBuffer, this,
+        buffer->data, buffer->size));
+    while (m_readyNalus.pop(parsed) && parsed) {
+        status = parsed->status;
+        if (status == YAMI_SUCCESS)
+            status = submitNalu(&parsed->nalu, &parsed->slice);
+        if (status != YAMI_SUCCESS) {
+            //same as decode(), only YAMI_DECODE_INVALID_DATA is not fatal
+            lastError = status;
+            if (status != YAMI_DECODE_INVALID_DATA) {
+                //the unit is not given back, so a waitSubmitted() in the
+                //parse job can't finish and apply a later sps or pps
+                stopParsing();
+                return status;
+            }
+        }
+        m_freeNalus.push(parsed);
+    }
+    if (buffer->flag & VIDEO_DECODE_BUFFER_FLAG_FRAME_END) {
+        //send current buffer to libva
+        decodeCurrent();
+    }
+    return lastError;
+}
+
 }
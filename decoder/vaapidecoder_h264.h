@@ -19,14 +19,18 @@
 
 #include "codecparsers/h264Parser.h"
 #include "common/Functional.h"
+#include "common/Thread.h"
+#include "common/boundedqueue.h"
 #include "vaapidecoder_base.h"
 #include "vaapidecpicture.h"
 
-#include <set>
-
 namespace YamiMediaCodec {
 
 #define H264_MAX_REFRENCE_SURFACE_NUMBER 16
+//pictures the dpb can hold, the one decoded last included
+#define H264_MAX_DPB_SIZE (H264_MAX_REFRENCE_SURFACE_NUMBER + 1)
+//nal units parsed ahead of the va submission in pipelined mode
+#define H264_PIPELINE_DEPTH 16
 
 class VaapiDecPictureH264;
 class VaapiDecoderH264 : public VaapiDecoderBase {
@@ -46,6 +50,7 @@ public:
 private:
     friend class FactoryTest<IVideoDecoder, VaapiDecoderH264>;
     friend class VaapiDecoderH264Test;
+    friend class VaapiDecoderH264DpbBench;
 
     class DPB {
         typedef VaapiDecoderH264::RefSet RefSet;
@@ -55,11 +60,29 @@ private:
 
     public:
         typedef VaapiDecoderH264::PicturePtr PicturePtr;
-        struct PocLess {
-            inline bool operator()(const PicturePtr& left,
-                                   const PicturePtr& right) const;
+
+        /* pictures in poc order, in a fixed array.
+         * the dpb is small, so shifting a few pointers beats a tree */
+        class PictureList {
+        public:
+            typedef PicturePtr* iterator;
+            PictureList();
+            iterator begin() { return m_pictures; }
+            iterator end() { return m_pictures + m_size; }
+            size_t size() const { return m_size; }
+            bool full() const { return m_size == H264_MAX_DPB_SIZE; }
+            //a picture goes before the ones with the same poc
+            bool insert(const PicturePtr&);
+            void erase(iterator);
+            template <class P>
+            void removeIf(P);
+            void clear();
+
+        private:
+            PicturePtr m_pictures[H264_MAX_DPB_SIZE];
+            size_t m_size;
+            DISALLOW_COPY_AND_ASSIGN(PictureList);
         };
-        typedef std::set<PicturePtr, PocLess> PictureList;
 
         DPB(OutputCallback output);
         bool init(const PicturePtr&, const PicturePtr&,
@@ -129,10 +152,29 @@ private:
         YamiParser::H264::DecRefPicMarking m_decRefPicMarking;
     };
 
+    /* a nal unit parsed ahead by m_parseThread, waiting to be submitted */
+    struct ParsedNalu {
+        NalUnit nalu;
+        SliceHeader slice;
+        YamiStatus status;
+    };
+    typedef SharedPtr<ParsedNalu> ParsedNaluPtr;
+
     YamiStatus decodeNalu(NalUnit*);
+    //parser only part, it can run on m_parseThread
+    YamiStatus parseNalu(NalUnit*, SliceHeader*);
+    //va part, always on the caller's thread
+    YamiStatus submitNalu(NalUnit*, SliceHeader*);
     YamiStatus decodeSps(NalUnit*);
     YamiStatus decodePps(NalUnit*);
-    YamiStatus decodeSlice(NalUnit*);
+    YamiStatus decodeSlice(NalUnit*, SliceHeader*);
+
+    void startPipeline();
+    void resetNaluQueues();
+    YamiStatus decodePipelined(VideoDecodeBuffer*);
+    void parseBuffer(const uint8_t* data, size_t size);
+    bool waitSubmitted(ParsedNalu* held);
+    void stopParsing();
 
     YamiStatus ensureContext(const SharedPtr<SPS>& sps);
     bool fillPicture(const PicturePtr&, const SliceHeader* const);
@@ -167,6 +209,19 @@ private:
     uint32_t m_nalLengthSize;
     SurfacePtr m_currSurface;
     bool m_contextChanged;
+    //see ENABLE_PACKED_SLICES
+    bool m_packSlices;
+    //last sps isDecodeContextChanged set the format for
+    SharedPtr<SPS> m_checkedSps;
+    SharedPtr<SliceHeader> m_slice;
+
+    //pipelined mode, see ENABLE_PIPELINED_PARSING
+    std::vector<ParsedNaluPtr> m_parsedNalus;
+    BoundedQueue<ParsedNalu*> m_freeNalus;
+    //a NULL marks the end of the buffer
+    BoundedQueue<ParsedNalu*> m_readyNalus;
+    //declared after the queues, so it is joined before they go away
+    SharedPtr<Thread> m_parseThread;
 
     /**
      * VaapiDecoderFactory registration result. This decoder is registered in
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//the dpb and VaapiDecPictureH264 are private to the h264 decoder,
+//so the decoder is built into the benchmark
+#include "vaapidecoder_h264.cpp"
+
+#include "common/benchmark.h"
+
+#include <unistd.h>
+
+//VaapiDecoderH264::DPB with synthetic reference patterns, no va involved.
+//every picture goes through init, initReference for each slice and add.
+//usage: vaapidecoder_h264_dpb_bench [-n pictures] [-s slices]
+
+namespace YamiMediaCodec {
+
+class VaapiDecoderH264DpbBench {
+public:
+    typedef VaapiDecoderH264::DPB DPB;
+
+    enum FrameType {
+        FRAME_P = 0,
+        FRAME_B = 1,
+        FRAME_IDR = 2,
+    };
+
+    struct Frame {
+        FrameType type;
+        int32_t poc;
+        bool reference;
+    };
+
+    struct Pattern {
+        const char* name;
+        std::vector<Frame> gop; //starts with an idr
+        uint32_t numRefFrames;
+        uint32_t dpbSize;
+    };
+
+    VaapiDecoderH264DpbBench(uint32_t slices)
+        : m_slices(slices)
+        , m_outputs(0)
+        , m_checksum(0)
+    {
+    }
+
+    void run(const Pattern& pattern, uint32_t pictures)
+    {
+        SharedPtr<SPS> sps(new SPS);
+        memset(sps.get(), 0, sizeof(SPS));
+        sps->log2_max_frame_num_minus4 = 4;
+        sps->log2_max_pic_order_cnt_lsb_minus4 = 6;
+        sps->num_ref_frames = pattern.numRefFrames;
+        SharedPtr<PPS> pps(new PPS);
+        pps->m_sps = sps;
+        SliceHeader slice;
+        slice.m_pps = pps;
+        slice.num_ref_idx_l0_active_minus1 = pattern.numRefFrames - 1;
+        slice.num_ref_idx_l1_active_minus1 = 0;
+        NalUnit nalu;
+
+        m_outputs = 0;
+        m_checksum = 0;
+        DPB dpb(std::bind(&VaapiDecoderH264DpbBench::output, this, _1));
+        PicturePtr prev;
+        double t = benchNow();
+        for (uint32_t n = 0; n < pictures;) {
+            int32_t frameNum = 0;
+            for (size_t i = 0; i < pattern.gop.size() && n < pictures; i++, n++) {
+                const Frame& frame = pattern.gop[i];
+                PicturePtr picture = newPicture(n);
+                picture->m_idrFlag = frame.type == FRAME_IDR;
+                picture->m_frameNum = frameNum;
+                picture->m_pocLsb = frame.poc;
+                picture->m_isReference = frame.reference;
+                picture->m_shortTermRefFlag = frame.reference;
+                if (frame.reference)
+                    frameNum = (frameNum + 1) % 256;
+                if (picture->m_idrFlag)
+                    prev = newPicture(n);
+                slice.slice_type = frame.type;
+                slice.frame_num = picture->m_frameNum;
+                if (!dpb.init(picture, prev, &slice, &nalu, !n, false, pattern.dpbSize)) {
+                    fprintf(stderr, "init failed\n");
+                    return;
+                }
+                for (uint32_t s = 0; s < m_slices; s++) {
+                    dpb.initReference(picture, &slice);
+                    m_checksum = m_checksum * 7 + dpb.m_refList0.size() * 3 + dpb.m_refList1.size();
+                    if (!dpb.m_refList0.empty())
+                        m_checksum += dpb.m_refList0[0]->m_poc;
+                }
+                if (!dpb.add(picture)) {
+                    fprintf(stderr, "add failed\n");
+                    return;
+                }
+                prev = picture;
+            }
+        }
+        dpb.flush();
+        t = benchNow() - t;
+        printf("%-12s %6.1f ns/picture, %u outputs (checksum %llx)\n", pattern.name,
+            t * 1e9 / pictures, m_outputs, (unsigned long long)m_checksum);
+    }
+
+private:
+    static PicturePtr newPicture(int64_t timeStamp)
+    {
+        PicturePtr picture(new VaapiDecPictureH264);
+        picture->m_timeStamp = timeStamp;
+        picture->m_idrFlag = false;
+        picture->m_picStructure = VAAPI_PICTURE_FRAME;
+        picture->m_longTermRefFlag = false;
+        picture->m_shortTermRefFlag = false;
+        picture->m_topFieldOrderCnt = 0;
+        picture->m_bottomFieldOrderCnt = 0;
+        picture->m_pocMsb = 0;
+        picture->m_pocLsb = 0;
+        picture->m_poc = 0;
+        picture->m_frameNumOffset = 0;
+        picture->m_frameNum = 0;
+        picture->m_frameNumWrap = 0;
+        picture->m_picNum = 0;
+        picture->m_longTermFrameIdx = 0;
+        picture->m_longTermPicNum = 0;
+        picture->m_picOutputFlag = true;
+        picture->m_isReference = false;
+        picture->m_hasMmco5 = false;
+        picture->m_isSecondField = false;
+        return picture;
+    }
+
+    YamiStatus output(const PicturePtr& picture)
+    {
+        m_outputs++;
+        m_checksum = m_checksum * 31 + picture->m_poc + 1000 * picture->m_timeStamp;
+        return YAMI_SUCCESS;
+    }
+
+    uint32_t m_slices;
+    uint32_t m_outputs;
+    uint64_t m_checksum;
+};
+
+} //namespace YamiMediaCodec
+
+using namespace YamiMediaCodec;
+
+typedef VaapiDecoderH264DpbBench Bench;
+
+static void addFrame(Bench::Pattern& pattern, Bench::FrameType type, int32_t poc, bool reference)
+{
+    Bench::Frame frame = { type, poc, reference };
+    pattern.gop.push_back(frame);
+}
+
+//ipppp with 16 reference frames, an idr every 256 frames
+static void ippp(Bench::Pattern& pattern)
+{
+    pattern.name = "ippp/16";
+    pattern.numRefFrames = 16;
+    pattern.dpbSize = 16;
+    addFrame(pattern, Bench::FRAME_IDR, 0, true);
+    for (int32_t i = 1; i < 256; i++)
+        addFrame(pattern, Bench::FRAME_P, i * 2, true);
+}
+
+//hierarchical b, gop 8, 4 reference frames
+static void pyramid(Bench::Pattern& pattern)
+{
+    static const int32_t pocs[] = { 16, 8, 4, 2, 6, 12, 10, 14 };
+    static const bool references[] = { true, true, true, false, false, true, false, false };
+    pattern.name = "pyramid/4";
+    pattern.numRefFrames = 4;
+    pattern.dpbSize = 5;
+    addFrame(pattern, Bench::FRAME_IDR, 0, true);
+    for (int32_t g = 0; g < 32; g++) {
+        for (size_t i = 0; i < N_ELEMENTS(pocs); i++)
+            addFrame(pattern, i ? Bench::FRAME_B : Bench::FRAME_P, g * 16 + pocs[i], references[i]);
+    }
+}
+
+//ibbp with 2 reference frames, an idr every 31 frames
+static void ibbp(Bench::Pattern& pattern)
+{
+    pattern.name = "ibbp/2";
+    pattern.numRefFrames = 2;
+    pattern.dpbSize = 3;
+    addFrame(pattern, Bench::FRAME_IDR, 0, true);
+    for (int32_t i = 0; i < 10; i++) {
+        addFrame(pattern, Bench::FRAME_P, i * 6 + 6, true);
+        addFrame(pattern, Bench::FRAME_B, i * 6 + 2, false);
+        addFrame(pattern, Bench::FRAME_B, i * 6 + 4, false);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t pictures = 1000000;
+    uint32_t slices = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            pictures = atoi(optarg);
+            break;
+        case 's':
+            slices = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n pictures] [-s slices]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (!pictures)
+        pictures = 1;
+
+    Bench bench(slices);
+    Bench::Pattern patterns[3];
+    ippp(patterns[0]);
+    pyramid(patterns[1]);
+    ibbp(patterns[2]);
+    for (size_t i = 0; i < N_ELEMENTS(patterns); i++)
+        bench.run(patterns[i], pictures);
+    return 0;
+}
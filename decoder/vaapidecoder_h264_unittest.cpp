@@ -36,6 +36,11 @@
 
 // library headers
 #include "common/Array.h"
+#include "common/nalreader.h"
+#include "decoder/FrameData.h"
+
+// system headers
+#include <vector>
 
 namespace YamiMediaCodec {
 
@@ -174,4 +179,176 @@ VAAPIDECODER_H264_TEST(Decode_Simple)
     EXPECT_TRUE(bool(decoder.getOutput()));
 }
 
+typedef std::vector<uint8_t> Buffer;
+
+static void append(Buffer& buffer, const FrameData& frame, bool parameterSets)
+{
+    static const uint8_t startCode[] = { 0, 0, 0, 1 };
+    NalReader nr(frame.m_data, frame.m_size);
+    const uint8_t* nal;
+    int32_t size;
+    while (nr.read(nal, size)) {
+        uint8_t type = nal[0] & 0x1f;
+        if (!parameterSets
+            && (type == YamiParser::H264::NAL_SPS || type == YamiParser::H264::NAL_PPS))
+            continue;
+        buffer.insert(buffer.end(), startCode, startCode + sizeof(startCode));
+        buffer.insert(buffer.end(), nal, nal + size);
+    }
+}
+
+// s_avc16x16's sps and pps, rewritten to sps id 1
+const static std::array<uint8_t, 36> g_Sps1Pps16x16 = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x0a, 0x4b, 0x36, 0x57, 0xa1,
+    0x00, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x03, 0x00, 0x32, 0x0f, 0x12,
+    0x25, 0x96, 0x00, 0x00, 0x00, 0x01, 0x68, 0xaa, 0xf8, 0xf2, 0xc8, 0xb0
+};
+
+static YamiStatus decodeBuffer(VaapiDecoderH264& decoder, const Buffer& data)
+{
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.data = const_cast<uint8_t*>(&data[0]);
+    buffer.size = data.size();
+    return decoder.decode(&buffer);
+}
+
+VAAPIDECODER_H264_TEST(Decode_AlternatingSps)
+{
+    VaapiDecoderH264 decoder;
+    NativeDisplay display;
+    memset(&display, 0, sizeof(display));
+    display.type = NATIVE_DISPLAY_NULL;
+    decoder.setNativeDisplay(&display);
+
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    ASSERT_EQ(YAMI_SUCCESS, decoder.start(&config));
+
+    //two sps with different ids, so the parser keeps the 8x8 one
+    //while the 16x16 one is in use
+    Buffer small, big;
+    append(small, g_avc8x8I, true);
+    big.assign(g_Sps1Pps16x16.begin(), g_Sps1Pps16x16.end());
+    append(big, g_avc16x16, false);
+
+    //the 16x16 buffer is dropped after its format change, so no sps is
+    //checked twice in a row
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(YAMI_DECODE_FORMAT_CHANGE, decodeBuffer(decoder, small)) << i;
+        EXPECT_EQ(8u, decoder.getFormatInfo()->width);
+        EXPECT_EQ(YAMI_SUCCESS, decodeBuffer(decoder, small)) << i;
+        EXPECT_EQ(YAMI_DECODE_FORMAT_CHANGE, decodeBuffer(decoder, big)) << i;
+        EXPECT_EQ(16u, decoder.getFormatInfo()->width);
+    }
+}
+
+struct DecodedFrame {
+    int64_t timeStamp;
+    uint32_t width;
+    uint32_t height;
+};
+
+static bool operator==(const DecodedFrame& a, const DecodedFrame& b)
+{
+    return a.timeStamp == b.timeStamp && a.width == b.width && a.height == b.height;
+}
+
+static bool takeOutput(VaapiDecoderH264& decoder, std::vector<DecodedFrame>& frames)
+{
+    bool got = false;
+    SharedPtr<VideoFrame> frame;
+    while ((frame = decoder.getOutput())) {
+        DecodedFrame decoded = { frame->timeStamp, frame->crop.width, frame->crop.height };
+        frames.push_back(decoded);
+        got = true;
+    }
+    return got;
+}
+
+/* decode the buffers on the null driver, resending on format change and
+ * on no surface. the output is only taken when the decoder runs out of
+ * surfaces, so that happens in the middle of buffers */
+static void decodeBuffers(const std::vector<Buffer>& buffers, bool pipelined,
+    std::vector<DecodedFrame>& frames, std::vector<YamiStatus>& results,
+    uint32_t& noSurface)
+{
+    VaapiDecoderH264 decoder;
+    NativeDisplay display;
+    memset(&display, 0, sizeof(display));
+    display.type = NATIVE_DISPLAY_NULL;
+    decoder.setNativeDisplay(&display);
+
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    config.flag = pipelined ? ENABLE_PIPELINED_PARSING : 0;
+    ASSERT_EQ(YAMI_SUCCESS, decoder.start(&config));
+
+    noSurface = 0;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        VideoDecodeBuffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.data = const_cast<uint8_t*>(&buffers[i][0]);
+        buffer.size = buffers[i].size();
+        buffer.timeStamp = i;
+        YamiStatus status;
+        for (int tries = 0;; tries++) {
+            //every resend makes progress
+            ASSERT_GT(100, tries) << "buffer " << i << " is never done";
+            status = decoder.decode(&buffer);
+            if (status == YAMI_DECODE_FORMAT_CHANGE)
+                continue;
+            if (status != YAMI_DECODE_NO_SURFACE)
+                break;
+            noSurface++;
+            ASSERT_TRUE(takeOutput(decoder, frames));
+        }
+        results.push_back(status);
+    }
+    ASSERT_EQ(YAMI_SUCCESS, decoder.decode(NULL));
+    takeOutput(decoder, frames);
+}
+
+VAAPIDECODER_H264_TEST(Decode_PipelinedParameterSets)
+{
+    //several access units per buffer, the sps and pps change in the middle
+    //of some buffers while the slices before it still use the old ones.
+    //the whole buffer is resent, so each one changes the resolution once
+    //at most and has fewer frames than the decoder has surfaces.
+    std::vector<Buffer> buffers;
+    for (int i = 0; i < 120; i++) {
+        Buffer buffer;
+        if (i % 6 == 0 && i) {
+            append(buffer, g_avc16x16, false);
+            append(buffer, g_avc8x8I, true);
+            append(buffer, g_avc8x8P, false);
+            append(buffer, g_avc8x8B, false);
+        } else {
+            int units = i % 6 == 5 ? 3 : 1;
+            for (int j = 0; j < units; j++) {
+                append(buffer, g_avc8x8I, !i && !j);
+                append(buffer, g_avc8x8P, false);
+                append(buffer, g_avc8x8B, false);
+            }
+            if (i % 6 == 5)
+                append(buffer, g_avc16x16, true);
+        }
+        buffers.push_back(buffer);
+    }
+
+    std::vector<DecodedFrame> serialFrames, pipelinedFrames;
+    std::vector<YamiStatus> serialResults, pipelinedResults;
+    uint32_t serialNoSurface, pipelinedNoSurface;
+    decodeBuffers(buffers, false, serialFrames, serialResults, serialNoSurface);
+    decodeBuffers(buffers, true, pipelinedFrames, pipelinedResults, pipelinedNoSurface);
+
+    //the resend path is what this is about
+    EXPECT_LT(0u, serialNoSurface);
+    EXPECT_EQ(serialNoSurface, pipelinedNoSurface);
+    EXPECT_TRUE(serialResults == pipelinedResults);
+    ASSERT_EQ(serialFrames.size(), pipelinedFrames.size());
+    for (size_t i = 0; i < serialFrames.size(); i++)
+        EXPECT_TRUE(serialFrames[i] == pipelinedFrames[i]) << i;
+}
+
 }
@@ -430,10 +430,12 @@ VaapiDecoderH265::VaapiDecoderH265():
     m_nalLengthSize(0),
     m_newStream(true),
     m_endOfSequence(false),
+    m_packSlices(false),
     m_dpb(bind(&VaapiDecoderH265::outputPicture, this, _1))
 {
     m_parser.reset(new Parser());
     m_prevSlice.reset(new SliceHeader());
+    m_currSlice.reset(new SliceHeader());
 }
 
 VaapiDecoderH265::~VaapiDecoderH265()
@@ -449,6 +451,7 @@ YamiStatus VaapiDecoderH265::start(VideoConfigBuffer* buffer)
             return DECODE_FAIL;
         }
     }
+    m_packSlices = buffer->flag & ENABLE_PACKED_SLICES;
 
     return YAMI_SUCCESS;
 }
@@ -1051,6 +1054,7 @@ YamiStatus VaapiDecoderH265::createPicture(PicturePtr& picture, const SliceHeade
     if (!surface)
         return YAMI_DECODE_NO_SURFACE;
     picture.reset(new VaapiDecPictureH265(m_context, surface, m_currentPTS));
+    picture->setPackedSlices(m_packSlices);
 
     picture->m_noRaslOutputFlag = isIdr(nalu) || isBla(nalu) ||
                                   m_newStream || m_endOfSequence;
@@ -1067,10 +1071,11 @@ YamiStatus VaapiDecoderH265::createPicture(PicturePtr& picture, const SliceHeade
 
 YamiStatus VaapiDecoderH265::decodeSlice(NalUnit* nalu)
 {
-    SharedPtr<SliceHeader> currSlice(new SliceHeader());
-    SliceHeader* slice = currSlice.get();
+    SliceHeader* slice = m_currSlice.get();
     YamiStatus status;
 
+    slice->reset();
+
     if (!m_parser->parseSlice(nalu, slice))
         return YAMI_DECODE_INVALID_DATA;
 
@@ -1096,8 +1101,10 @@ YamiStatus VaapiDecoderH265::decodeSlice(NalUnit* nalu)
         return YAMI_FAIL;
     if (!fillSlice(m_current, slice, nalu))
         return YAMI_FAIL;
+    //dependent slices take the missing fields from m_prevSlice,
+    //the old m_prevSlice is recycled for next slice
     if (!slice->dependent_slice_segment_flag)
-        std::swap(currSlice, m_prevSlice);
+        std::swap(m_currSlice, m_prevSlice);
     return status;
 
 }
@@ -1151,7 +1158,7 @@ void VaapiDecoderH265::flush(bool discardOutput)
     m_prevPicOrderCntLsb = 0;
     m_newStream = true;
     m_endOfSequence = false;
-    m_prevSlice.reset(new SliceHeader());
+    m_prevSlice->reset();
     if (discardOutput)
         VaapiDecoderBase::flush();
 }
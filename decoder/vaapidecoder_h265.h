@@ -153,9 +153,13 @@ private:
     bool        m_noRaslOutputFlag;
     bool        m_newStream;
     bool        m_endOfSequence;
+    //see ENABLE_PACKED_SLICES
+    bool        m_packSlices;
     DPB         m_dpb;
     std::map<int32_t, uint8_t> m_pocToIndex;
     SharedPtr<SliceHeader> m_prevSlice;
+    //reused for every slice, swapped with m_prevSlice for independent ones
+    SharedPtr<SliceHeader> m_currSlice;
 
     /**
      * VaapiDecoderFactory registration result. This decoder is registered in
@@ -220,6 +220,7 @@ YamiStatus VaapiDecoderMPEG2::createPicture()
         return YAMI_DECODE_NO_SURFACE;
 
     m_current.reset(new VaapiDecPicture(m_context, s, m_currentPTS));
+    m_current->setPackedSlices(m_configBuffer.flag & ENABLE_PACKED_SLICES);
     m_current->m_type = type;
     return YAMI_SUCCESS;
 }
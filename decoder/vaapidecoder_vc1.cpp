@@ -66,50 +66,15 @@ YamiStatus VaapiDecoderVC1::ensureContext()
     return ensureProfile(VAProfileVC1Main);
 }
 
-bool VaapiDecoderVC1::makeBitPlanes(PicturePtr& picture, VAPictureParameterBufferVC1* param)
+bool VaapiDecoderVC1::makeBitPlanes(PicturePtr& picture)
 {
-    uint8_t val = 0;
-    uint32_t i = 0, j = 0, k = 0, t = 0, dstIdx = 0, srcIdx = 0;
-    uint8_t* bitPlanes[3] = { NULL, NULL, NULL };
+    //the parser decodes the planes in va layout already
+    const std::vector<uint8_t>& packed = m_parser.m_bitPlanes.packed;
     uint8_t* bitPlanesPayLoad = NULL;
-    if ((m_parser.m_frameHdr.picture_type == FRAME_I)
-        || (m_parser.m_frameHdr.picture_type == FRAME_BI)) {
-        if (param->bitplane_present.flags.bp_ac_pred)
-            bitPlanes[1] = &m_parser.m_bitPlanes.acpred[0];
-        if (param->bitplane_present.flags.bp_overflags)
-            bitPlanes[2] = &m_parser.m_bitPlanes.overflags[0];
-    }
-    else if (m_parser.m_frameHdr.picture_type == FRAME_P) {
-        if (param->bitplane_present.flags.bp_direct_mb)
-            bitPlanes[0] = &m_parser.m_bitPlanes.directmb[0];
-        if (param->bitplane_present.flags.bp_skip_mb)
-            bitPlanes[1] = &m_parser.m_bitPlanes.skipmb[0];
-        if (param->bitplane_present.flags.bp_mv_type_mb)
-            bitPlanes[2] = &m_parser.m_bitPlanes.mvtypemb[0];
-    }
-    else if (m_parser.m_frameHdr.picture_type == FRAME_B) {
-        if (param->bitplane_present.flags.bp_direct_mb)
-            bitPlanes[0] = &m_parser.m_bitPlanes.directmb[0];
-        if (param->bitplane_present.flags.bp_skip_mb)
-            bitPlanes[1] = &m_parser.m_bitPlanes.skipmb[0];
-    }
-    picture->editBitPlane(bitPlanesPayLoad, (m_parser.m_mbWidth * m_parser.m_mbHeight + 1) >> 1);
+    picture->editBitPlane(bitPlanesPayLoad, packed.size());
     if (!bitPlanesPayLoad)
         return false;
-    for (i = 0; i < m_parser.m_mbHeight; i++) {
-        for (j = 0; j < m_parser.m_mbWidth; j++) {
-            dstIdx = t++ >> 1;
-            srcIdx = i * m_parser.m_mbWidth + j;
-            val = 0;
-            for (k = 0; k < 3; k++) {
-                if (bitPlanes[k])
-                    val |= bitPlanes[k][srcIdx] << k;
-            }
-            bitPlanesPayLoad[dstIdx] = (bitPlanesPayLoad[dstIdx] << 4) | val;
-        }
-    }
-    if (t & 1)
-        bitPlanesPayLoad[(t >> 1)] <<= 4;
+    memcpy(bitPlanesPayLoad, &packed[0], packed.size());
     return true;
 }
 
@@ -277,7 +242,7 @@ bool VaapiDecoderVC1::ensurePicture(PicturePtr& picture)
     }
 
     if (param->bitplane_present.value)
-        return makeBitPlanes(picture, param);
+        return makeBitPlanes(picture);
 
 #undef FILL
 #undef FILL_MV
@@ -22,9 +22,13 @@
 #include <string.h>
 
 #include "common/log.h"
+#include "codecparsers/vp9SuperFrame.h"
 #include "vaapidecoder_vp9.h"
 
 namespace YamiMediaCodec{
+
+using YamiParser::Vp9Parser;
+using YamiParser::Vp9SuperFrameIterator;
 #define VP9_SURFACE_NUM 8
 
 typedef VaapiDecoderVP9::PicturePtr PicturePtr;
@@ -49,7 +53,7 @@ static VAProfile profileMap(VP9_PROFILE src_profile)
 VaapiDecoderVP9::VaapiDecoderVP9()
     : m_gotKeyFrame(false)
 {
-    m_parser.reset(vp9_parser_new(), vp9_parser_free);
+    m_parser.reset(new Vp9Parser);
     m_reference.resize(VP9_REF_FRAMES);
 }
 
@@ -68,8 +72,6 @@ YamiStatus VaapiDecoderVP9::start(VideoConfigBuffer* buffer)
     if (!(buffer->flag & HAS_SURFACE_NUMBER))
         buffer->surfaceNumber = VP9_SURFACE_NUM;
 
-    m_parser->bit_depth = VP9_BITS_8;
-
     DEBUG("disable native graphics buffer");
     m_configBuffer = *buffer;
     m_configBuffer.data = NULL;
@@ -99,7 +101,7 @@ void VaapiDecoderVP9::flush(void)
 void VaapiDecoderVP9::flush(bool discardOutput)
 {
     m_gotKeyFrame = false;
-    m_parser.reset(vp9_parser_new(), vp9_parser_free);
+    m_parser.reset(new Vp9Parser);
     m_reference.clear();
     m_reference.resize(VP9_REF_FRAMES);
     if (discardOutput)
@@ -113,7 +115,7 @@ YamiStatus VaapiDecoderVP9::ensureContext(const Vp9FrameHdr* hdr)
         return YAMI_FATAL_ERROR;
     }
 
-    uint32_t fourcc = (m_parser->bit_depth == VP9_BITS_10) ? YAMI_FOURCC_P010 : YAMI_FOURCC_NV12;
+    uint32_t fourcc = (m_parser->bitDepth() == VP9_BITS_10) ? YAMI_FOURCC_P010 : YAMI_FOURCC_NV12;
 
     if (setFormat(hdr->width, hdr->height, ALIGN8(hdr->width), ALIGN32(hdr->height), VP9_SURFACE_NUM, fourcc)) {
         return YAMI_DECODE_FORMAT_CHANGE;
@@ -199,7 +201,7 @@ bool VaapiDecoderVP9::ensurePicture(const PicturePtr& picture, const Vp9FrameHdr
     param->pic_fields.bits.segmentation_enabled = hdr->segmentation.enabled;
     param->pic_fields.bits.segmentation_temporal_update = hdr->segmentation.temporal_update;
     param->pic_fields.bits.segmentation_update_map = hdr->segmentation.update_map;
-    param->pic_fields.bits.lossless_flag = m_parser->lossless_flag;
+    param->pic_fields.bits.lossless_flag = m_parser->losslessFlag();
 
     param->filter_level = hdr->loopfilter.filter_level;
     param->sharpness_level = hdr->loopfilter.sharpness_level;
@@ -212,12 +214,12 @@ bool VaapiDecoderVP9::ensurePicture(const PicturePtr& picture, const Vp9FrameHdr
     FILL_FIELD(first_partition_size)
 #undef FILL_FIELD
     param->profile = hdr->profile;
-    param->bit_depth = 8 + m_parser->bit_depth * 2;
+    param->bit_depth = 8 + m_parser->bitDepth() * 2;
 
-    assert(sizeof(param->mb_segment_tree_probs) == sizeof(m_parser->mb_segment_tree_probs));
-    assert(sizeof(param->segment_pred_probs) == sizeof(m_parser->segment_pred_probs));
-    memcpy(param->mb_segment_tree_probs, m_parser->mb_segment_tree_probs, sizeof(m_parser->mb_segment_tree_probs));
-    memcpy(param->segment_pred_probs, m_parser->segment_pred_probs, sizeof(m_parser->segment_pred_probs));
+    assert(sizeof(param->mb_segment_tree_probs) == VP9_SEG_TREE_PROBS);
+    assert(sizeof(param->segment_pred_probs) == VP9_PREDICTION_PROBS);
+    memcpy(param->mb_segment_tree_probs, m_parser->segmentTreeProbs(), VP9_SEG_TREE_PROBS);
+    memcpy(param->segment_pred_probs, m_parser->segmentPredProbs(), VP9_PREDICTION_PROBS);
 
     return true;
 }
@@ -231,7 +233,7 @@ bool VaapiDecoderVP9::ensureSlice(const PicturePtr& picture, const void* data, i
         return false;
     for (int i = 0; i < VP9_MAX_SEGMENTS; i++) {
         VASegmentParameterVP9& vaseg = slice->seg_param[i];
-        Vp9Segmentation& seg = m_parser->segmentation[i];
+        const Vp9Segmentation& seg = m_parser->segmentation(i);
         memcpy(vaseg.filter_level, seg.filter_level, sizeof(seg.filter_level));
         FILL_FIELD(luma_ac_quant_scale)
         FILL_FIELD(luma_dc_quant_scale)
@@ -256,20 +258,21 @@ YamiStatus VaapiDecoderVP9::decode(const Vp9FrameHdr* hdr, const uint8_t* data,
         return ret;
 
     PicturePtr picture;
-    ret = createPicture(picture, timeStamp);
-    if (ret != YAMI_SUCCESS)
-        return ret;
-
     if (hdr->show_existing_frame) {
+        //output the reference as is, no new surface is needed
         SurfacePtr& surface = m_reference[hdr->frame_to_show];
         if (!surface) {
             ERROR("frame to show is invalid, idx = %d", hdr->frame_to_show);
             return YAMI_SUCCESS;
         }
-        picture->setSurface(surface);
+        picture.reset(new VaapiDecPicture(m_context, surface, timeStamp));
         return outputPicture(picture);
     }
 
+    ret = createPicture(picture, timeStamp);
+    if (ret != YAMI_SUCCESS)
+        return ret;
+
     if (!picture->getSurface()->setCrop(0, 0, hdr->width, hdr->height)) {
         ERROR("resize to %dx%d failed", hdr->width, hdr->height);
         return YAMI_OUT_MEMORY;
@@ -287,35 +290,6 @@ YamiStatus VaapiDecoderVP9::decode(const Vp9FrameHdr* hdr, const uint8_t* data,
     return YAMI_SUCCESS;
 }
 
-static bool parse_super_frame(std::vector<uint32_t>& frameSize, const uint8_t* data, const size_t size)
-{
-    if (!data || !size)
-        return false;
-    uint8_t marker;
-    marker =  *(data + size - 1);
-    if ((marker & 0xe0) != 0xc0) {
-        frameSize.push_back(size);
-        return true;
-    }
-    const uint32_t frames = (marker & 0x7) + 1;
-    const uint32_t mag = ((marker >> 3) & 0x3) + 1;
-    const size_t indexSz = 2 + mag * frames;
-    if (size < indexSz)
-        return false;
-    data += size - indexSz;
-    const uint8_t marker2 = *data++;
-    if (marker != marker2)
-        return false;
-    for (uint32_t i = 0; i < frames; i++) {
-        uint32_t sz = 0;
-        for (uint32_t j = 0; j < mag; j++) {
-            sz |= (*data++) << (j * 8);
-        }
-        frameSize.push_back(sz);
-    }
-    return true;
-}
-
 YamiStatus VaapiDecoderVP9::decode(VideoDecodeBuffer* buffer)
 {
     YamiStatus status;
@@ -323,20 +297,15 @@ YamiStatus VaapiDecoderVP9::decode(VideoDecodeBuffer* buffer)
         flush(false);
         return YAMI_SUCCESS;
     }
-    uint8_t* data = buffer->data;
-    size_t  size = buffer->size;
-    uint8_t* end = data + size;
-    std::vector<uint32_t> frameSize;
-    if (!parse_super_frame(frameSize, data, size))
+    Vp9SuperFrameIterator superFrame;
+    if (!superFrame.init(buffer->data, buffer->size))
         return YAMI_DECODE_INVALID_DATA;
-    for (size_t i = 0; i < frameSize.size(); i++) {
-        uint32_t sz = frameSize[i];
-        if (data + sz > end)
-            return YAMI_DECODE_INVALID_DATA;
-        status = decode(data, sz, buffer->timeStamp);
+    const uint8_t* data;
+    uint32_t size;
+    while (superFrame.next(data, size)) {
+        status = decode(data, size, buffer->timeStamp);
         if (status != YAMI_SUCCESS)
             return status;
-        data += sz;
     }
     return YAMI_SUCCESS;
 }
@@ -346,7 +315,7 @@ YamiStatus VaapiDecoderVP9::decode(const uint8_t* data, uint32_t size, uint64_t
     Vp9FrameHdr hdr;
     if (!m_parser)
         return YAMI_OUT_MEMORY;
-    if (vp9_parse_frame_header(m_parser.get(), &hdr, data, size) != VP9_PARSER_OK)
+    if (m_parser->parse(hdr, data, size) != VP9_PARSER_OK)
         return YAMI_DECODE_INVALID_DATA;
     if (VP9_KEY_FRAME == hdr.frame_type) {
         m_gotKeyFrame = true;
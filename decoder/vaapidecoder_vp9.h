@@ -50,7 +50,7 @@ class VaapiDecoderVP9:public VaapiDecoderBase {
     bool fillReference(VADecPictureParameterBufferVP9* , const Vp9FrameHdr*);
     void updateReference(const PicturePtr&, const Vp9FrameHdr*);
 
-    typedef SharedPtr<Vp9Parser> ParserPtr;
+    typedef SharedPtr<YamiParser::Vp9Parser> ParserPtr;
     ParserPtr m_parser;
     std::vector<SurfacePtr> m_reference;
 
@@ -26,10 +26,14 @@ namespace YamiMediaCodec{
 VaapiDecPicture::VaapiDecPicture(const ContextPtr& context,
                                  const SurfacePtr& surface, int64_t timeStamp)
     :VaapiPicture(context, surface, timeStamp)
+    , m_packedSlices(false)
+    , m_sliceParamSize(0)
 {
 }
 
 VaapiDecPicture::VaapiDecPicture()
+    : m_packedSlices(false)
+    , m_sliceParamSize(0)
 {
 }
 
@@ -40,6 +44,8 @@ bool VaapiDecPicture::decode()
 
 bool VaapiDecPicture::doRender()
 {
+    if (m_packedSlices)
+        return renderPacked();
     RENDER_OBJECT(m_picture);
     RENDER_OBJECT(m_probTable);
     RENDER_OBJECT(m_iqMatrix);
@@ -48,4 +54,45 @@ bool VaapiDecPicture::doRender()
     RENDER_OBJECT(m_slices);
     return true;
 }
+
+bool VaapiDecPicture::renderPacked()
+{
+    std::vector<BufObjectPtr> buffers;
+    buffers.push_back(m_picture);
+    buffers.push_back(m_probTable);
+    buffers.push_back(m_iqMatrix);
+    buffers.push_back(m_bitPlane);
+    buffers.push_back(m_hufTable);
+    m_picture.reset();
+    m_probTable.reset();
+    m_iqMatrix.reset();
+    m_bitPlane.reset();
+    m_hufTable.reset();
+
+    uint32_t num = m_sliceParamSize ? m_sliceParams.size() / m_sliceParamSize : 0;
+    if (num) {
+        //created mapped, so it comes from the buffer pool
+        void* mapped;
+        BufObjectPtr param = VaapiBuffer::create(m_context, VASliceParameterBufferType,
+            m_sliceParamSize, NULL, &mapped, num);
+        if (param)
+            memcpy(mapped, &m_sliceParams[0], m_sliceParams.size());
+        BufObjectPtr data = createBufferObject(VASliceDataBufferType,
+            m_sliceData.size(), m_sliceData.empty() ? NULL : &m_sliceData[0], NULL);
+        if (!param || !data) {
+            ERROR("create packed slice buffers failed");
+            return false;
+        }
+        buffers.push_back(param);
+        buffers.push_back(data);
+    }
+    m_sliceParams.clear();
+    m_sliceData.clear();
+
+    if (!renderBatch(buffers)) {
+        ERROR("render packed buffers failed");
+        return false;
+    }
+    return true;
+}
 }
@@ -44,6 +44,12 @@ public:
     template <class T>
     bool newSlice(T*& sliceParam, const void* sliceData, uint32_t sliceSize);
 
+    /* gather the slices into one parameter array and one data buffer, and
+     * submit them with the other buffers in a single vaRenderPicture.
+     * in this mode, the sliceParam from newSlice is only valid until
+     * the next newSlice. set it before the first slice */
+    void setPackedSlices(bool packed) { m_packedSlices = packed; }
+
     bool decode();
 
 protected:
@@ -51,6 +57,7 @@ protected:
 
 private:
     virtual bool doRender();
+    bool renderPacked();
 
     BufObjectPtr m_picture;
     BufObjectPtr m_iqMatrix;
@@ -58,6 +65,11 @@ private:
     BufObjectPtr m_hufTable;
     BufObjectPtr m_probTable;
     std::vector<std::pair<BufObjectPtr, BufObjectPtr> > m_slices;
+
+    bool m_packedSlices;
+    uint32_t m_sliceParamSize;
+    std::vector<uint8_t> m_sliceParams;
+    std::vector<uint8_t> m_sliceData;
 };
 
 template<class T>
@@ -100,6 +112,21 @@ bool VaapiDecPicture::editProbTable(T*& probTable)
 template <class T>
 bool VaapiDecPicture::newSlice(T*& sliceParam, const void* sliceData, uint32_t sliceSize)
 {
+    if (m_packedSlices) {
+        if (m_sliceParamSize && m_sliceParamSize != sizeof(T))
+            return false;
+        m_sliceParamSize = sizeof(T);
+        size_t offset = m_sliceParams.size();
+        m_sliceParams.resize(offset + sizeof(T));
+        sliceParam = (T*)&m_sliceParams[offset];
+        sliceParam->slice_data_size = sliceSize;
+        sliceParam->slice_data_offset = m_sliceData.size();
+        sliceParam->slice_data_flag = VA_SLICE_DATA_FLAG_ALL;
+        const uint8_t* data = (const uint8_t*)sliceData;
+        m_sliceData.insert(m_sliceData.end(), data, data + sliceSize);
+        return true;
+    }
+
     BufObjectPtr data = createBufferObject(VASliceDataBufferType, sliceSize, sliceData, NULL);
     BufObjectPtr param = createBufferObject(VASliceParameterBufferType, sliceParam);
 
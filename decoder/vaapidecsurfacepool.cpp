@@ -42,26 +42,23 @@ YamiStatus VaapiDecSurfacePool::putSurface(SurfaceAllocParams* param, intptr_t s
 
 YamiStatus VaapiDecSurfacePool::getSurface(intptr_t* surface)
 {
-    AutoLock lock(m_lock);
-
-    if (m_freed.empty())
+    if (!m_freed->pop(*surface))
         return YAMI_DECODE_NO_SURFACE;
-    *surface = m_freed.front();
-    m_used.insert(*surface);
-    m_freed.pop_front();
+    //only surfaces from m_surfaceMap are in m_freed
+    m_surfaceMap.find(*surface)->second.used.store(true, std::memory_order_relaxed);
     return YAMI_SUCCESS;
 }
 
 YamiStatus VaapiDecSurfacePool::putSurface(intptr_t surface)
 {
-    AutoLock lock(m_lock);
-
-    if (m_used.find(surface) == m_used.end()) {
+    //m_surfaceMap is not changed after init, so we can search it without lock
+    SurfaceMap::iterator it = m_surfaceMap.find(surface);
+    if (it == m_surfaceMap.end()
+        || !it->second.used.exchange(false, std::memory_order_relaxed)) {
         ERROR("put wrong surface, id = %p", (void*)surface);
         return YAMI_INVALID_PARAM;
     }
-    m_used.erase(surface);
-    m_freed.push_back(surface);
+    m_freed->push(surface);
     return YAMI_SUCCESS;
 }
 
@@ -108,19 +105,24 @@ bool VaapiDecSurfacePool::init(VideoDecoderConfig* config,
         m_allocParams.user = this;
     }
 
+    m_freed.reset(new FreeList<intptr_t>(size));
     for (uint32_t i = 0; i < size; i++) {
         intptr_t s = m_allocParams.surfaces[i];
         SurfacePtr surface(new VaapiSurface(s, width, height, fourcc));
 
-        m_surfaceMap[s] = surface.get();
+        SurfaceEntry& entry = m_surfaceMap[s];
+        entry.surface = surface.get();
+        entry.used.store(false, std::memory_order_relaxed);
         m_surfaces.push_back(surface);
 
-        m_freed.push_back(s);
+        m_freed->push(s);
     }
     return true;
 }
 
 VaapiDecSurfacePool::VaapiDecSurfacePool()
+    : m_recycled(m_lock)
+    , m_waiters(0)
 {
     memset(&m_allocParams, 0, sizeof(m_allocParams));
 }
@@ -150,27 +152,62 @@ struct VaapiDecSurfacePool::SurfaceRecycler
     {
         SurfaceAllocParams& params = m_pool->m_allocParams;
         params.putSurface(&params, (intptr_t)surface->getID());
+        m_pool->onRecycled();
     }
 
 private:
     DecSurfacePoolPtr m_pool;
 };
 
-SurfacePtr VaapiDecSurfacePool::acquire()
+void VaapiDecSurfacePool::onRecycled()
+{
+    //pairs with the fence in acquire, either we see the waiter
+    //or it sees the surface we just put back
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed)) {
+        AutoLock lock(m_lock);
+        m_recycled.broadcast();
+    }
+}
+
+SurfacePtr VaapiDecSurfacePool::acquire(uint32_t timeoutMs)
+{
+    SurfacePtr surface = tryAcquire();
+    if (surface || !timeoutMs)
+        return surface;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    AutoLock lock(m_lock);
+    m_waiters++;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool timeout = false;
+    while (!(surface = tryAcquire()) && !timeout)
+        timeout = !m_recycled.timedwait(deadline);
+    m_waiters--;
+    return surface;
+}
+
+SurfacePtr VaapiDecSurfacePool::tryAcquire()
 {
     SurfacePtr surface;
     intptr_t p;
     YamiStatus status = m_allocParams.getSurface(&m_allocParams, &p);
     if (status != YAMI_SUCCESS)
         return surface;
-    //we only hold this lock after getSurface, since getSurface will do the lock
-    AutoLock lock(m_lock);
     SurfaceMap::iterator it = m_surfaceMap.find(p);
     if (it == m_surfaceMap.end()) {
         ERROR("surface getter turn a invalid surface ptr, %p", (void*)p);
         return surface;
     }
-    surface.reset(it->second, SurfaceRecycler(shared_from_this()));
+    surface.reset(it->second.surface, SurfaceRecycler(shared_from_this()));
     return surface;
 }
 
@@ -18,16 +18,16 @@
 #ifndef vaapidecsurfacepool_h
 #define vaapidecsurfacepool_h
 
-#include "common/condition.h"
 #include "common/common_def.h"
+#include "common/condition.h"
+#include "common/freelist.h"
 #include "common/lock.h"
 #include "vaapi/vaapiptrs.h"
 #include "VideoCommonDefs.h"
 #include "VideoDecoderDefs.h"
-#include <deque>
+#include <atomic>
 #include <map>
 #include <vector>
-#include <set>
 #include <va/va.h>
 
 namespace YamiMediaCodec{
@@ -47,6 +47,7 @@ struct VideoDecoderConfig;
  *  if no flag is set, the buffer/surface can be reused -- associate with a new VaapiPicture
  * 2. the free surface is in a first-in-first-out queue to be friendly to graphics fence
  * 3. most functions in this class do not support multithread except recycle.
+ *    acquire and recycle take no lock, the free surfaces are in a #FreeList.
  * 4. flush need called in decoder thread and it will make all following acuireWithWait return null surface.
  *    until all surface recycled.
  *</pre>
@@ -60,8 +61,9 @@ public:
     static DecSurfacePoolPtr create(VideoDecoderConfig* config,
         const SharedPtr<SurfaceAllocator>& allocator);
     void getSurfaceIDs(std::vector<VASurfaceID>& ids);
-    /// get a free surface
-    SurfacePtr acquire();
+    /// get a free surface, if there is none, wait up to @param timeoutMs for one to be recycled.
+    /// with an external allocator, only surfaces released by the decoder wake us up early.
+    SurfacePtr acquire(uint32_t timeoutMs = 0);
     ~VaapiDecSurfacePool();
 
 
@@ -74,18 +76,27 @@ private:
     static YamiStatus putSurface(SurfaceAllocParams* param, intptr_t surface);
     YamiStatus getSurface(intptr_t* surface);
     YamiStatus putSurface(intptr_t surface);
+    SurfacePtr tryAcquire();
+    void onRecycled();
 
     //following member only change in constructor.
     std::vector<SurfacePtr> m_surfaces;
 
-    typedef std::map<intptr_t, VaapiSurface*> SurfaceMap;
+    struct SurfaceEntry {
+        VaapiSurface* surface;
+        //set while the surface is out of m_freed
+        std::atomic<bool> used;
+    };
+    typedef std::map<intptr_t, SurfaceEntry> SurfaceMap;
     SurfaceMap m_surfaceMap;
 
-    //free and allocted.
-    std::deque<intptr_t> m_freed;
-    std::set<intptr_t> m_used;
+    //free surfaces, sized in init
+    SharedPtr<FreeList<intptr_t> > m_freed;
 
+    //only for acquire with timeout, the recycler signals when someone waits
     Lock m_lock;
+    Condition m_recycled;
+    std::atomic<int> m_waiters;
 
     //for external allocator
     SharedPtr<SurfaceAllocator> m_allocator;
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vaapidecsurfacepool.h"
+
+#include "common/basesurfaceallocator.h"
+#include "common/Thread.h"
+#include "common/unittest.h"
+#include "decoder/vaapidecoder_base.h"
+
+#include <time.h>
+#include <unistd.h>
+
+namespace YamiMediaCodec {
+
+#define SURFACE_POOL_TEST(name) \
+    TEST(VaapiDecSurfacePoolTest, name)
+
+//hands out fake ids, the pool never touches va for them
+class FakeSurfaceAllocator : public BaseSurfaceAllocator {
+protected:
+    YamiStatus doAlloc(SurfaceAllocParams* params)
+    {
+        params->surfaces = new intptr_t[params->size];
+        for (uint32_t i = 0; i < params->size; i++)
+            params->surfaces[i] = i + 1;
+        return YAMI_SUCCESS;
+    }
+    YamiStatus doFree(SurfaceAllocParams* params)
+    {
+        delete[] params->surfaces;
+        params->surfaces = NULL;
+        return YAMI_SUCCESS;
+    }
+    void doUnref() {}
+};
+
+static DecSurfacePoolPtr createPool(uint32_t size)
+{
+    VideoDecoderConfig config;
+    config.width = 64;
+    config.height = 64;
+    config.fourcc = YAMI_FOURCC_NV12;
+    config.surfaceNumber = size;
+    SharedPtr<SurfaceAllocator> allocator(new FakeSurfaceAllocator);
+    return VaapiDecSurfacePool::create(&config, allocator);
+}
+
+static uint32_t elapsedMs(const struct timespec& start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000
+        + (now.tv_nsec - start.tv_nsec) / 1000000;
+}
+
+static void sleepAndRelease(SurfacePtr& surface)
+{
+    usleep(20 * 1000);
+    surface.reset();
+}
+
+SURFACE_POOL_TEST(AcquireAll)
+{
+    const uint32_t size = 4;
+    DecSurfacePoolPtr pool = createPool(size);
+    ASSERT_TRUE(bool(pool));
+
+    std::vector<SurfacePtr> surfaces;
+    for (uint32_t i = 0; i < size; i++) {
+        SurfacePtr s = pool->acquire();
+        ASSERT_TRUE(bool(s));
+        surfaces.push_back(s);
+    }
+    EXPECT_FALSE(bool(pool->acquire()));
+
+    surfaces.pop_back();
+    EXPECT_TRUE(bool(pool->acquire()));
+}
+
+SURFACE_POOL_TEST(AcquireTimeout)
+{
+    DecSurfacePoolPtr pool = createPool(1);
+    ASSERT_TRUE(bool(pool));
+    SurfacePtr held = pool->acquire();
+    ASSERT_TRUE(bool(held));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    EXPECT_FALSE(bool(pool->acquire(30)));
+    EXPECT_LE(30u, elapsedMs(start));
+}
+
+SURFACE_POOL_TEST(AcquireWait)
+{
+    DecSurfacePoolPtr pool = createPool(1);
+    ASSERT_TRUE(bool(pool));
+    SurfacePtr held = pool->acquire();
+    ASSERT_TRUE(bool(held));
+
+    Thread thread("release");
+    ASSERT_TRUE(thread.start());
+    thread.post(std::bind(sleepAndRelease, std::ref(held)));
+
+    //wakes up on release, long before the timeout
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SurfacePtr surface = pool->acquire(10 * 1000);
+    EXPECT_TRUE(bool(surface));
+    EXPECT_GT(5000u, elapsedMs(start));
+    thread.stop();
+}
+}
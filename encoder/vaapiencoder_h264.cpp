@@ -45,6 +45,8 @@ using std::vector;
 #define H264_FRAME_FR 172
 #define H264_MIN_CR 2
 #define H264_NAL_START_CODE 0x000001
+/* packed slice and prefix nal headers are written to the stack, this is far more than they need */
+#define H264_PACKED_HEADER_MAX_SIZE 1024
 
 #define VAAPI_ENCODER_H264_NAL_REF_IDC_NONE        0
 #define VAAPI_ENCODER_H264_NAL_REF_IDC_LOW         1
@@ -172,34 +174,13 @@ static uint8_t h264_get_profile_idc(VideoProfile profile)
 BOOL
 bit_writer_put_ue(BitWriter *bitwriter, uint32_t value)
 {
-    uint32_t  size_in_bits = 0;
-    uint32_t  tmp_value = ++value;
-
-    while (tmp_value) {
-        ++size_in_bits;
-        tmp_value >>= 1;
-    }
-    if (size_in_bits > 1
-        && !bitwriter->writeBits(0, size_in_bits - 1))
-        return FALSE;
-    if (!bitwriter->writeBits(value, size_in_bits))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeUe(value);
 }
 
 BOOL
 bit_writer_put_se(BitWriter *bitwriter, int32_t value)
 {
-    uint32_t new_val;
-
-    if (value <= 0)
-        new_val = -(value<<1);
-    else
-        new_val = (value<<1) - 1;
-
-    if (!bit_writer_put_ue(bitwriter, new_val))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeSe(value);
 }
 
 
@@ -649,29 +630,6 @@ private:
         param.insert(param.end(), codedData, codedData + codedBytes);
     }
 
-    void appendHeaderWithEmulation(Header& h)
-    {
-        Header::iterator s = h.begin();
-        Header::iterator e;
-        uint8_t zeros[] = {0, 0};
-        uint8_t emulation[] = {0, 0, 3};
-        do {
-            e = std::search(s, h.end(), zeros, zeros + N_ELEMENTS(zeros));
-            m_headers.insert(m_headers.end(), s, e);
-            if (e == h.end())
-                break;
-
-            s = e + N_ELEMENTS(zeros);
-
-            /* only when bitstream contains 0x000000/0x000001/0x000002/0x000003
-               need to insert emulation prevention byte 0x03 */
-            if (*s <= 3)
-                m_headers.insert(m_headers.end(), emulation, emulation + N_ELEMENTS(emulation));
-            else
-                m_headers.insert(m_headers.end(), zeros, zeros + N_ELEMENTS(zeros));
-         } while (1);
-    }
-
     void generateCodecConfigAnnexB()
     {
         std::vector<Header*> headers;
@@ -680,10 +638,14 @@ private:
         headers.push_back(&m_sps);
         headers.push_back(&m_pps);
         uint8_t sync[] = {0, 0, 0, 1};
+        BitWriter bs;
         for (size_t i = 0; i < headers.size(); i++) {
-            m_headers.insert(m_headers.end(), sync, sync + N_ELEMENTS(sync));
-            appendHeaderWithEmulation(*headers[i]);
+            bs.setEmulationPrevention(false);
+            bs.writeBytes(sync, N_ELEMENTS(sync));
+            bs.setEmulationPrevention(true);
+            bs.writeBytes(&(*headers[i])[0], headers[i]->size());
         }
+        bsToHeader(m_headers, bs);
     }
 
     void generateCodecConfigAVCc()
@@ -1574,10 +1536,8 @@ bool VaapiEncoderH264::fillReferenceList(VAEncSliceParameterBufferH264* slice) c
     return true;
 }
 
-bool VaapiEncoderH264::addPackedPrefixNalUnit(const PicturePtr& picture) const
+bool VaapiEncoderH264::writePrefixNalUnit(BitWriter& bs, const PicturePtr& picture) const
 {
-    bool ret = true;
-    BitWriter bs;
     bs.writeBits(H264_NAL_START_CODE, 32);
     bit_writer_write_nal_header(&bs, picture->m_isReference
                                          ? VAAPI_ENCODER_H264_NAL_REF_IDC_LOW
@@ -1602,27 +1562,17 @@ bool VaapiEncoderH264::addPackedPrefixNalUnit(const PicturePtr& picture) const
     }
     /* no more rbsp data */
 
-    bit_writer_write_trailing_bits(&bs);
-
-    uint32_t codedBits = bs.getCodedBitsCount();
-    uint8_t* codedData = bs.getBitWriterData();
-    ASSERT(codedData && codedBits);
-
-    if (!picture->addPackedHeader(VAEncPackedHeaderRawData, codedData,
-                                  codedBits)) {
-        ret = false;
-    }
-
-    return ret;
+    return bit_writer_write_trailing_bits(&bs);
 }
 
 bool VaapiEncoderH264::addPackedSliceHeader(
     const PicturePtr& picture,
-    const VAEncSliceParameterBufferH264* const sliceParam) const
+    const VAEncSliceParameterBufferH264* const sliceParam,
+    const uint8_t* tail, uint64_t tailBits) const
 {
     bool ret = true;
-    uint32_t i = 0;
-    BitWriter bs;
+    uint8_t buffer[H264_PACKED_HEADER_MAX_SIZE];
+    BitWriter bs(buffer, sizeof(buffer));
     bs.writeBits(H264_NAL_START_CODE, 32);
 
     if (sliceParam->slice_type == H264_SLICE_TYPE_I) {
@@ -1643,6 +1593,31 @@ bool VaapiEncoderH264::addPackedSliceHeader(
 
     bit_writer_put_ue(&bs,
                       sliceParam->macroblock_address); /* first_mb_in_slice*/
+    bs.writeBitstream(tail, tailBits);
+
+    if (m_picParam->pic_fields.bits.entropy_coding_mode_flag) {
+        bs.writeToBytesAligned(true);
+    }
+
+    uint32_t codedBits = bs.getCodedBitsCount();
+    uint8_t* codedData = bs.getBitWriterData();
+    ASSERT(codedData && codedBits);
+
+    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData,
+                                  codedBits)) {
+        ret = false;
+    }
+
+    return ret;
+}
+
+/* the slice header after first_mb_in_slice is the same for all slices of
+ * a picture, so it's written once and copied to each of them */
+bool VaapiEncoderH264::writeSliceHeaderTail(
+    BitWriter& bs,
+    const VAEncSliceParameterBufferH264* const sliceParam) const
+{
+    uint32_t i = 0;
     bit_writer_put_ue(&bs, sliceParam->slice_type); /* slice_type */
 
     bit_writer_put_ue(
@@ -1768,20 +1743,7 @@ bool VaapiEncoderH264::addPackedSliceHeader(
         }
     }
 
-    if (m_picParam->pic_fields.bits.entropy_coding_mode_flag) {
-        bs.writeToBytesAligned(true);
-    }
-
-    uint32_t codedBits = bs.getCodedBitsCount();
-    uint8_t* codedData = bs.getBitWriterData();
-    ASSERT(codedData && codedBits);
-
-    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData,
-                                  codedBits)) {
-        ret = false;
-    }
-
-    return ret;
+    return true;
 }
 
 /* Adds slice headers to picture */
@@ -1791,6 +1753,11 @@ bool VaapiEncoderH264::addSliceHeaders (const PicturePtr& picture) const
     uint32_t sliceOfMbs, sliceModMbs, curSliceMbs;
     uint32_t mbSize;
     uint32_t lastMbIndex;
+    uint8_t prefixBuffer[H264_PACKED_HEADER_MAX_SIZE];
+    uint8_t tailBuffer[H264_PACKED_HEADER_MAX_SIZE];
+    BitWriter prefix(prefixBuffer, sizeof(prefixBuffer));
+    BitWriter tail(tailBuffer, sizeof(tailBuffer));
+    uint64_t prefixBits = 0, tailBits = 0;
 
     assert (picture);
 
@@ -1861,10 +1828,25 @@ bool VaapiEncoderH264::addSliceHeaders (const PicturePtr& picture) const
         /* set calculation for next slice */
         lastMbIndex += curSliceMbs;
 
+        /* only first_mb_in_slice differs between the slices */
+        if (!i) {
+            if (m_videoParamAVC.enablePrefixNalUnit) {
+                if (!writePrefixNalUnit(prefix, picture))
+                    return false;
+                prefixBits = prefix.getCodedBitsCount();
+            }
+            if (!writeSliceHeaderTail(tail, sliceParam))
+                return false;
+            tailBits = tail.getCodedBitsCount();
+            if (!tail.getBitWriterData())
+                return false;
+        }
+
         if (m_videoParamAVC.enablePrefixNalUnit
-            && !addPackedPrefixNalUnit(picture))
+            && !picture->addPackedHeader(VAEncPackedHeaderRawData,
+                   prefix.getBitWriterData(), prefixBits))
             return false;
-        if (!addPackedSliceHeader(picture, sliceParam))
+        if (!addPackedSliceHeader(picture, sliceParam, tailBuffer, tailBits))
             return false;
     }
     assert (lastMbIndex == mbSize);
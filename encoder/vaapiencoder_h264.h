@@ -26,6 +26,10 @@
 #include <pthread.h>
 #include <va/va_enc_h264.h>
 
+namespace YamiParser {
+class BitWriter;
+}
+
 namespace YamiMediaCodec{
 class VaapiEncPictureH264;
 class VaapiEncoderH264Ref;
@@ -77,10 +81,13 @@ private:
     bool ensurePicture (const PicturePtr&, const SurfacePtr&);
     bool ensureSlices(const PicturePtr&);
     bool ensureCodedBufferSize();
-    bool addPackedPrefixNalUnit(const PicturePtr&) const;
+    bool writePrefixNalUnit(YamiParser::BitWriter&, const PicturePtr&) const;
+    bool writeSliceHeaderTail(YamiParser::BitWriter&,
+        const VAEncSliceParameterBufferH264* const sliceParam) const;
     bool addPackedSliceHeader(
         const PicturePtr& picture,
-        const VAEncSliceParameterBufferH264* const sliceParam) const;
+        const VAEncSliceParameterBufferH264* const sliceParam,
+        const uint8_t* tail, uint64_t tailBits) const;
 
     //reference list related
     YamiStatus reorder(const SurfacePtr& surface, uint64_t timeStamp, bool forceKeyFrame);
@@ -42,6 +42,8 @@ using std::vector;
 using std::deque;
 
 #define HEVC_NAL_START_CODE 0x000001
+/* packed slice headers are written to the stack, this is far more than they need */
+#define HEVC_PACKED_HEADER_MAX_SIZE 1024
 
 #define HEVC_SLICE_TYPE_I            2
 #define HEVC_SLICE_TYPE_P           1
@@ -163,34 +165,13 @@ static uint8_t hevc_get_profile_idc(VideoProfile profile)
 static BOOL
 bit_writer_put_ue(BitWriter *bitwriter, uint32_t value)
 {
-    uint32_t  size_in_bits = 0;
-    uint32_t  tmp_value = ++value;
-
-    while (tmp_value) {
-        ++size_in_bits;
-        tmp_value >>= 1;
-    }
-    if (size_in_bits > 1
-        && !bitwriter->writeBits(0, size_in_bits - 1))
-        return FALSE;
-    if (!bitwriter->writeBits(value, size_in_bits))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeUe(value);
 }
 
 static BOOL
 bit_writer_put_se(BitWriter *bitwriter, int32_t value)
 {
-    uint32_t new_val;
-
-    if (value <= 0)
-        new_val = -(value<<1);
-    else
-        new_val = (value<<1) - 1;
-
-    if (!bit_writer_put_ue(bitwriter, new_val))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeSe(value);
 }
 
 static BOOL
@@ -337,10 +318,14 @@ public:
         headers.push_back(&m_sps);
         headers.push_back(&m_pps);
         uint8_t sync[] = {0, 0, 0, 1};
+        BitWriter bs;
         for (size_t i = 0; i < headers.size(); i++) {
-            m_headers.insert(m_headers.end(), sync, sync + N_ELEMENTS(sync));
-            appendHeaderWithEmulation(*headers[i]);
+            bs.setEmulationPrevention(false);
+            bs.writeBytes(sync, N_ELEMENTS(sync));
+            bs.setEmulationPrevention(true);
+            bs.writeBytes(&(*headers[i])[0], headers[i]->size());
         }
+        bsToHeader(m_headers, bs);
     }
 
     YamiStatus getCodecConfig(VideoEncOutputBuffer* outBuffer)
@@ -738,29 +723,6 @@ private:
         param.insert(param.end(), codedData, codedData + codedBytes);
     }
 
-    void appendHeaderWithEmulation(Header& h)
-    {
-        Header::iterator s = h.begin();
-        Header::iterator e;
-        uint8_t zeros[] = {0, 0};
-        uint8_t emulation[] = {0, 0, 3};
-        do {
-            e = std::search(s, h.end(), zeros, zeros + N_ELEMENTS(zeros));
-            m_headers.insert(m_headers.end(), s, e);
-            if (e == h.end())
-                break;
-
-            s = e + N_ELEMENTS(zeros);
-
-            /* only when bitstream contains 0x000000/0x000001/0x000002/0x000003
-               need to insert emulation prevention byte 0x03 */
-            if (*s <= 3)
-                m_headers.insert(m_headers.end(), emulation, emulation + N_ELEMENTS(emulation));
-            else
-                m_headers.insert(m_headers.end(), zeros, zeros + N_ELEMENTS(zeros));
-         } while (1);
-    }
-
     Header m_vps;
     Header m_sps;
     Header m_pps;
@@ -1534,11 +1496,12 @@ bool VaapiEncoderHEVC:: fillReferenceList(VAEncSliceParameterBufferHEVC* slice)
 
 bool VaapiEncoderHEVC::addPackedSliceHeader(const PicturePtr& picture,
                                         const VAEncSliceParameterBufferHEVC* const sliceParam,
-                                        uint32_t sliceIndex) const
+                                        uint32_t sliceIndex,
+                                        const uint8_t* tail, uint64_t tailBits) const
 {
     bool ret = true;
-    BitWriter bs;
-    BOOL short_term_ref_pic_set_sps_flag = !!m_shortRFS.num_short_term_ref_pic_sets;
+    uint8_t buffer[HEVC_PACKED_HEADER_MAX_SIZE];
+    BitWriter bs(buffer, sizeof(buffer));
     HevcNalUnitType nalUnitType = (picture->isIdr() ? IDR_W_RADL : TRAIL_R );
     bs.writeBits(HEVC_NAL_START_CODE, 32);
     bit_writer_write_nal_header(&bs, nalUnitType);
@@ -1561,6 +1524,28 @@ bool VaapiEncoderHEVC::addPackedSliceHeader(const PicturePtr& picture,
         bs.writeBits(sliceParam->slice_segment_address, log2(sliceParam->num_ctu_in_slice));
     }
 
+    bs.writeBitstream(tail, tailBits);
+
+    bit_writer_write_trailing_bits(&bs);
+
+    uint8_t* codedData = bs.getBitWriterData();
+    ASSERT(codedData);
+
+    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData, bs.getCodedBitsCount())) {
+        ret = false;
+    }
+
+    return ret;
+}
+
+/* the slice header after slice_segment_address is the same for all slices
+ * of a picture, so it's written once and copied to each of them */
+bool VaapiEncoderHEVC::writeSliceHeaderTail(BitWriter& bs, const PicturePtr& picture,
+                                        const VAEncSliceParameterBufferHEVC* const sliceParam) const
+{
+    BOOL short_term_ref_pic_set_sps_flag = !!m_shortRFS.num_short_term_ref_pic_sets;
+    HevcNalUnitType nalUnitType = (picture->isIdr() ? IDR_W_RADL : TRAIL_R );
+
     if (!sliceParam->slice_fields.bits.dependent_slice_segment_flag) {
         bit_writer_put_ue(&bs, sliceParam->slice_type);
 
@@ -1605,16 +1590,7 @@ bool VaapiEncoderHEVC::addPackedSliceHeader(const PicturePtr& picture,
           * pps_loop_filter_across_slices_enabled_flag are set to 0 */
     }
 
-    bit_writer_write_trailing_bits(&bs);
-
-    uint8_t* codedData = bs.getBitWriterData();
-    ASSERT(codedData);
-
-    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData, bs.getCodedBitsCount())) {
-        ret = false;
-    }
-
-    return ret;
+    return true;
 }
 
 /* Add slice headers to picture */
@@ -1624,6 +1600,9 @@ bool VaapiEncoderHEVC::addSliceHeaders (const PicturePtr& picture) const
     uint32_t sliceOfCtus, sliceModCtus, curSliceCtus;
     uint32_t numCtus;
     uint32_t lastCtuIndex;
+    uint8_t tailBuffer[HEVC_PACKED_HEADER_MAX_SIZE];
+    BitWriter tail(tailBuffer, sizeof(tailBuffer));
+    uint64_t tailBits = 0;
 
     assert (picture);
 
@@ -1679,7 +1658,16 @@ bool VaapiEncoderHEVC::addSliceHeaders (const PicturePtr& picture) const
 
         sliceParam->slice_fields.bits.last_slice_of_pic_flag = (lastCtuIndex == numCtus);
 
-        addPackedSliceHeader(picture, sliceParam, i);
+        /* only the slice address differs between the slices */
+        if (!i) {
+            if (!writeSliceHeaderTail(tail, picture, sliceParam))
+                return false;
+            tailBits = tail.getCodedBitsCount();
+            if (!tail.getBitWriterData())
+                return false;
+        }
+
+        addPackedSliceHeader(picture, sliceParam, i, tailBuffer, tailBits);
     }
     assert (lastCtuIndex == numCtus);
 
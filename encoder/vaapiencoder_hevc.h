@@ -27,6 +27,10 @@
 #include <pthread.h>
 #include <va/va_enc_hevc.h>
 
+namespace YamiParser {
+class BitWriter;
+}
+
 namespace YamiMediaCodec{
 class VaapiEncPictureHEVC;
 class VaapiEncoderHEVCRef;
@@ -84,9 +88,12 @@ private:
     bool ensureSequenceHeader(const PicturePtr&, const VAEncSequenceParameterBufferHEVC* const);
     bool ensurePictureHeader(const PicturePtr&, const VAEncPictureParameterBufferHEVC* const );
     bool addSliceHeaders (const PicturePtr&) const;
+    bool writeSliceHeaderTail(YamiParser::BitWriter&, const PicturePtr&,
+                          const VAEncSliceParameterBufferHEVC* const sliceParam) const;
     bool addPackedSliceHeader (const PicturePtr&,
                           const VAEncSliceParameterBufferHEVC* const sliceParam,
-                          uint32_t sliceIndex) const;
+                          uint32_t sliceIndex,
+                          const uint8_t* tail, uint64_t tailBits) const;
     bool ensureSequence(const PicturePtr&);
     bool ensurePicture (const PicturePtr&, const SurfacePtr&);
     bool ensureSlices(const PicturePtr&);
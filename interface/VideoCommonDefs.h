@@ -97,6 +97,7 @@ typedef enum {
     NATIVE_DISPLAY_DRM,
     NATIVE_DISPLAY_WAYLAND,
     NATIVE_DISPLAY_VA,      /* client need init va*/
+    NATIVE_DISPLAY_NULL,    /* in memory va driver without gpu, for profiling */
 } YamiNativeDisplayType;
 
 typedef struct NativeDisplay{
@@ -42,6 +42,25 @@ YamiStatus decodeDecode(DecodeHandler p, VideoDecodeBuffer* buffer);
 
 VideoFrame* decodeGetOutput(DecodeHandler p);
 
+/* get up to max decoded frames in one call, in output order.
+ * it returns how many frames are stored to frames[], and each of them
+ * should be released by frame->free(frame), like the one from decodeGetOutput.
+ * for example:
+ *     VideoFrame* frames[16];
+ *     uint32_t n = decodeGetOutputs(decoder, frames, 16);
+ *     for (uint32_t i = 0; i < n; i++) {
+ *         render(frames[i]);
+ *         frames[i]->free(frames[i]);
+ *     }
+ */
+uint32_t decodeGetOutputs(DecodeHandler p, VideoFrame** frames, uint32_t max);
+
+YamiStatus decodeEnableAsyncOutput(DecodeHandler p, DecodeOutputCallback callback, void* user);
+
+int decodeGetOutputEventFd(DecodeHandler p);
+
+void decodeSetSurfaceWaitTimeout(DecodeHandler p, uint32_t timeoutMs);
+
 const VideoFormatInfo* decodeGetFormatInfo(DecodeHandler p);
 
 void releaseDecoder(DecodeHandler p);
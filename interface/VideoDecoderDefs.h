@@ -33,6 +33,16 @@ typedef enum {
 
     // indicate whether profile field in the VideoConfigBuffer is valid
     HAS_VA_PROFILE = 0x08,
+
+    // parse the stream on a worker thread ahead of the va submission,
+    // only the avc decoder supports it for now
+    ENABLE_PIPELINED_PARSING = 0x10,
+
+    // submit all the slices of a picture as one parameter array and one
+    // data buffer, in a single vaRenderPicture call. it saves driver calls
+    // for streams with many slices per picture, the avc, hevc and mpeg2
+    // decoders support it
+    ENABLE_PACKED_SLICES = 0x20,
 } VIDEO_BUFFER_FLAG;
 
 typedef enum {
@@ -115,6 +125,10 @@ typedef struct {
     uint32_t fourcc;
 }VideoFormatInfo;
 
+/// called on a decoder thread when decoded frames become ready in asynchronous mode,
+/// it should not call the decoder, except to get the frames.
+typedef void (*DecodeOutputCallback)(void* user);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,7 @@
 // config.h should NOT be included in header file, especially for the header file used by external
 
 #include <VideoDecoderDefs.h>
+#include <vector>
 
 namespace YamiMediaCodec {
 /**
@@ -51,6 +52,34 @@ public:
     ///get decoded frame from decoder.
     virtual SharedPtr<VideoFrame> getOutput() = 0;
 
+    /** \brief get up to @param max decoded frames in one call, they are appended to @param frames in output order.
+    * it's cheaper than calling #getOutput for each frame when many small frames are ready.
+    * @return the number of frames appended, 0 if there is no frame ready.
+    */
+    virtual uint32_t getOutputs(uint32_t max, std::vector<SharedPtr<VideoFrame> >& frames) = 0;
+
+    /** \brief switch the decoder to asynchronous output, call it before #start.
+    * #decode returns once pictures are submitted to the hardware. A decoder thread waits for them,
+    * and only finished frames are returned by #getOutput, which never blocks.
+    * Each time frames become ready, @param callback (if it's not NULL) is called with @param user
+    * on that thread, and the eventfd returned by #getOutputEventFd is signaled.
+    * In this mode #getOutput may be called from any thread. If #decode returns YAMI_DECODE_NO_SURFACE
+    * and #getOutput has nothing, wait for the eventfd before sending the buffer again.
+    */
+    virtual YamiStatus enableAsyncOutput(DecodeOutputCallback callback, void* user) = 0;
+
+    /// \brief an eventfd for poll/epoll, readable while frames are ready in asynchronous mode.
+    /// read it to clear it, then call #getOutput until it returns NULL.
+    /// @return -1 if asynchronous output is not enabled.
+    virtual int getOutputEventFd() = 0;
+
+    /** \brief when all surfaces are held by the client, let #decode wait up to @param timeoutMs
+    * for one to come back, instead of returning YAMI_DECODE_NO_SURFACE at once.
+    * It does not wait while decoded frames are waiting for #getOutput, those have to be taken first.
+    * 0 (the default) disables the wait. It can be called at any time from the #decode thread.
+    */
+    virtual void setSurfaceWaitTimeout(uint32_t timeoutMs) = 0;
+
     /** \brief retrieve updated stream information after decoder has parsed the video stream.
     * client usually calls it when libyami return YAMI_DECODE_FORMAT_CHANGE in decode().
     */
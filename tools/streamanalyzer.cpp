@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include <string.h>
+
+namespace YamiMediaCodec {
+
+static uint32_t readLe32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readLe16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+enum {
+    IVF_FILE_HEADER_SIZE = 32,
+    IVF_FRAME_HEADER_SIZE = 12
+};
+
+IvfReader::IvfReader(const uint8_t* data, size_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_pos(0)
+    , m_fourcc(0)
+    , m_valid(false)
+{
+    if (size < IVF_FILE_HEADER_SIZE || memcmp(data, "DKIF", 4))
+        return;
+    m_pos = readLe16(data + 6);
+    if (m_pos < IVF_FILE_HEADER_SIZE || m_pos > size)
+        return;
+    m_fourcc = readLe32(data + 8);
+    m_valid = true;
+}
+
+bool IvfReader::read(const uint8_t*& frame, uint32_t& size)
+{
+    if (!m_valid || m_size - m_pos < IVF_FRAME_HEADER_SIZE)
+        return false;
+    size = readLe32(m_data + m_pos);
+    m_pos += IVF_FRAME_HEADER_SIZE;
+    if (size > m_size - m_pos)
+        return false;
+    frame = m_data + m_pos;
+    m_pos += size;
+    return true;
+}
+}
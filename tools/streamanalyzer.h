@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef streamanalyzer_h
+#define streamanalyzer_h
+
+#include "common/factory.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+/* what a parse only pass learns about one coded picture */
+struct FrameRecord {
+    enum {
+        //poc or qp does not exist for the codec
+        NONE = INT32_MIN
+    };
+
+    FrameRecord()
+        : offset(0)
+        , size(0)
+        , type('-')
+        , key(false)
+        , shown(true)
+        , poc(NONE)
+        , qp(NONE)
+        , slices(0)
+        , width(0)
+        , height(0)
+    {
+    }
+
+    uint64_t offset; //byte offset of the picture in the input
+    uint32_t size; //coded bytes, start codes and container headers excluded
+    char type; //'I', 'P', 'B', 'S' for skipped or '-' for unknown
+    bool key; //idr, irap or key frame
+    bool shown;
+    int32_t poc;
+    int32_t qp; //qp of the first slice, in the codec's own scale
+    uint32_t slices;
+    uint32_t width;
+    uint32_t height;
+};
+
+/* drives one codec's parser over a whole stream without touching va.
+ * The analyzer handles the codec's usual container itself: annex b for
+ * h264, h265 and mpeg2, rcv or elementary stream for vc1, ivf for vp8
+ * and vp9, and concatenated images for jpeg. */
+class StreamAnalyzer {
+public:
+    typedef std::vector<FrameRecord> FrameRecords;
+
+    StreamAnalyzer()
+        : m_errors(0)
+    {
+    }
+    virtual ~StreamAnalyzer() {}
+
+    /* append one record per picture to frames. Units which fail to parse
+     * are skipped and counted by errors(), false means the stream can't
+     * be parsed at all */
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames) = 0;
+
+    uint32_t errors() const { return m_errors; }
+
+protected:
+    uint32_t m_errors;
+};
+
+typedef Factory<StreamAnalyzer> StreamAnalyzerFactory;
+
+/* ivf, as written by libvpx, used by the vp8 and vp9 analyzers */
+class IvfReader {
+public:
+    IvfReader(const uint8_t* data, size_t size);
+
+    bool isValid() const { return m_valid; }
+    uint32_t fourcc() const { return m_fourcc; }
+
+    bool read(const uint8_t*& frame, uint32_t& size);
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+    uint32_t m_fourcc;
+    bool m_valid;
+};
+}
+
+#endif //streamanalyzer_h
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/h264Parser.h"
+#include "common/nalreader.h"
+
+#include <algorithm>
+
+namespace YamiMediaCodec {
+using namespace YamiParser::H264;
+
+class StreamAnalyzerH264 : public StreamAnalyzer {
+public:
+    StreamAnalyzerH264()
+        : m_prevPocMsb(0)
+        , m_prevPocLsb(0)
+        , m_prevFrameNumOffset(0)
+        , m_prevFrameNum(0)
+    {
+    }
+
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    bool parseSlice(NalUnit& nalu, FrameRecords& frames, uint64_t offset);
+    int32_t calcPoc(const SliceHeader& slice, const NalUnit& nalu);
+
+    static const bool s_registered;
+
+    Parser m_parser;
+    SliceHeader m_slice;
+
+    //8.2.1, state carried from the previous pictures
+    int32_t m_prevPocMsb;
+    int32_t m_prevPocLsb;
+    int32_t m_prevFrameNumOffset;
+    uint16_t m_prevFrameNum;
+};
+
+const bool StreamAnalyzerH264::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerH264>("h264");
+
+static char sliceTypeToChar(uint32_t sliceType)
+{
+    //P, B, I, SP, SI
+    static const char types[] = { 'P', 'B', 'I', 'P', 'I' };
+    return types[sliceType % 5];
+}
+
+static bool hasMmco5(const SliceHeader& slice)
+{
+    const DecRefPicMarking& marking = slice.dec_ref_pic_marking;
+    if (!marking.adaptive_ref_pic_marking_mode_flag)
+        return false;
+    for (uint8_t i = 0; i < marking.n_ref_pic_marking; i++) {
+        if (marking.ref_pic_marking[i].memory_management_control_operation == 5)
+            return true;
+    }
+    return false;
+}
+
+int32_t StreamAnalyzerH264::calcPoc(const SliceHeader& slice, const NalUnit& nalu)
+{
+    const SPS* const sps = slice.m_pps->m_sps.get();
+    const bool idr = nalu.m_idrPicFlag;
+    int32_t top = 0, bottom = 0;
+
+    if (sps->pic_order_cnt_type == 0) {
+        //8.2.1.1
+        if (idr) {
+            m_prevPocMsb = 0;
+            m_prevPocLsb = 0;
+        }
+        const int32_t maxPocLsb = 1 << (sps->log2_max_pic_order_cnt_lsb_minus4 + 4);
+        const int32_t pocLsb = slice.pic_order_cnt_lsb;
+        int32_t pocMsb = m_prevPocMsb;
+        if (pocLsb < m_prevPocLsb && m_prevPocLsb - pocLsb >= maxPocLsb / 2)
+            pocMsb += maxPocLsb;
+        else if (pocLsb > m_prevPocLsb && pocLsb - m_prevPocLsb > maxPocLsb / 2)
+            pocMsb -= maxPocLsb;
+        top = bottom = pocMsb + pocLsb;
+        if (!slice.field_pic_flag)
+            bottom += slice.delta_pic_order_cnt_bottom;
+        if (nalu.nal_ref_idc) {
+            m_prevPocMsb = pocMsb;
+            m_prevPocLsb = pocLsb;
+        }
+    } else {
+        const int32_t maxFrameNum = 1 << (sps->log2_max_frame_num_minus4 + 4);
+        int32_t frameNumOffset = m_prevFrameNumOffset;
+        if (idr)
+            frameNumOffset = 0;
+        else if (m_prevFrameNum > slice.frame_num)
+            frameNumOffset += maxFrameNum;
+
+        if (sps->pic_order_cnt_type == 1) {
+            //8.2.1.2
+            const uint32_t cycle = sps->num_ref_frames_in_pic_order_cnt_cycle;
+            int32_t absFrameNum = cycle ? frameNumOffset + slice.frame_num : 0;
+            if (!nalu.nal_ref_idc && absFrameNum > 0)
+                absFrameNum--;
+            int32_t expectedPoc = 0;
+            if (absFrameNum > 0) {
+                int32_t deltaPerCycle = 0;
+                for (uint32_t i = 0; i < cycle; i++)
+                    deltaPerCycle += sps->offset_for_ref_frame[i];
+                const int32_t cycleCnt = (absFrameNum - 1) / cycle;
+                const uint32_t inCycle = (absFrameNum - 1) % cycle;
+                expectedPoc = cycleCnt * deltaPerCycle;
+                for (uint32_t i = 0; i <= inCycle; i++)
+                    expectedPoc += sps->offset_for_ref_frame[i];
+            }
+            if (!nalu.nal_ref_idc)
+                expectedPoc += sps->offset_for_non_ref_pic;
+            if (!slice.field_pic_flag) {
+                top = expectedPoc + slice.delta_pic_order_cnt[0];
+                bottom = top + sps->offset_for_top_to_bottom_field
+                    + slice.delta_pic_order_cnt[1];
+            } else if (!slice.bottom_field_flag) {
+                top = bottom = expectedPoc + slice.delta_pic_order_cnt[0];
+            } else {
+                top = bottom = expectedPoc + sps->offset_for_top_to_bottom_field
+                    + slice.delta_pic_order_cnt[0];
+            }
+        } else {
+            //8.2.1.3
+            int32_t poc = 0;
+            if (!idr)
+                poc = 2 * (frameNumOffset + slice.frame_num) - !nalu.nal_ref_idc;
+            top = bottom = poc;
+        }
+        m_prevFrameNumOffset = frameNumOffset;
+        m_prevFrameNum = slice.frame_num;
+    }
+
+    const int32_t poc = std::min(top, bottom);
+    if (hasMmco5(slice)) {
+        //the picture is taken as poc 0 by the pictures after it
+        m_prevFrameNumOffset = 0;
+        m_prevFrameNum = 0;
+        m_prevPocMsb = 0;
+        m_prevPocLsb = slice.bottom_field_flag ? 0 : top - poc;
+    }
+    return poc;
+}
+
+bool StreamAnalyzerH264::parseSlice(NalUnit& nalu, FrameRecords& frames, uint64_t offset)
+{
+    m_slice.reset();
+    if (!m_slice.parseHeader(&m_parser, &nalu))
+        return false;
+
+    const char type = sliceTypeToChar(m_slice.slice_type);
+    if (!m_slice.first_mb_in_slice || frames.empty()) {
+        const PPS* const pps = m_slice.m_pps.get();
+        const SPS* const sps = pps->m_sps.get();
+        FrameRecord record;
+        record.offset = offset;
+        record.type = type;
+        record.key = nalu.m_idrPicFlag;
+        record.poc = calcPoc(m_slice, nalu);
+        record.qp = 26 + pps->pic_init_qp_minus26 + m_slice.slice_qp_delta;
+        record.width = sps->m_width;
+        record.height = sps->m_height;
+        frames.push_back(record);
+    }
+
+    FrameRecord& record = frames.back();
+    if (type == 'B' || (type == 'P' && record.type == 'I'))
+        record.type = type;
+    record.size += nalu.m_size;
+    record.slices++;
+    return true;
+}
+
+bool StreamAnalyzerH264::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    NalReader nr(data, size);
+    const uint8_t* nal;
+    int32_t nalSize;
+    NalUnit nalu;
+
+    while (nr.read(nal, nalSize)) {
+        if (!nalu.parseNalUnit(nal, nalSize)) {
+            m_errors++;
+            continue;
+        }
+        bool ret = true;
+        switch (nalu.nal_unit_type) {
+        case NAL_SPS: {
+            SharedPtr<SPS> sps;
+            ret = m_parser.parseSps(sps, &nalu);
+            break;
+        }
+        case NAL_PPS: {
+            SharedPtr<PPS> pps;
+            ret = m_parser.parsePps(pps, &nalu);
+            break;
+        }
+        case NAL_SLICE_NONIDR:
+        case NAL_SLICE_DPA:
+        case NAL_SLICE_IDR:
+            ret = parseSlice(nalu, frames, nal - data);
+            break;
+        default:
+            break;
+        }
+        if (!ret)
+            m_errors++;
+    }
+    return true;
+}
+}
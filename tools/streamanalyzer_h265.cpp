@@ -0,0 +1,198 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/h265Parser.h"
+#include "common/nalreader.h"
+
+namespace YamiMediaCodec {
+using namespace YamiParser::H265;
+
+class StreamAnalyzerH265 : public StreamAnalyzer {
+public:
+    StreamAnalyzerH265()
+        : m_prevPocMsb(0)
+        , m_prevPocLsb(0)
+        , m_newStream(true)
+    {
+    }
+
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    bool parseSlice(const NalUnit& nalu, FrameRecords& frames, uint64_t offset);
+    int32_t calcPoc(const SliceHeader& slice, const NalUnit& nalu);
+
+    static const bool s_registered;
+
+    Parser m_parser;
+    SliceHeader m_slice;
+
+    //8.3.1, state carried from the previous pictures
+    int32_t m_prevPocMsb;
+    int32_t m_prevPocLsb;
+    //next irap has NoRaslOutputFlag set
+    bool m_newStream;
+};
+
+const bool StreamAnalyzerH265::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerH265>("h265");
+
+static bool isIrap(const NalUnit& nalu)
+{
+    return nalu.nal_unit_type >= NalUnit::BLA_W_LP
+        && nalu.nal_unit_type <= NalUnit::RSV_IRAP_VCL23;
+}
+
+static bool isIdr(const NalUnit& nalu)
+{
+    return nalu.nal_unit_type == NalUnit::IDR_W_RADL
+        || nalu.nal_unit_type == NalUnit::IDR_N_LP;
+}
+
+static bool isBla(const NalUnit& nalu)
+{
+    return nalu.nal_unit_type >= NalUnit::BLA_W_LP
+        && nalu.nal_unit_type <= NalUnit::BLA_N_LP;
+}
+
+static bool isRaslOrRadl(const NalUnit& nalu)
+{
+    return nalu.nal_unit_type >= NalUnit::RADL_N
+        && nalu.nal_unit_type <= NalUnit::RASL_R;
+}
+
+//sub-layer non-reference pictures have even types below RSV_VCL_N14
+static bool isSublayerNoRef(const NalUnit& nalu)
+{
+    return nalu.nal_unit_type <= NalUnit::RSV_VCL_N14 && !(nalu.nal_unit_type & 1);
+}
+
+static char sliceTypeToChar(uint8_t sliceType)
+{
+    //B, P, I
+    static const char types[] = { 'B', 'P', 'I' };
+    return types[sliceType];
+}
+
+int32_t StreamAnalyzerH265::calcPoc(const SliceHeader& slice, const NalUnit& nalu)
+{
+    const SPS* const sps = slice.pps->sps.get();
+    const int32_t maxPocLsb = 1 << (sps->log2_max_pic_order_cnt_lsb_minus4 + 4);
+    const int32_t pocLsb = slice.slice_pic_order_cnt_lsb;
+
+    int32_t pocMsb = m_prevPocMsb;
+    if (isIrap(nalu) && (isIdr(nalu) || isBla(nalu) || m_newStream)) {
+        pocMsb = 0;
+    } else if (pocLsb < m_prevPocLsb && m_prevPocLsb - pocLsb >= maxPocLsb / 2) {
+        pocMsb += maxPocLsb;
+    } else if (pocLsb > m_prevPocLsb && pocLsb - m_prevPocLsb > maxPocLsb / 2) {
+        pocMsb -= maxPocLsb;
+    }
+    if (isIrap(nalu))
+        m_newStream = false;
+
+    if (nalu.nuh_temporal_id_plus1 == 1 && !isRaslOrRadl(nalu) && !isSublayerNoRef(nalu)) {
+        m_prevPocMsb = pocMsb;
+        m_prevPocLsb = pocLsb;
+    }
+    return pocMsb + pocLsb;
+}
+
+bool StreamAnalyzerH265::parseSlice(const NalUnit& nalu, FrameRecords& frames, uint64_t offset)
+{
+    m_slice.reset();
+    if (!m_parser.parseSlice(&nalu, &m_slice))
+        return false;
+
+    //dependent slice segments only carry the segment address,
+    //the rest belongs to the slice they continue
+    if (m_slice.dependent_slice_segment_flag) {
+        if (frames.empty())
+            return false;
+        frames.back().size += nalu.m_size;
+        return true;
+    }
+
+    const char type = sliceTypeToChar(m_slice.slice_type);
+    if (m_slice.first_slice_segment_in_pic_flag || frames.empty()) {
+        const PPS* const pps = m_slice.pps.get();
+        const SPS* const sps = pps->sps.get();
+        FrameRecord record;
+        record.offset = offset;
+        record.type = type;
+        record.key = isIrap(nalu);
+        record.poc = calcPoc(m_slice, nalu);
+        record.qp = 26 + pps->init_qp_minus26 + m_slice.qp_delta;
+        record.width = sps->pic_width_in_luma_samples;
+        record.height = sps->pic_height_in_luma_samples;
+        frames.push_back(record);
+    }
+
+    FrameRecord& record = frames.back();
+    if (type == 'B' || (type == 'P' && record.type == 'I'))
+        record.type = type;
+    record.size += nalu.m_size;
+    record.slices++;
+    return true;
+}
+
+bool StreamAnalyzerH265::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    NalReader nr(data, size);
+    const uint8_t* nal;
+    int32_t nalSize;
+    NalUnit nalu;
+
+    while (nr.read(nal, nalSize)) {
+        if (!nalu.parseNaluHeader(nal, nalSize)) {
+            m_errors++;
+            continue;
+        }
+        bool ret = true;
+        //reserved vcl types are skipped, like the decoder does
+        if (nalu.nal_unit_type <= NalUnit::RASL_R
+            || (nalu.nal_unit_type >= NalUnit::BLA_W_LP && nalu.nal_unit_type <= NalUnit::CRA_NUT)) {
+            ret = parseSlice(nalu, frames, nal - data);
+        } else {
+            switch (nalu.nal_unit_type) {
+            case NalUnit::VPS_NUT:
+                ret = m_parser.parseVps(&nalu);
+                break;
+            case NalUnit::SPS_NUT:
+                ret = m_parser.parseSps(&nalu);
+                break;
+            case NalUnit::PPS_NUT:
+                ret = m_parser.parsePps(&nalu);
+                break;
+            case NalUnit::EOS_NUT:
+                m_newStream = true;
+                break;
+            default:
+                break;
+            }
+        }
+        if (!ret)
+            m_errors++;
+    }
+    return true;
+}
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/jpegParser.h"
+
+#include <string.h>
+
+using ::YamiParser::JPEG::Parser;
+using ::std::bind;
+using ::std::ref;
+
+namespace YamiMediaCodec {
+
+class StreamAnalyzerJPEG : public StreamAnalyzer {
+public:
+    StreamAnalyzerJPEG()
+        : m_scans(0)
+        , m_sawEOI(false)
+    {
+    }
+
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    Parser::CallbackResult onStartOfScan();
+    Parser::CallbackResult onEndOfImage();
+
+    static const bool s_registered;
+
+    uint32_t m_scans;
+    bool m_sawEOI;
+};
+
+const bool StreamAnalyzerJPEG::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerJPEG>("jpeg");
+
+Parser::CallbackResult StreamAnalyzerJPEG::onStartOfScan()
+{
+    m_scans++;
+    return Parser::ParseContinue;
+}
+
+Parser::CallbackResult StreamAnalyzerJPEG::onEndOfImage()
+{
+    //stop here, the next image gets its own parser
+    m_sawEOI = true;
+    return Parser::ParseSuspend;
+}
+
+/* a single image or mjpeg, images one after another */
+bool StreamAnalyzerJPEG::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    using namespace ::YamiParser::JPEG;
+
+    static const uint8_t soi[] = { 0xFF, M_SOI };
+    const Parser::Callback sosCallback = bind(&StreamAnalyzerJPEG::onStartOfScan, ref(*this));
+    const Parser::Callback eoiCallback = bind(&StreamAnalyzerJPEG::onEndOfImage, ref(*this));
+
+    size_t pos = 0;
+    while (size - pos > sizeof(soi)) {
+        const uint8_t* start = (const uint8_t*)memmem(data + pos, size - pos, soi, sizeof(soi));
+        if (!start)
+            break;
+        pos = start - data;
+
+        Parser parser(start, size - pos);
+        parser.registerCallback(M_SOS, sosCallback);
+        parser.registerCallback(M_EOI, eoiCallback);
+        m_scans = 0;
+        m_sawEOI = false;
+        if (!parser.parse() || !m_sawEOI || !parser.frameHeader()) {
+            //resync on the next soi
+            m_errors++;
+            pos += sizeof(soi);
+            continue;
+        }
+
+        const FrameHeader::Shared& header = parser.frameHeader();
+        FrameRecord record;
+        record.offset = pos;
+        record.size = parser.current().position + 1;
+        record.type = 'I';
+        record.key = true;
+        record.slices = m_scans;
+        record.width = header->imageWidth;
+        record.height = header->imageHeight;
+        frames.push_back(record);
+        pos += record.size;
+    }
+    return true;
+}
+}
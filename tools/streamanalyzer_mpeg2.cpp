@@ -0,0 +1,142 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/mpeg2_parser.h"
+#include "common/nalreader.h"
+
+namespace YamiMediaCodec {
+using namespace YamiParser::MPEG2;
+
+class StreamAnalyzerMPEG2 : public StreamAnalyzer {
+public:
+    StreamAnalyzerMPEG2()
+        : m_inPicture(false)
+    {
+    }
+
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    bool parseUnit(DecodeUnit& du, FrameRecords& frames, uint64_t offset);
+    bool parseExtension(const DecodeUnit& du);
+
+    static const bool s_registered;
+
+    Parser m_parser;
+    SharedPtr<QuantMatrices> m_matrices;
+    Slice m_slice;
+    //picture header seen, slices and extensions belong to the last record
+    bool m_inPicture;
+};
+
+const bool StreamAnalyzerMPEG2::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerMPEG2>("mpeg2");
+
+bool StreamAnalyzerMPEG2::parseExtension(const DecodeUnit& du)
+{
+    YamiParser::BitReader br(du.m_data, du.m_size);
+    uint32_t id;
+    if (!br.read(id, 4))
+        return false;
+    switch (id) {
+    case kSequence:
+        return m_parser.parseSequenceExtension(br);
+    case kPictureCoding:
+        return m_parser.parsePictureCodingExtension(br);
+    case kQuantizationMatrix:
+        return m_parser.parseQuantMatrixExtension(br, m_matrices);
+    default:
+        break;
+    }
+    return true;
+}
+
+bool StreamAnalyzerMPEG2::parseUnit(DecodeUnit& du, FrameRecords& frames, uint64_t offset)
+{
+    if (du.isSlice()) {
+        if (!m_inPicture)
+            return false;
+        if (!m_parser.parseSlice(m_slice, du))
+            return false;
+        FrameRecord& record = frames.back();
+        if (!record.slices)
+            record.qp = m_slice.quantiser_scale_code;
+        record.slices++;
+        record.size += du.m_size + 1;
+        return true;
+    }
+
+    bool ret = true;
+    switch (du.m_type) {
+    case MPEG2_PICTURE_START_CODE: {
+        if (!m_parser.parsePictureHeader(du))
+            return false;
+        static const char types[] = { '-', 'I', 'P', 'B' };
+        const uint32_t codingType = m_parser.m_pictureHeader.picture_coding_type;
+        FrameRecord record;
+        record.offset = offset;
+        record.type = codingType <= kBFrame ? types[codingType] : '-';
+        record.key = codingType == kIFrame;
+        //no poc in mpeg2, temporal_reference is the display order in the gop
+        record.poc = m_parser.m_pictureHeader.temporal_reference;
+        record.width = m_parser.getWidth();
+        record.height = m_parser.getHeight();
+        frames.push_back(record);
+        m_inPicture = true;
+        break;
+    }
+    case MPEG2_EXTENSION_START_CODE:
+        ret = parseExtension(du);
+        break;
+    case MPEG2_USER_DATA_START_CODE:
+        break;
+    case MPEG2_SEQUENCE_HEADER_CODE:
+        m_inPicture = false;
+        return m_parser.parseSequenceHeader(du, m_matrices);
+    case MPEG2_GROUP_START_CODE:
+        m_inPicture = false;
+        return m_parser.parseGOPHeader(du);
+    default:
+        //pack and pes headers of a program stream don't end the picture
+        if ((uint32_t)du.m_type < MPEG2_PROGRAM_END_CODE)
+            m_inPicture = false;
+        return true;
+    }
+    if (m_inPicture)
+        frames.back().size += du.m_size + 1;
+    return ret;
+}
+
+bool StreamAnalyzerMPEG2::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    NalReader nr(data, size);
+    const uint8_t* nal;
+    int32_t nalSize;
+    DecodeUnit du;
+
+    while (nr.read(nal, nalSize)) {
+        if (!du.parse(nal, nalSize) || !parseUnit(du, frames, nal - data))
+            m_errors++;
+    }
+    return true;
+}
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/vc1Parser.h"
+#include "common/log.h"
+#include "common/nalreader.h"
+
+namespace YamiMediaCodec {
+using namespace YamiParser::VC1;
+
+class StreamAnalyzerVC1 : public StreamAnalyzer {
+public:
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    bool analyzeRcv(const uint8_t* data, size_t size, FrameRecords& frames);
+    bool analyzeAdvanced(const uint8_t* data, size_t size, FrameRecords& frames);
+    bool parseFrame(const uint8_t* data, uint32_t size, FrameRecord& record);
+
+    static const bool s_registered;
+
+    Parser m_parser;
+};
+
+const bool StreamAnalyzerVC1::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerVC1>("vc1");
+
+enum {
+    //SMPTE 421M annex e, bdu types
+    BDU_END_OF_SEQUENCE = 0x0A,
+    BDU_SLICE = 0x0B,
+    BDU_FIELD = 0x0C,
+    BDU_FRAME = 0x0D,
+    BDU_ENTRY_POINT = 0x0E,
+    BDU_SEQUENCE_HEADER = 0x0F,
+
+    //annex l, rcv file
+    RCV_V1_HEADER_SIZE = 20,
+    RCV_V2_HEADER_SIZE = 36,
+    RCV_V2_FLAG = 0x40
+};
+
+static uint32_t readLe32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool StreamAnalyzerVC1::parseFrame(const uint8_t* data, uint32_t size, FrameRecord& record)
+{
+    //the parser takes non const data, but only reads it
+    uint8_t* frame = const_cast<uint8_t*>(data);
+    if (!m_parser.parseFrameHeader(frame, size))
+        return false;
+
+    static const char types[] = { 'I', 'P', 'B', 'B', 'S' };
+    const FrameHdr& hdr = m_parser.m_frameHdr;
+    record.type = hdr.picture_type <= FRAME_SKIPPED ? types[hdr.picture_type] : '-';
+    if (hdr.picture_type != FRAME_SKIPPED)
+        record.qp = hdr.pquant;
+    record.width = m_parser.m_seqHdr.coded_width;
+    record.height = m_parser.m_seqHdr.coded_height;
+    return true;
+}
+
+/* simple and main profile, frames come with their sizes */
+bool StreamAnalyzerVC1::analyzeRcv(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    const bool v2 = data[3] & RCV_V2_FLAG;
+    const size_t headerSize = v2 ? RCV_V2_HEADER_SIZE : RCV_V1_HEADER_SIZE;
+    const uint32_t frameHeaderSize = v2 ? 8 : 4;
+    if (size < headerSize || readLe32(data + 4) != 4) {
+        ERROR("bad rcv header");
+        return false;
+    }
+
+    m_parser.m_seqHdr.coded_height = readLe32(data + 12);
+    m_parser.m_seqHdr.coded_width = readLe32(data + 16);
+    if (!m_parser.parseCodecData(const_cast<uint8_t*>(data + 8), 4))
+        return false;
+
+    size_t pos = headerSize;
+    while (size - pos >= frameHeaderSize) {
+        const uint32_t value = readLe32(data + pos);
+        const uint32_t frameSize = value & 0xffffff;
+        pos += frameHeaderSize;
+        if (frameSize > size - pos)
+            break;
+
+        FrameRecord record;
+        record.offset = pos;
+        record.size = frameSize;
+        record.key = value & 0x80000000;
+        record.slices = 1;
+        if (!frameSize) {
+            //zero sized frames repeat the previous one
+            record.type = 'S';
+            record.slices = 0;
+        } else if (!parseFrame(data + pos, frameSize, record)) {
+            m_errors++;
+        }
+        frames.push_back(record);
+        pos += frameSize;
+    }
+    return true;
+}
+
+/* advanced profile elementary stream, everything is in bdus */
+bool StreamAnalyzerVC1::analyzeAdvanced(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    NalReader nr(data, size);
+    const uint8_t* bdu;
+    int32_t bduSize;
+    bool inFrame = false;
+
+    while (nr.read(bdu, bduSize)) {
+        if (bduSize < 1)
+            continue;
+        //the parser wants the start code in front of the bdu
+        const uint8_t* withStartCode = bdu - 3;
+        const uint32_t sizeWithStartCode = bduSize + 3;
+        switch (bdu[0]) {
+        case BDU_SEQUENCE_HEADER:
+        case BDU_ENTRY_POINT:
+            inFrame = false;
+            if (!m_parser.parseCodecData(const_cast<uint8_t*>(withStartCode), sizeWithStartCode))
+                m_errors++;
+            break;
+        case BDU_FRAME: {
+            FrameRecord record;
+            record.offset = bdu - data;
+            record.size = bduSize;
+            record.slices = 1;
+            if (m_parser.m_seqHdr.profile != PROFILE_ADVANCED
+                || !parseFrame(withStartCode, sizeWithStartCode, record)) {
+                m_errors++;
+            }
+            record.key = record.type == 'I';
+            frames.push_back(record);
+            inFrame = true;
+            break;
+        }
+        case BDU_SLICE:
+        case BDU_FIELD:
+            if (!inFrame) {
+                m_errors++;
+                break;
+            }
+            frames.back().size += bduSize;
+            frames.back().slices += bdu[0] == BDU_SLICE;
+            break;
+        case BDU_END_OF_SEQUENCE:
+            inFrame = false;
+            break;
+        default:
+            //user data
+            if (inFrame)
+                frames.back().size += bduSize;
+            break;
+        }
+    }
+    return true;
+}
+
+bool StreamAnalyzerVC1::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    //rcv starts with the frame count, its top byte is 0x85 or 0xc5
+    if (size >= RCV_V1_HEADER_SIZE && (data[3] & ~RCV_V2_FLAG) == 0x85)
+        return analyzeRcv(data, size, frames);
+    return analyzeAdvanced(data, size, frames);
+}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "codecparsers/vp8_parser.h"
+#include "common/log.h"
+
+namespace YamiMediaCodec {
+using namespace YamiParser;
+
+class StreamAnalyzerVP8 : public StreamAnalyzer {
+public:
+    StreamAnalyzerVP8()
+        : m_width(0)
+        , m_height(0)
+    {
+    }
+
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    static const bool s_registered;
+
+    Vp8Parser m_parser;
+    Vp8FrameHeader m_header;
+    //only key frames carry the size
+    uint32_t m_width;
+    uint32_t m_height;
+};
+
+const bool StreamAnalyzerVP8::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerVP8>("vp8");
+
+bool StreamAnalyzerVP8::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    IvfReader reader(data, size);
+    if (!reader.isValid()) {
+        ERROR("vp8 is only supported in ivf");
+        return false;
+    }
+
+    const uint8_t* frame;
+    uint32_t frameSize;
+    while (reader.read(frame, frameSize)) {
+        FrameRecord record;
+        record.offset = frame - data;
+        record.size = frameSize;
+        if (m_parser.ParseFrame(frame, frameSize, &m_header) != VP8_PARSER_OK) {
+            m_errors++;
+            frames.push_back(record);
+            continue;
+        }
+        record.key = m_header.IsKeyframe();
+        record.type = record.key ? 'I' : 'P';
+        record.shown = m_header.show_frame;
+        record.qp = m_header.quantization_hdr.y_ac_qi;
+        //token partitions are the closest thing vp8 has to slices
+        record.slices = m_header.num_of_dct_partitions;
+        if (record.key) {
+            m_width = m_header.width;
+            m_height = m_header.height;
+        }
+        record.width = m_width;
+        record.height = m_height;
+        frames.push_back(record);
+    }
+    return true;
+}
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "VideoCommonDefs.h"
+#include "codecparsers/vp9SuperFrame.h"
+#include "codecparsers/vp9parser.h"
+#include "common/log.h"
+
+namespace YamiMediaCodec {
+
+using YamiParser::Vp9Parser;
+using YamiParser::Vp9SuperFrameIterator;
+
+class StreamAnalyzerVP9 : public StreamAnalyzer {
+public:
+    virtual bool analyze(const uint8_t* data, size_t size, FrameRecords& frames);
+
+private:
+    void parseFrame(const uint8_t* frame, uint32_t size, FrameRecord& record);
+
+    static const bool s_registered;
+
+    Vp9Parser m_parser;
+};
+
+const bool StreamAnalyzerVP9::s_registered
+    = StreamAnalyzerFactory::register_<StreamAnalyzerVP9>("vp9");
+
+void StreamAnalyzerVP9::parseFrame(const uint8_t* frame, uint32_t size, FrameRecord& record)
+{
+    Vp9FrameHdr hdr;
+    if (m_parser.parse(hdr, frame, size) != VP9_PARSER_OK) {
+        m_errors++;
+        return;
+    }
+    if (hdr.show_existing_frame) {
+        //only a reference to an earlier frame, nothing is coded
+        record.type = 'S';
+        return;
+    }
+    record.key = hdr.frame_type == VP9_KEY_FRAME;
+    record.type = record.key || hdr.intra_only ? 'I' : 'P';
+    record.shown = hdr.show_frame;
+    record.qp = hdr.base_qindex;
+    record.slices = 1;
+    record.width = hdr.width;
+    record.height = hdr.height;
+}
+
+bool StreamAnalyzerVP9::analyze(const uint8_t* data, size_t size, FrameRecords& frames)
+{
+    IvfReader reader(data, size);
+    if (!reader.isValid()) {
+        ERROR("vp9 is only supported in ivf");
+        return false;
+    }
+
+    const uint8_t* ivfFrame;
+    uint32_t ivfFrameSize;
+    Vp9SuperFrameIterator superFrame;
+    while (reader.read(ivfFrame, ivfFrameSize)) {
+        if (!superFrame.init(ivfFrame, ivfFrameSize)) {
+            m_errors++;
+            continue;
+        }
+        const uint8_t* frame;
+        uint32_t frameSize;
+        while (superFrame.next(frame, frameSize)) {
+            FrameRecord record;
+            record.offset = frame - data;
+            record.size = frameSize;
+            parseFrame(frame, frameSize, record);
+            frames.push_back(record);
+        }
+    }
+    return true;
+}
+}
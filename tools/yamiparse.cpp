@@ -0,0 +1,252 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamanalyzer.h"
+
+#include "VideoCommonDefs.h"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+
+using namespace YamiMediaCodec;
+
+struct ExtensionToCodec {
+    const char* extension;
+    const char* codec;
+};
+
+static const ExtensionToCodec extensionToCodec[] = {
+    { "264", "h264" },
+    { "h264", "h264" },
+    { "avc", "h264" },
+    { "jsv", "h264" },
+    { "jvt", "h264" },
+    { "26l", "h264" },
+    { "265", "h265" },
+    { "h265", "h265" },
+    { "hevc", "h265" },
+    { "bit", "h265" },
+    { "m2v", "mpeg2" },
+    { "mpv", "mpeg2" },
+    { "mpeg2", "mpeg2" },
+    { "vc1", "vc1" },
+    { "rcv", "vc1" },
+    { "jpg", "jpeg" },
+    { "jpeg", "jpeg" },
+    { "mjpg", "jpeg" },
+    { "mjpeg", "jpeg" },
+};
+
+static std::string guessCodec(const char* fileName, const uint8_t* data, size_t size)
+{
+    const char* dot = strrchr(fileName, '.');
+    if (!dot)
+        return "";
+    const char* extension = dot + 1;
+    if (!strcasecmp(extension, "ivf")) {
+        IvfReader reader(data, size);
+        if (reader.fourcc() == 0x30385056) //VP80
+            return "vp8";
+        if (reader.fourcc() == 0x30395056) //VP90
+            return "vp9";
+        return "";
+    }
+    for (size_t i = 0; i < sizeof(extensionToCodec) / sizeof(extensionToCodec[0]); i++) {
+        if (!strcasecmp(extension, extensionToCodec[i].extension))
+            return extensionToCodec[i].codec;
+    }
+    return "";
+}
+
+static void printHelp(const char* app)
+{
+    StreamAnalyzerFactory::Keys keys = StreamAnalyzerFactory::keys();
+    std::string codecs;
+    for (size_t i = 0; i < keys.size(); i++)
+        codecs += " " + keys[i];
+
+    printf("%s <options> <input file>\n", app);
+    printf("   parses the stream without decoding it and prints one line per picture\n");
+    printf("   -c <codec> one of:%s\n", codecs.c_str());
+    printf("      default: guessed from the file extension\n");
+    printf("   -n <count> parse the stream count times, for throughput\n");
+    printf("   -q only print the summary\n");
+    printf("   -h print help\n");
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char* toString(int32_t value, char* buf, size_t size)
+{
+    if (value == FrameRecord::NONE)
+        return "-";
+    snprintf(buf, size, "%d", value);
+    return buf;
+}
+
+static void printFrames(const StreamAnalyzer::FrameRecords& frames)
+{
+    char poc[16], qp[16];
+    printf("%6s %10s %8s %4s %3s %5s %6s %4s %6s %s\n",
+        "frame", "offset", "size", "type", "key", "shown", "poc", "qp", "slices", "resolution");
+    for (size_t i = 0; i < frames.size(); i++) {
+        const FrameRecord& f = frames[i];
+        printf("%6zu %10" PRIu64 " %8u %4c %3d %5d %6s %4s %6u %ux%u\n",
+            i, f.offset, f.size, f.type, f.key, f.shown,
+            toString(f.poc, poc, sizeof(poc)), toString(f.qp, qp, sizeof(qp)),
+            f.slices, f.width, f.height);
+    }
+}
+
+static void printSummary(const std::string& codec, const StreamAnalyzer::FrameRecords& frames,
+    uint32_t errors, size_t size, int loops, double seconds)
+{
+    uint32_t counts[4] = { 0 };
+    for (size_t i = 0; i < frames.size(); i++) {
+        switch (frames[i].type) {
+        case 'I':
+            counts[0]++;
+            break;
+        case 'P':
+            counts[1]++;
+            break;
+        case 'B':
+            counts[2]++;
+            break;
+        default:
+            counts[3]++;
+            break;
+        }
+    }
+    printf("%s: %zu frames (I %u, P %u, B %u, other %u), %zu bytes, %u errors\n",
+        codec.c_str(), frames.size(), counts[0], counts[1], counts[2], counts[3],
+        size, errors);
+
+    if (seconds <= 0)
+        return;
+    const double bytes = (double)size * loops;
+    printf("parsed %d time(s) in %.3f s: %.1f MB/s, %.1f frames/s\n",
+        loops, seconds, bytes / seconds / (1024 * 1024),
+        frames.size() * loops / seconds);
+}
+
+int main(int argc, char** argv)
+{
+    std::string codec;
+    int loops = 1;
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:n:qh")) != -1) {
+        switch (opt) {
+        case 'c':
+            codec = optarg;
+            break;
+        case 'n':
+            loops = atoi(optarg);
+            break;
+        case 'q':
+            quiet = true;
+            break;
+        case 'h':
+        default:
+            printHelp(argv[0]);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (optind >= argc || loops < 1) {
+        printHelp(argv[0]);
+        return -1;
+    }
+    const char* fileName = argv[optind];
+
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "can't open %s\n", fileName);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || !st.st_size) {
+        fprintf(stderr, "can't get the size of %s\n", fileName);
+        close(fd);
+        return -1;
+    }
+    const size_t size = st.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "can't map %s\n", fileName);
+        return -1;
+    }
+    const uint8_t* data = (const uint8_t*)mapped;
+    //fault the pages in, so the first loop is not timing the disk
+    volatile uint8_t sum = 0;
+    for (size_t i = 0; i < size; i += 4096)
+        sum += data[i];
+
+    if (codec.empty())
+        codec = guessCodec(fileName, data, size);
+
+    StreamAnalyzer::FrameRecords frames;
+    uint32_t errors = 0;
+    double seconds = 0;
+    int ret = 0;
+    for (int i = 0; i < loops; i++) {
+        SharedPtr<StreamAnalyzer> analyzer(StreamAnalyzerFactory::create(codec));
+        if (!analyzer.get()) {
+            fprintf(stderr, "unsupported codec \"%s\", use -c\n", codec.c_str());
+            printHelp(argv[0]);
+            ret = -1;
+            break;
+        }
+        frames.clear();
+        const double start = now();
+        if (!analyzer->analyze(data, size, frames)) {
+            fprintf(stderr, "failed to parse %s as %s\n", fileName, codec.c_str());
+            ret = -1;
+            break;
+        }
+        seconds += now() - start;
+        errors = analyzer->errors();
+    }
+
+    if (!ret) {
+        if (!quiet)
+            printFrames(frames);
+        printSummary(codec, frames, errors, size, loops, seconds);
+    }
+    munmap(mapped, size);
+    return ret;
+}
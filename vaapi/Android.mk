@@ -10,6 +10,7 @@ LOCAL_SRC_FILES := \
         vaapidisplay.cpp \
         vaapicontext.cpp \
         vaapisurfaceallocator.cpp \
+        vaapinulldriver.cpp \
 
 LOCAL_C_INCLUDES:= \
         $(LOCAL_PATH)/.. \
@@ -24,30 +24,78 @@
 #include "vaapicontext.h"
 #include "vaapidisplay.h"
 
+#include <inttypes.h>
+#include <string.h>
+
 namespace YamiMediaCodec {
 
+//enough for the slices of a few pictures in flight
+#define MAX_POOLED_BUFFERS 256
+
+/* parameter buffers the drivers parse on the cpu by the time vaEndPicture
+ * returns, they can be reused while the gpu still works on the picture.
+ * buffers the gpu reads itself, like slice data, vp8 probabilities or vc1
+ * bitplanes, are not pooled, nor are the ones it writes */
+static bool isPoolable(VABufferType type)
+{
+    switch (type) {
+    case VAPictureParameterBufferType:
+    case VAIQMatrixBufferType:
+    case VASliceParameterBufferType:
+    case VAHuffmanTableBufferType:
+    case VAQMatrixBufferType:
+    case VAEncSequenceParameterBufferType:
+    case VAEncPictureParameterBufferType:
+    case VAEncSliceParameterBufferType:
+    case VAEncMiscParameterBufferType:
+    case VAEncPackedHeaderParameterBufferType:
+    case VAProcPipelineParameterBufferType:
+        return true;
+    default:
+        return false;
+    }
+}
+
 BufObjectPtr VaapiBuffer::create(const ContextPtr& context,
     VABufferType type,
     uint32_t size,
     const void* data,
-    void** mapped)
+    void** mapped,
+    uint32_t numElements)
 {
     BufObjectPtr buf;
-    if (!size || !context || !context->getDisplay()){
+    if (!size || !numElements || !context || !context->getDisplay()){
         ERROR("vaapibuffer: can't create buffer");
         return buf;
     }
     DisplayPtr display = context->getDisplay();
-    VABufferID id;
-    VAStatus status = vaCreateBuffer(display->getID(), context->getID(),
-        type, size, 1, (void*)data, &id);
-    if (!checkVaapiStatus(status, "vaCreateBuffer"))
-        return buf;
-    buf.reset(new VaapiBuffer(display, id, size));
+    SharedPtr<VaapiBufferPool> pool;
+    VABufferID id = VA_INVALID_ID;
+    if (!data && mapped && isPoolable(type)) {
+        pool = context->getBufferPool();
+        id = pool->acquire(type, size, numElements);
+    }
+    bool reused = id != VA_INVALID_ID;
+    if (!reused) {
+        VAStatus status = vaCreateBuffer(display->getID(), context->getID(),
+            type, size, numElements, (void*)data, &id);
+        if (!checkVaapiStatus(status, "vaCreateBuffer"))
+            return buf;
+    }
+    buf.reset(new VaapiBuffer(display, id, size * numElements));
+    if (pool) {
+        buf->m_pool = pool;
+        buf->m_type = type;
+        buf->m_elementSize = size;
+        buf->m_numElements = numElements;
+    }
     if (mapped) {
         *mapped = buf->map();
         if (!*mapped)
             buf.reset();
+        //callers count on parameters they don't set being 0
+        else if (reused)
+            memset(*mapped, 0, size * numElements);
     }
     return buf;
 }
@@ -86,12 +134,99 @@ VaapiBuffer::VaapiBuffer(const DisplayPtr& display, VABufferID id, uint32_t size
     , m_id(id)
     , m_data(NULL)
     , m_size(size)
+    , m_type(VABufferTypeMax)
+    , m_elementSize(0)
+    , m_numElements(0)
 {
 }
 
 VaapiBuffer::~VaapiBuffer()
 {
     unmap();
+    SharedPtr<VaapiBufferPool> pool = m_pool.lock();
+    if (pool && pool->recycle(m_id, m_type, m_elementSize, m_numElements))
+        return;
     checkVaapiStatus(vaDestroyBuffer(m_display->getID(), m_id), "vaDestroyBuffer");
 }
+
+bool VaapiBufferPool::Key::operator<(const Key& other) const
+{
+    if (type != other.type)
+        return type < other.type;
+    if (size != other.size)
+        return size < other.size;
+    return numElements < other.numElements;
+}
+
+VaapiBufferPool::VaapiBufferPool(const DisplayPtr& display)
+    : m_display(display)
+    , m_count(0)
+    , m_closed(false)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+VaapiBufferPool::~VaapiBufferPool()
+{
+    destroyAll();
+}
+
+VABufferID VaapiBufferPool::acquire(VABufferType type, uint32_t size, uint32_t numElements)
+{
+    Key key = { type, size, numElements };
+    AutoLock lock(m_lock);
+    Buffers::iterator it = m_buffers.find(key);
+    if (it == m_buffers.end() || it->second.empty()) {
+        m_misses++;
+        return VA_INVALID_ID;
+    }
+    m_hits++;
+    m_count--;
+    VABufferID id = it->second.back();
+    it->second.pop_back();
+    return id;
+}
+
+bool VaapiBufferPool::recycle(VABufferID id, VABufferType type, uint32_t size, uint32_t numElements)
+{
+    Key key = { type, size, numElements };
+    AutoLock lock(m_lock);
+    if (m_closed || m_count >= MAX_POOLED_BUFFERS)
+        return false;
+    m_buffers[key].push_back(id);
+    m_count++;
+    return true;
+}
+
+void VaapiBufferPool::close()
+{
+    AutoLock lock(m_lock);
+    DEBUG("vaapibuffer: pool %" PRIu64 " hits, %" PRIu64 " misses", m_hits, m_misses);
+    m_closed = true;
+    destroyAll();
+}
+
+void VaapiBufferPool::destroyAll()
+{
+    for (Buffers::iterator it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+        const std::vector<VABufferID>& ids = it->second;
+        for (size_t i = 0; i < ids.size(); i++)
+            checkVaapiStatus(vaDestroyBuffer(m_display->getID(), ids[i]), "vaDestroyBuffer");
+    }
+    m_buffers.clear();
+    m_count = 0;
+}
+
+uint64_t VaapiBufferPool::getHits()
+{
+    AutoLock lock(m_lock);
+    return m_hits;
+}
+
+uint64_t VaapiBufferPool::getMisses()
+{
+    AutoLock lock(m_lock);
+    return m_misses;
+}
 }
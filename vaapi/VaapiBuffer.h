@@ -18,20 +18,29 @@
 #define VaapiBuffer_h
 
 #include "common/NonCopyable.h"
+#include "common/lock.h"
 #include "vaapiptrs.h"
 
 #include <va/va.h>
 #include <stdint.h>
+#include <map>
+#include <vector>
 
 namespace YamiMediaCodec {
 
+class VaapiBufferPool;
+
+/* parameter buffers created mapped and without data are taken from and
+ * given back to the context's VaapiBufferPool, if the drivers are known to
+ * be done with their content once vaEndPicture returns */
 class VaapiBuffer {
 public:
     static BufObjectPtr create(const ContextPtr&,
         VABufferType,
         uint32_t size,
         const void* data = 0,
-        void** mapped = 0);
+        void** mapped = 0,
+        uint32_t numElements = 1);
 
     template <class T>
     static BufObjectPtr create(const ContextPtr&,
@@ -49,9 +58,57 @@ private:
     VABufferID m_id;
     void* m_data;
     uint32_t m_size;
+
+    //where the buffer goes back to, if it is a recyclable one
+    WeakPtr<VaapiBufferPool> m_pool;
+    VABufferType m_type;
+    uint32_t m_elementSize;
+    uint32_t m_numElements;
     DISALLOW_COPY_AND_ASSIGN(VaapiBuffer);
 };
 
+/* released parameter buffers of a VaapiContext, keyed by type and size,
+ * so steady state decoding and encoding create no buffer at all.
+ * buffers are kept unmapped: VaapiPicture unmaps each one before
+ * vaRenderPicture, so a reused buffer is mapped and cleared again in
+ * VaapiBuffer::create, like a new one */
+class VaapiBufferPool {
+public:
+    explicit VaapiBufferPool(const DisplayPtr&);
+    ~VaapiBufferPool();
+
+    //a released buffer matching type and size, or VA_INVALID_ID
+    VABufferID acquire(VABufferType, uint32_t size, uint32_t numElements);
+    //false if the pool is full or closed, the caller destroys the buffer then
+    bool recycle(VABufferID, VABufferType, uint32_t size, uint32_t numElements);
+
+    //destroy all kept buffers, recycle() fails after this
+    void close();
+
+    uint64_t getHits();
+    uint64_t getMisses();
+
+private:
+    struct Key {
+        VABufferType type;
+        uint32_t size;
+        uint32_t numElements;
+        bool operator<(const Key&) const;
+    };
+    typedef std::map<Key, std::vector<VABufferID> > Buffers;
+
+    void destroyAll();
+
+    DisplayPtr m_display;
+    Lock m_lock;
+    Buffers m_buffers;
+    uint32_t m_count;
+    bool m_closed;
+    uint64_t m_hits;
+    uint64_t m_misses;
+    DISALLOW_COPY_AND_ASSIGN(VaapiBufferPool);
+};
+
 template <class T>
 BufObjectPtr VaapiBuffer::create(const ContextPtr& context,
     VABufferType type, T*& mapped)
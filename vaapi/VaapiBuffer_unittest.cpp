@@ -0,0 +1,143 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// The unittest header must be included before the va headers,
+// see vaapidisplay_unittest.cpp.
+#include "common/unittest.h"
+
+// primary header
+#include "VaapiBuffer.h"
+
+// library headers
+#include "vaapicontext.h"
+#include "vaapidisplay.h"
+
+namespace YamiMediaCodec {
+
+static ContextPtr createNullContext()
+{
+    ContextPtr context;
+    NativeDisplay native = { 0, NATIVE_DISPLAY_NULL };
+    DisplayPtr display = VaapiDisplay::create(native);
+    if (!display)
+        return context;
+    ConfigPtr config;
+    if (VaapiConfig::create(display, VAProfileH264High, VAEntrypointVLD, NULL, 0, config) != YAMI_SUCCESS)
+        return context;
+    return VaapiContext::create(config, 64, 48, VA_PROGRESSIVE, NULL, 0);
+}
+
+struct Param {
+    uint32_t a;
+    uint32_t b;
+};
+
+#define VAAPI_BUFFER_TEST(name) \
+    TEST(VaapiBufferTest, name)
+
+VAAPI_BUFFER_TEST(RecycleParam)
+{
+    ContextPtr context = createNullContext();
+    ASSERT_TRUE(bool(context));
+    SharedPtr<VaapiBufferPool> pool = context->getBufferPool();
+
+    Param* param;
+    BufObjectPtr buf = VaapiBuffer::create(context, VAPictureParameterBufferType, param);
+    ASSERT_TRUE(bool(buf));
+    VABufferID id = buf->getID();
+    param->a = 1;
+    param->b = 2;
+    buf.reset();
+    EXPECT_EQ(0u, pool->getHits());
+    EXPECT_EQ(1u, pool->getMisses());
+
+    //same type and size, we get the released one back, cleared
+    buf = VaapiBuffer::create(context, VAPictureParameterBufferType, param);
+    ASSERT_TRUE(bool(buf));
+    EXPECT_EQ(id, buf->getID());
+    EXPECT_EQ(0u, param->a);
+    EXPECT_EQ(0u, param->b);
+    EXPECT_EQ(1u, pool->getHits());
+
+    //different type
+    Param* other;
+    BufObjectPtr buf2 = VaapiBuffer::create(context, VAIQMatrixBufferType, other);
+    ASSERT_TRUE(bool(buf2));
+    EXPECT_NE(id, buf2->getID());
+    EXPECT_EQ(2u, pool->getMisses());
+
+    //different element count
+    void* mapped;
+    BufObjectPtr array = VaapiBuffer::create(context, VASliceParameterBufferType,
+        sizeof(Param), NULL, &mapped, 4);
+    ASSERT_TRUE(bool(array));
+    EXPECT_EQ(4 * sizeof(Param), array->getSize());
+    EXPECT_EQ(3u, pool->getMisses());
+}
+
+VAAPI_BUFFER_TEST(DataIsNotRecycled)
+{
+    ContextPtr context = createNullContext();
+    ASSERT_TRUE(bool(context));
+    SharedPtr<VaapiBufferPool> pool = context->getBufferPool();
+
+    uint8_t data[16] = { 1, 2, 3 };
+    BufObjectPtr buf = VaapiBuffer::create(context, VASliceDataBufferType, sizeof(data), data);
+    ASSERT_TRUE(bool(buf));
+    buf.reset();
+    buf = VaapiBuffer::create(context, VASliceDataBufferType, sizeof(data), data);
+    ASSERT_TRUE(bool(buf));
+    EXPECT_EQ(0u, pool->getHits());
+    EXPECT_EQ(0u, pool->getMisses());
+}
+
+VAAPI_BUFFER_TEST(GpuReadIsNotRecycled)
+{
+    ContextPtr context = createNullContext();
+    ASSERT_TRUE(bool(context));
+    SharedPtr<VaapiBufferPool> pool = context->getBufferPool();
+
+    //the gpu may still read it after the picture is rendered
+    Param* prob;
+    BufObjectPtr buf = VaapiBuffer::create(context, VAProbabilityBufferType, prob);
+    ASSERT_TRUE(bool(buf));
+    buf.reset();
+    buf = VaapiBuffer::create(context, VAProbabilityBufferType, prob);
+    ASSERT_TRUE(bool(buf));
+    EXPECT_EQ(0u, pool->getHits());
+    EXPECT_EQ(0u, pool->getMisses());
+}
+
+VAAPI_BUFFER_TEST(OutliveContext)
+{
+    ContextPtr context = createNullContext();
+    ASSERT_TRUE(bool(context));
+    WeakPtr<VaapiBufferPool> pool = context->getBufferPool();
+
+    Param* param;
+    BufObjectPtr buf = VaapiBuffer::create(context, VAPictureParameterBufferType, param);
+    ASSERT_TRUE(bool(buf));
+    context.reset();
+    EXPECT_TRUE(pool.expired());
+    //destroyed, not recycled
+    buf.reset();
+}
+
+} //namespace YamiMediaCodec
@@ -23,6 +23,7 @@
 #include "common/log.h"
 #include "common/common_def.h"
 #include "vaapi/vaapidisplay.h"
+#include "vaapi/VaapiBuffer.h"
 #include "vaapi/VaapiUtils.h"
 #include "vaapi/vaapistreamable.h"
 #include <algorithm>
@@ -133,11 +134,14 @@ ContextPtr VaapiContext::create(const ConfigPtr& config,
 
 VaapiContext::VaapiContext(const ConfigPtr& config, VAContextID context)
 :m_config(config), m_context(context)
+, m_bufferPool(new VaapiBufferPool(config->m_display))
 {
 }
 
 VaapiContext::~VaapiContext()
 {
+    //a buffer released later is destroyed instead of recycled
+    m_bufferPool->close();
     vaDestroyContext(m_config->m_display->getID(), m_context);
 }
 }
@@ -23,6 +23,8 @@
 #include <va/va.h>
 
 namespace YamiMediaCodec{
+class VaapiBufferPool;
+
 class VaapiConfig
 {
 friend class VaapiContext;
@@ -46,12 +48,15 @@ public:
                       int num_render_targets);
     VAContextID getID() const { return m_context; }
     DisplayPtr getDisplay() const { return m_config->m_display; }
+    //parameter buffers of this context are recycled here
+    const SharedPtr<VaapiBufferPool>& getBufferPool() const { return m_bufferPool; }
 
     ~VaapiContext();
 private:
     VaapiContext(const ConfigPtr&,  VAContextID);
     ConfigPtr m_config;
     VAContextID m_context;
+    SharedPtr<VaapiBufferPool> m_bufferPool;
     DISALLOW_COPY_AND_ASSIGN(VaapiContext);
 };
 }
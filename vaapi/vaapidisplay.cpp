@@ -27,6 +27,7 @@
 #include "common/log.h"
 #include "common/lock.h"
 #include "vaapi/VaapiUtils.h"
+#include "vaapi/vaapinulldriver.h"
 #include <inttypes.h>
 
 using std::list;
@@ -40,7 +41,11 @@ using std::list;
    NATIVE_DISPLAY_AUTO; yami will try to open a x11 display first. if fail,
    drm display will try next
 
-4. A x11 display is compatible to drm display, while not reverse.
+4. NATIVE_DISPLAY_NULL, or NATIVE_DISPLAY_AUTO when LIBYAMI_NULL_DRIVER is
+   set, gives an in memory va driver without gpu. an explicit x11, drm or va
+   display is never replaced by it.
+
+5. A x11 display is compatible to drm display, while not reverse.
    it means, when there is a VADisplay created from x11 display already ,
    yami will not create a new display when drm display is requested,
    simplely reuse the VADisplay.
@@ -174,6 +179,37 @@ class NativeDisplayVADisplay : public NativeDisplayBase{
     }
 };
 
+static bool useNullDriver(const NativeDisplay& display)
+{
+    if (display.type == NATIVE_DISPLAY_NULL)
+        return true;
+    //the client asked for a real display, give it one
+    if (display.type != NATIVE_DISPLAY_AUTO)
+        return false;
+    const char* env = getenv("LIBYAMI_NULL_DRIVER");
+    return env && atoi(env);
+}
+
+class NativeDisplayNull : public NativeDisplayBase{
+  public:
+    NativeDisplayNull() :NativeDisplayBase(){ };
+    ~NativeDisplayNull() {
+        if (m_handle)
+            destroyNullDisplay((VADisplay)m_handle);
+    };
+    virtual bool initialize (const NativeDisplay& display) {
+        ASSERT(useNullDriver(display));
+
+        m_handle = (intptr_t)createNullDisplay();
+        m_selfCreated = true;
+        return m_handle != 0;
+    };
+
+    bool isCompatible(const NativeDisplay& display) {
+        return useNullDriver(display);
+    }
+};
+
 typedef SharedPtr<NativeDisplayBase> NativeDisplayPtr;
 
 bool VaapiDisplay::isCompatible(const NativeDisplay& other)
@@ -183,7 +219,8 @@ bool VaapiDisplay::isCompatible(const NativeDisplay& other)
 
 VaapiDisplay::~VaapiDisplay()
 {
-    if (!DynamicPointerCast<NativeDisplayVADisplay>(m_nativeDisplay)) {
+    if (!DynamicPointerCast<NativeDisplayVADisplay>(m_nativeDisplay)
+        && !DynamicPointerCast<NativeDisplayNull>(m_nativeDisplay)) {
         vaTerminate(m_vaDisplay);
     }
 }
@@ -307,7 +344,8 @@ DisplayPtr DisplayCache::createDisplay(const NativeDisplay& nativeDisplay)
     //crate new one
     DEBUG("nativeDisplay: (type : %d), (handle : %" PRIxPTR ")", nativeDisplay.type, nativeDisplay.handle);
 
-    switch (nativeDisplay.type) {
+    bool nullDriver = useNullDriver(nativeDisplay);
+    switch (nullDriver ? NATIVE_DISPLAY_NULL : nativeDisplay.type) {
     case NATIVE_DISPLAY_AUTO:
 #if defined(__ENABLE_X11__)
     case NATIVE_DISPLAY_X11:
@@ -335,6 +373,12 @@ DisplayPtr DisplayCache::createDisplay(const NativeDisplay& nativeDisplay)
             vaDisplay = (VADisplay)nativeDisplayObj->nativeHandle();
         INFO("use vaapi va backend");
         break;
+    case NATIVE_DISPLAY_NULL:
+        nativeDisplayObj.reset (new NativeDisplayNull());
+        if (nativeDisplayObj && nativeDisplayObj->initialize(nativeDisplay))
+            vaDisplay = (VADisplay)nativeDisplayObj->nativeHandle();
+        INFO("use vaapi null backend");
+        break;
     default:
         break;
     }
@@ -344,7 +388,8 @@ DisplayPtr DisplayCache::createDisplay(const NativeDisplay& nativeDisplay)
         return vaapiDisplay;
     }
 
-    if (nativeDisplay.type == NATIVE_DISPLAY_VA || vaInit(vaDisplay)) {
+    //va and null displays are initialized already
+    if (nativeDisplay.type == NATIVE_DISPLAY_VA || nullDriver || vaInit(vaDisplay)) {
         DisplayPtr temp(new VaapiDisplay(nativeDisplayObj, vaDisplay));
         vaapiDisplay = temp;
     }
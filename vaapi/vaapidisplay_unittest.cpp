@@ -34,6 +34,8 @@
 // system headers
 #include <fcntl.h>
 #include <set>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 namespace YamiMediaCodec {
@@ -393,4 +395,86 @@ VAAPI_DISPLAY_TEST(CompatibleVA) {
     EXPECT_TRUE(isCompatible(display, native));
 }
 
+VAAPI_DISPLAY_TEST(CreateNull) {
+    NativeDisplay native = {0, NATIVE_DISPLAY_NULL};
+    DisplayPtr display = VaapiDisplay::create(native);
+
+    ASSERT_TRUE(display.get());
+    EXPECT_TRUE(vaDisplayIsValid(display->getID()));
+
+    // Test the display caching
+    DisplayPtr display2 = VaapiDisplay::create(native);
+
+    ASSERT_TRUE(display2.get());
+    EXPECT_TRUE(display.get() == display2.get());
+
+    EXPECT_TRUE(isCompatible(display, native));
+
+    native.type = NATIVE_DISPLAY_VA;
+    EXPECT_FALSE(isCompatible(display, native));
+
+    native.type = NATIVE_DISPLAY_DRM;
+    EXPECT_FALSE(isCompatible(display, native));
+
+    native.type = NATIVE_DISPLAY_X11;
+    EXPECT_FALSE(isCompatible(display, native));
+
+    native.type = NATIVE_DISPLAY_AUTO;
+    EXPECT_EQ(!!getenv("LIBYAMI_NULL_DRIVER"), isCompatible(display, native));
+}
+
+VAAPI_DISPLAY_TEST(NullDriverPipeline) {
+    NativeDisplay native = {0, NATIVE_DISPLAY_NULL};
+    DisplayPtr display = VaapiDisplay::create(native);
+    ASSERT_TRUE(display.get());
+    VADisplay dpy = display->getID();
+
+    VAConfigAttrib attrib;
+    attrib.type = VAConfigAttribRTFormat;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaGetConfigAttributes(dpy, VAProfileH264High, VAEntrypointVLD, &attrib, 1));
+    EXPECT_TRUE(attrib.value & VA_RT_FORMAT_YUV420);
+
+    VAConfigID config;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaCreateConfig(dpy, VAProfileH264High, VAEntrypointVLD, &attrib, 1, &config));
+
+    VASurfaceID surfaces[2];
+    VASurfaceAttrib surfaceAttrib;
+    surfaceAttrib.flags = VA_SURFACE_ATTRIB_SETTABLE;
+    surfaceAttrib.type = VASurfaceAttribPixelFormat;
+    surfaceAttrib.value.type = VAGenericValueTypeInteger;
+    surfaceAttrib.value.value.i = VA_FOURCC_NV12;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaCreateSurfaces(dpy, VA_RT_FORMAT_YUV420, 64, 48, surfaces, 2, &surfaceAttrib, 1));
+
+    VAContextID context;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaCreateContext(dpy, config, 64, 48, VA_PROGRESSIVE, surfaces, 2, &context));
+
+    uint8_t data[16] = { 1, 2, 3 };
+    VABufferID buffer;
+    void* mapped;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaCreateBuffer(dpy, context, VASliceDataBufferType, sizeof(data), 1, data, &buffer));
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaMapBuffer(dpy, buffer, &mapped));
+    EXPECT_EQ(0, memcmp(mapped, data, sizeof(data)));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaUnmapBuffer(dpy, buffer));
+
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaBeginPicture(dpy, context, surfaces[0]));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaRenderPicture(dpy, context, &buffer, 1));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaEndPicture(dpy, context));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaSyncSurface(dpy, surfaces[0]));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaDestroyBuffer(dpy, buffer));
+
+    VAImage image;
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaDeriveImage(dpy, surfaces[0], &image));
+    EXPECT_EQ((uint32_t)VA_FOURCC_NV12, image.format.fourcc);
+    EXPECT_EQ(2u, image.num_planes);
+    EXPECT_EQ(64u * 48 * 3 / 2, image.data_size);
+    ASSERT_EQ(VA_STATUS_SUCCESS, vaMapBuffer(dpy, image.buf, &mapped));
+    memset(mapped, 0x80, image.data_size);
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaUnmapBuffer(dpy, image.buf));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaDestroyImage(dpy, image.image_id));
+
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaDestroyContext(dpy, context));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaDestroySurfaces(dpy, surfaces, 2));
+    EXPECT_EQ(VA_STATUS_SUCCESS, vaDestroyConfig(dpy, config));
+}
+
 } //namespace YamiMediaCodec
@@ -0,0 +1,806 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vaapi/vaapinulldriver.h"
+
+#include "common/common_def.h"
+#include "common/lock.h"
+#include "common/log.h"
+#include "VideoCommonDefs.h"
+#include <va/va_backend.h>
+#include <va/va_backend_vpp.h>
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifndef VA_DISPLAY_MAGIC
+#define VA_DISPLAY_MAGIC 0x56414430 /* VAD0 */
+#endif
+
+namespace YamiMediaCodec {
+
+namespace {
+
+    const VAProfile nullProfiles[] = {
+        VAProfileNone,
+        VAProfileMPEG2Simple,
+        VAProfileMPEG2Main,
+        VAProfileMPEG4Simple,
+        VAProfileMPEG4AdvancedSimple,
+        VAProfileMPEG4Main,
+        VAProfileH264ConstrainedBaseline,
+        VAProfileH264Main,
+        VAProfileH264High,
+        VAProfileH264MultiviewHigh,
+        VAProfileH264StereoHigh,
+        VAProfileVC1Simple,
+        VAProfileVC1Main,
+        VAProfileVC1Advanced,
+        VAProfileH263Baseline,
+        VAProfileJPEGBaseline,
+        VAProfileVP8Version0_3,
+#if VA_CHECK_VERSION(0, 37, 0)
+        VAProfileHEVCMain,
+        VAProfileHEVCMain10,
+        VAProfileVP9Profile0,
+#endif
+#if VA_CHECK_VERSION(0, 38, 0)
+        VAProfileVP9Profile1,
+        VAProfileVP9Profile2,
+        VAProfileVP9Profile3,
+#endif
+    };
+
+    /* size of each plane in quarter pixels of the (aligned) surface size */
+    struct NullFormat {
+        uint32_t fourcc;
+        uint32_t bitsPerPixel;
+        uint32_t planes;
+        uint8_t width[3];
+        uint8_t height[3];
+    };
+
+    const NullFormat nullFormats[] = {
+        { YAMI_FOURCC_NV12, 12, 2, { 4, 4 }, { 4, 2 } },
+        { YAMI_FOURCC_I420, 12, 3, { 4, 2, 2 }, { 4, 2, 2 } },
+        { YAMI_FOURCC_YV12, 12, 3, { 4, 2, 2 }, { 4, 2, 2 } },
+        { YAMI_FOURCC_IMC3, 12, 3, { 4, 2, 2 }, { 4, 2, 2 } },
+        { YAMI_FOURCC_411P, 12, 3, { 4, 1, 1 }, { 4, 4, 4 } },
+        { YAMI_FOURCC_422H, 16, 3, { 4, 2, 2 }, { 4, 4, 4 } },
+        { YAMI_FOURCC_422V, 16, 3, { 4, 4, 4 }, { 4, 2, 2 } },
+        { YAMI_FOURCC_444P, 24, 3, { 4, 4, 4 }, { 4, 4, 4 } },
+        { YAMI_FOURCC_Y800, 8, 1, { 4 }, { 4 } },
+        { YAMI_FOURCC_P010, 24, 2, { 8, 8 }, { 4, 2 } },
+        { YAMI_FOURCC_YUY2, 16, 1, { 8 }, { 4 } },
+        { YAMI_FOURCC_UYVY, 16, 1, { 8 }, { 4 } },
+        { YAMI_FOURCC_RGB565, 16, 1, { 8 }, { 4 } },
+        { YAMI_FOURCC_RGBX, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_RGBA, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_BGRX, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_BGRA, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_XRGB, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_ARGB, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_XBGR, 32, 1, { 16 }, { 4 } },
+        { YAMI_FOURCC_ABGR, 32, 1, { 16 }, { 4 } },
+    };
+
+    const NullFormat* findFormat(uint32_t fourcc)
+    {
+        for (size_t i = 0; i < N_ELEMENTS(nullFormats); i++) {
+            if (nullFormats[i].fourcc == fourcc)
+                return &nullFormats[i];
+        }
+        return NULL;
+    }
+
+    uint32_t rtFormatToFourcc(uint32_t rtFormat)
+    {
+        switch (rtFormat) {
+        case VA_RT_FORMAT_YUV400:
+            return YAMI_FOURCC_Y800;
+        case VA_RT_FORMAT_YUV411:
+            return YAMI_FOURCC_411P;
+        case VA_RT_FORMAT_YUV422:
+            return YAMI_FOURCC_422H;
+        case VA_RT_FORMAT_YUV444:
+            return YAMI_FOURCC_444P;
+#if VA_CHECK_VERSION(0, 38, 1)
+        case VA_RT_FORMAT_YUV420_10BPP:
+            return YAMI_FOURCC_P010;
+#endif
+        case VA_RT_FORMAT_RGB16:
+            return YAMI_FOURCC_RGB565;
+        case VA_RT_FORMAT_RGB32:
+            return YAMI_FOURCC_BGRX;
+        default:
+            return YAMI_FOURCC_NV12;
+        }
+    }
+
+    bool fillImage(uint32_t fourcc, uint32_t width, uint32_t height, VAImage& image)
+    {
+        const NullFormat* format = findFormat(fourcc);
+        if (!format)
+            return false;
+        memset(&image, 0, sizeof(image));
+        image.format.fourcc = fourcc;
+        image.format.byte_order = VA_LSB_FIRST;
+        image.format.bits_per_pixel = format->bitsPerPixel;
+        image.width = width;
+        image.height = height;
+        image.num_planes = format->planes;
+        width = ALIGN16(width);
+        height = ALIGN16(height);
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < format->planes; i++) {
+            image.pitches[i] = width * format->width[i] / 4;
+            image.offsets[i] = offset;
+            offset += image.pitches[i] * (height * format->height[i] / 4);
+        }
+        image.data_size = offset;
+        image.image_id = VA_INVALID_ID;
+        image.buf = VA_INVALID_ID;
+        return true;
+    }
+
+    struct NullConfig {
+        VAProfile profile;
+        VAEntrypoint entrypoint;
+        std::vector<VAConfigAttrib> attribs;
+    };
+
+    struct NullContext {
+        VAConfigID config;
+        VASurfaceID target;
+    };
+
+    struct NullSurface {
+        uint32_t fourcc;
+        uint32_t width;
+        uint32_t height;
+        /* allocated when mapped the first time */
+        std::vector<uint8_t> data;
+    };
+
+    struct NullBuffer {
+        VABufferType type;
+        uint32_t size;
+        uint32_t numElements;
+        std::vector<uint8_t> storage;
+        /* storage, or the surface memory for a derived image */
+        uint8_t* data;
+    };
+
+    class NullDriver {
+    public:
+        NullDriver()
+            : m_nextId(1)
+        {
+        }
+
+        template <class T>
+        T* find(std::map<uint32_t, T>& objects, uint32_t id)
+        {
+            typename std::map<uint32_t, T>::iterator it = objects.find(id);
+            if (it == objects.end())
+                return NULL;
+            return &it->second;
+        }
+
+        uint32_t newId() { return m_nextId++; }
+
+        Lock m_lock;
+        std::map<uint32_t, NullConfig> m_configs;
+        std::map<uint32_t, NullContext> m_contexts;
+        std::map<uint32_t, NullSurface> m_surfaces;
+        std::map<uint32_t, NullBuffer> m_buffers;
+        std::map<uint32_t, VAImage> m_images;
+
+    private:
+        uint32_t m_nextId;
+        DISALLOW_COPY_AND_ASSIGN(NullDriver);
+    };
+
+    NullDriver* getDriver(VADriverContextP ctx)
+    {
+        return static_cast<NullDriver*>(ctx->pDriverData);
+    }
+
+    bool isSupportedProfile(VAProfile profile)
+    {
+        for (size_t i = 0; i < N_ELEMENTS(nullProfiles); i++) {
+            if (nullProfiles[i] == profile)
+                return true;
+        }
+        return false;
+    }
+
+    uint32_t getAttribValue(VAConfigAttribType type)
+    {
+        switch (type) {
+        case VAConfigAttribRTFormat:
+            return VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV422 | VA_RT_FORMAT_YUV444
+                | VA_RT_FORMAT_YUV411 | VA_RT_FORMAT_YUV400
+#if VA_CHECK_VERSION(0, 38, 1)
+                | VA_RT_FORMAT_YUV420_10BPP
+#endif
+                | VA_RT_FORMAT_RGB16 | VA_RT_FORMAT_RGB32;
+        case VAConfigAttribRateControl:
+            return VA_RC_CQP | VA_RC_CBR | VA_RC_VBR;
+        case VAConfigAttribEncPackedHeaders:
+            return VA_ENC_PACKED_HEADER_SEQUENCE | VA_ENC_PACKED_HEADER_PICTURE
+                | VA_ENC_PACKED_HEADER_SLICE | VA_ENC_PACKED_HEADER_MISC
+                | VA_ENC_PACKED_HEADER_RAW_DATA;
+        case VAConfigAttribEncMaxRefFrames:
+            return 16 | (16 << 16);
+        case VAConfigAttribEncMaxSlices:
+            return 256;
+        default:
+            return VA_ATTRIB_NOT_SUPPORTED;
+        }
+    }
+
+    VAStatus nullTerminate(VADriverContextP ctx)
+    {
+        delete getDriver(ctx);
+        ctx->pDriverData = NULL;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullQueryConfigProfiles(VADriverContextP ctx,
+        VAProfile* profiles, int* num)
+    {
+        memcpy(profiles, nullProfiles, sizeof(nullProfiles));
+        *num = N_ELEMENTS(nullProfiles);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullQueryConfigEntrypoints(VADriverContextP ctx, VAProfile profile,
+        VAEntrypoint* entrypoints, int* num)
+    {
+        if (!isSupportedProfile(profile))
+            return VA_STATUS_ERROR_UNSUPPORTED_PROFILE;
+        if (profile == VAProfileNone) {
+            entrypoints[0] = VAEntrypointVideoProc;
+            *num = 1;
+            return VA_STATUS_SUCCESS;
+        }
+        entrypoints[0] = VAEntrypointVLD;
+        entrypoints[1] = VAEntrypointEncSlice;
+        entrypoints[2] = VAEntrypointEncPicture;
+        *num = 3;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullGetConfigAttributes(VADriverContextP ctx, VAProfile profile,
+        VAEntrypoint entrypoint, VAConfigAttrib* attribs, int num)
+    {
+        if (!isSupportedProfile(profile))
+            return VA_STATUS_ERROR_UNSUPPORTED_PROFILE;
+        for (int i = 0; i < num; i++)
+            attribs[i].value = getAttribValue(attribs[i].type);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateConfig(VADriverContextP ctx, VAProfile profile,
+        VAEntrypoint entrypoint, VAConfigAttrib* attribs, int num,
+        VAConfigID* id)
+    {
+        if (!isSupportedProfile(profile))
+            return VA_STATUS_ERROR_UNSUPPORTED_PROFILE;
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        *id = driver->newId();
+        NullConfig& config = driver->m_configs[*id];
+        config.profile = profile;
+        config.entrypoint = entrypoint;
+        if (num > 0)
+            config.attribs.assign(attribs, attribs + num);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullDestroyConfig(VADriverContextP ctx, VAConfigID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->m_configs.erase(id))
+            return VA_STATUS_ERROR_INVALID_CONFIG;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullQueryConfigAttributes(VADriverContextP ctx, VAConfigID id,
+        VAProfile* profile, VAEntrypoint* entrypoint,
+        VAConfigAttrib* attribs, int* num)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullConfig* config = driver->find(driver->m_configs, id);
+        if (!config)
+            return VA_STATUS_ERROR_INVALID_CONFIG;
+        *profile = config->profile;
+        *entrypoint = config->entrypoint;
+        *num = config->attribs.size();
+        if (*num)
+            memcpy(attribs, &config->attribs[0], *num * sizeof(VAConfigAttrib));
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateSurfaces2(VADriverContextP ctx, unsigned int format,
+        unsigned int width, unsigned int height,
+        VASurfaceID* surfaces, unsigned int num,
+        VASurfaceAttrib* attribs, unsigned int numAttribs)
+    {
+        uint32_t fourcc = rtFormatToFourcc(format);
+        for (unsigned int i = 0; i < numAttribs; i++) {
+            if (!(attribs[i].flags & VA_SURFACE_ATTRIB_SETTABLE))
+                continue;
+            if (attribs[i].type == VASurfaceAttribPixelFormat)
+                fourcc = attribs[i].value.value.i;
+            else if (attribs[i].type == VASurfaceAttribMemoryType
+                && attribs[i].value.value.i != VA_SURFACE_ATTRIB_MEM_TYPE_VA)
+                return VA_STATUS_ERROR_UNSUPPORTED_MEMORY_TYPE;
+        }
+        if (!findFormat(fourcc))
+            return VA_STATUS_ERROR_INVALID_IMAGE_FORMAT;
+
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        for (unsigned int i = 0; i < num; i++) {
+            surfaces[i] = driver->newId();
+            NullSurface& surface = driver->m_surfaces[surfaces[i]];
+            surface.fourcc = fourcc;
+            surface.width = width;
+            surface.height = height;
+        }
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateSurfaces(VADriverContextP ctx, int width, int height,
+        int format, int num, VASurfaceID* surfaces)
+    {
+        return nullCreateSurfaces2(ctx, format, width, height, surfaces, num, NULL, 0);
+    }
+
+    VAStatus nullDestroySurfaces(VADriverContextP ctx, VASurfaceID* surfaces, int num)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        for (int i = 0; i < num; i++)
+            driver->m_surfaces.erase(surfaces[i]);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateContext(VADriverContextP ctx, VAConfigID config,
+        int width, int height, int flag,
+        VASurfaceID* targets, int numTargets, VAContextID* id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->find(driver->m_configs, config))
+            return VA_STATUS_ERROR_INVALID_CONFIG;
+        *id = driver->newId();
+        NullContext& context = driver->m_contexts[*id];
+        context.config = config;
+        context.target = VA_INVALID_SURFACE;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullDestroyContext(VADriverContextP ctx, VAContextID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->m_contexts.erase(id))
+            return VA_STATUS_ERROR_INVALID_CONTEXT;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateBuffer(VADriverContextP ctx, VAContextID context,
+        VABufferType type, unsigned int size, unsigned int numElements,
+        void* data, VABufferID* id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        *id = driver->newId();
+        NullBuffer& buffer = driver->m_buffers[*id];
+        buffer.type = type;
+        buffer.size = size;
+        buffer.numElements = numElements;
+        uint32_t bytes = size * numElements;
+        if (type == VAEncCodedBufferType) {
+            /* coded buffers are mapped as a segment list */
+            buffer.storage.resize(sizeof(VACodedBufferSegment) + bytes);
+        } else {
+            buffer.storage.resize(bytes);
+            if (data && bytes)
+                memcpy(&buffer.storage[0], data, bytes);
+        }
+        buffer.data = buffer.storage.empty() ? NULL : &buffer.storage[0];
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullBufferSetNumElements(VADriverContextP ctx, VABufferID id,
+        unsigned int numElements)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullBuffer* buffer = driver->find(driver->m_buffers, id);
+        if (!buffer)
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        if (numElements > buffer->numElements)
+            return VA_STATUS_ERROR_INVALID_PARAMETER;
+        buffer->numElements = numElements;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullMapBuffer(VADriverContextP ctx, VABufferID id, void** data)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullBuffer* buffer = driver->find(driver->m_buffers, id);
+        if (!buffer || !buffer->data)
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        if (buffer->type == VAEncCodedBufferType) {
+            VACodedBufferSegment* segment = (VACodedBufferSegment*)buffer->data;
+            memset(segment, 0, sizeof(*segment));
+            segment->buf = buffer->data + sizeof(*segment);
+        }
+        *data = buffer->data;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullUnmapBuffer(VADriverContextP ctx, VABufferID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->find(driver->m_buffers, id))
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullDestroyBuffer(VADriverContextP ctx, VABufferID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->m_buffers.erase(id))
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullBufferInfo(VADriverContextP ctx, VABufferID id,
+        VABufferType* type, unsigned int* size, unsigned int* numElements)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullBuffer* buffer = driver->find(driver->m_buffers, id);
+        if (!buffer)
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        *type = buffer->type;
+        *size = buffer->size;
+        *numElements = buffer->numElements;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullBeginPicture(VADriverContextP ctx, VAContextID id,
+        VASurfaceID target)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullContext* context = driver->find(driver->m_contexts, id);
+        if (!context)
+            return VA_STATUS_ERROR_INVALID_CONTEXT;
+        if (!driver->find(driver->m_surfaces, target))
+            return VA_STATUS_ERROR_INVALID_SURFACE;
+        context->target = target;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullRenderPicture(VADriverContextP ctx, VAContextID id,
+        VABufferID* buffers, int num)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullContext* context = driver->find(driver->m_contexts, id);
+        if (!context)
+            return VA_STATUS_ERROR_INVALID_CONTEXT;
+        if (context->target == VA_INVALID_SURFACE)
+            return VA_STATUS_ERROR_OPERATION_FAILED;
+        for (int i = 0; i < num; i++) {
+            if (!driver->find(driver->m_buffers, buffers[i]))
+                return VA_STATUS_ERROR_INVALID_BUFFER;
+        }
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullEndPicture(VADriverContextP ctx, VAContextID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullContext* context = driver->find(driver->m_contexts, id);
+        if (!context)
+            return VA_STATUS_ERROR_INVALID_CONTEXT;
+        if (context->target == VA_INVALID_SURFACE)
+            return VA_STATUS_ERROR_OPERATION_FAILED;
+        context->target = VA_INVALID_SURFACE;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullSyncSurface(VADriverContextP ctx, VASurfaceID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->find(driver->m_surfaces, id))
+            return VA_STATUS_ERROR_INVALID_SURFACE;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullQuerySurfaceStatus(VADriverContextP ctx, VASurfaceID id,
+        VASurfaceStatus* status)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        if (!driver->find(driver->m_surfaces, id))
+            return VA_STATUS_ERROR_INVALID_SURFACE;
+        *status = VASurfaceReady;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullQuerySurfaceError(VADriverContextP ctx, VASurfaceID id,
+        VAStatus error, void** info)
+    {
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+    }
+
+    VAStatus nullPutSurface(VADriverContextP ctx, VASurfaceID id, void* draw,
+        short srcX, short srcY, unsigned short srcWidth, unsigned short srcHeight,
+        short dstX, short dstY, unsigned short dstWidth, unsigned short dstHeight,
+        VARectangle* clipRects, unsigned int numClipRects, unsigned int flags)
+    {
+        return nullSyncSurface(ctx, id);
+    }
+
+    VAStatus nullQueryImageFormats(VADriverContextP ctx, VAImageFormat* formats,
+        int* num)
+    {
+        for (size_t i = 0; i < N_ELEMENTS(nullFormats); i++) {
+            memset(&formats[i], 0, sizeof(formats[i]));
+            formats[i].fourcc = nullFormats[i].fourcc;
+            formats[i].byte_order = VA_LSB_FIRST;
+            formats[i].bits_per_pixel = nullFormats[i].bitsPerPixel;
+        }
+        *num = N_ELEMENTS(nullFormats);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullCreateImage(VADriverContextP ctx, VAImageFormat* format,
+        int width, int height, VAImage* image)
+    {
+        if (!fillImage(format->fourcc, width, height, *image))
+            return VA_STATUS_ERROR_INVALID_IMAGE_FORMAT;
+        VAStatus status = nullCreateBuffer(ctx, VA_INVALID_ID, VAImageBufferType,
+            image->data_size, 1, NULL, &image->buf);
+        if (status != VA_STATUS_SUCCESS)
+            return status;
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        image->image_id = driver->newId();
+        driver->m_images[image->image_id] = *image;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullDeriveImage(VADriverContextP ctx, VASurfaceID id, VAImage* image)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullSurface* surface = driver->find(driver->m_surfaces, id);
+        if (!surface)
+            return VA_STATUS_ERROR_INVALID_SURFACE;
+        if (!fillImage(surface->fourcc, surface->width, surface->height, *image))
+            return VA_STATUS_ERROR_INVALID_IMAGE_FORMAT;
+        if (surface->data.empty())
+            surface->data.resize(image->data_size);
+
+        image->buf = driver->newId();
+        NullBuffer& buffer = driver->m_buffers[image->buf];
+        buffer.type = VAImageBufferType;
+        buffer.size = image->data_size;
+        buffer.numElements = 1;
+        buffer.data = &surface->data[0];
+
+        image->image_id = driver->newId();
+        driver->m_images[image->image_id] = *image;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullDestroyImage(VADriverContextP ctx, VAImageID id)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        VAImage* image = driver->find(driver->m_images, id);
+        if (!image)
+            return VA_STATUS_ERROR_INVALID_IMAGE;
+        driver->m_buffers.erase(image->buf);
+        driver->m_images.erase(id);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullSetImagePalette(VADriverContextP ctx, VAImageID id,
+        unsigned char* palette)
+    {
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+    }
+
+    /* surfaces and images are only copied when they have the same layout,
+     * there is no scaling or color conversion */
+    VAStatus copyImage(VADriverContextP ctx, VASurfaceID surfaceId,
+        VAImageID imageId, bool toSurface)
+    {
+        NullDriver* driver = getDriver(ctx);
+        AutoLock lock(driver->m_lock);
+        NullSurface* surface = driver->find(driver->m_surfaces, surfaceId);
+        if (!surface)
+            return VA_STATUS_ERROR_INVALID_SURFACE;
+        VAImage* image = driver->find(driver->m_images, imageId);
+        if (!image)
+            return VA_STATUS_ERROR_INVALID_IMAGE;
+        NullBuffer* buffer = driver->find(driver->m_buffers, image->buf);
+        if (!buffer)
+            return VA_STATUS_ERROR_INVALID_BUFFER;
+        if (image->format.fourcc != surface->fourcc
+            || image->width != surface->width || image->height != surface->height)
+            return VA_STATUS_SUCCESS;
+        if (surface->data.empty())
+            surface->data.resize(image->data_size);
+        if (buffer->data == &surface->data[0])
+            return VA_STATUS_SUCCESS;
+        if (toSurface)
+            memcpy(&surface->data[0], buffer->data, image->data_size);
+        else
+            memcpy(buffer->data, &surface->data[0], image->data_size);
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullGetImage(VADriverContextP ctx, VASurfaceID surface,
+        int x, int y, unsigned int width, unsigned int height, VAImageID image)
+    {
+        return copyImage(ctx, surface, image, false);
+    }
+
+    VAStatus nullPutImage(VADriverContextP ctx, VASurfaceID surface,
+        VAImageID image, int srcX, int srcY,
+        unsigned int srcWidth, unsigned int srcHeight, int dstX, int dstY,
+        unsigned int dstWidth, unsigned int dstHeight)
+    {
+        return copyImage(ctx, surface, image, true);
+    }
+
+    VAStatus nullQueryDisplayAttributes(VADriverContextP ctx,
+        VADisplayAttribute* attribs, int* num)
+    {
+        *num = 0;
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus nullGetDisplayAttributes(VADriverContextP ctx,
+        VADisplayAttribute* attribs, int num)
+    {
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+    }
+
+    VAStatus nullSetDisplayAttributes(VADriverContextP ctx,
+        VADisplayAttribute* attribs, int num)
+    {
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+    }
+
+    int nullIsValid(VADisplayContextP display)
+    {
+        return display->pDriverContext && display->pDriverContext->pDriverData;
+    }
+
+    void nullDestroy(VADisplayContextP display)
+    {
+        destroyNullDisplay(display);
+    }
+
+} //namespace
+
+VADisplay createNullDisplay()
+{
+    VADisplayContextP display = new VADisplayContext();
+    VADriverContextP ctx = new VADriverContext();
+    /* entries libyami never calls stay NULL; libva reports the optional
+     * ones as unimplemented. the vtables are malloc'ed like libva's own,
+     * since vaTerminate frees them */
+    struct VADriverVTable* vtable = (struct VADriverVTable*)calloc(1, sizeof(*vtable));
+    struct VADriverVTableVPP* vtableVpp = (struct VADriverVTableVPP*)calloc(1, sizeof(*vtableVpp));
+
+    vtable->vaTerminate = nullTerminate;
+    vtable->vaQueryConfigProfiles = nullQueryConfigProfiles;
+    vtable->vaQueryConfigEntrypoints = nullQueryConfigEntrypoints;
+    vtable->vaGetConfigAttributes = nullGetConfigAttributes;
+    vtable->vaCreateConfig = nullCreateConfig;
+    vtable->vaDestroyConfig = nullDestroyConfig;
+    vtable->vaQueryConfigAttributes = nullQueryConfigAttributes;
+    vtable->vaCreateSurfaces = nullCreateSurfaces;
+    vtable->vaCreateSurfaces2 = nullCreateSurfaces2;
+    vtable->vaDestroySurfaces = nullDestroySurfaces;
+    vtable->vaCreateContext = nullCreateContext;
+    vtable->vaDestroyContext = nullDestroyContext;
+    vtable->vaCreateBuffer = nullCreateBuffer;
+    vtable->vaBufferSetNumElements = nullBufferSetNumElements;
+    vtable->vaMapBuffer = nullMapBuffer;
+    vtable->vaUnmapBuffer = nullUnmapBuffer;
+    vtable->vaDestroyBuffer = nullDestroyBuffer;
+    vtable->vaBufferInfo = nullBufferInfo;
+    vtable->vaBeginPicture = nullBeginPicture;
+    vtable->vaRenderPicture = nullRenderPicture;
+    vtable->vaEndPicture = nullEndPicture;
+    vtable->vaSyncSurface = nullSyncSurface;
+    vtable->vaQuerySurfaceStatus = nullQuerySurfaceStatus;
+    vtable->vaQuerySurfaceError = nullQuerySurfaceError;
+    vtable->vaPutSurface = nullPutSurface;
+    vtable->vaQueryImageFormats = nullQueryImageFormats;
+    vtable->vaCreateImage = nullCreateImage;
+    vtable->vaDeriveImage = nullDeriveImage;
+    vtable->vaDestroyImage = nullDestroyImage;
+    vtable->vaSetImagePalette = nullSetImagePalette;
+    vtable->vaGetImage = nullGetImage;
+    vtable->vaPutImage = nullPutImage;
+    vtable->vaQueryDisplayAttributes = nullQueryDisplayAttributes;
+    vtable->vaGetDisplayAttributes = nullGetDisplayAttributes;
+    vtable->vaSetDisplayAttributes = nullSetDisplayAttributes;
+    vtableVpp->version = VA_DRIVER_VTABLE_VPP_VERSION;
+
+    ctx->pDriverData = new NullDriver;
+    ctx->vtable = vtable;
+    ctx->vtable_vpp = vtableVpp;
+    ctx->version_major = VA_MAJOR_VERSION;
+    ctx->version_minor = VA_MINOR_VERSION;
+    ctx->max_profiles = N_ELEMENTS(nullProfiles);
+    ctx->max_entrypoints = 3;
+    ctx->max_attributes = VAConfigAttribTypeMax;
+    ctx->max_image_formats = N_ELEMENTS(nullFormats);
+    ctx->max_subpic_formats = 0;
+    ctx->max_display_attributes = 0;
+    ctx->str_vendor = "libyami null driver";
+
+    display->vadpy_magic = VA_DISPLAY_MAGIC;
+    display->pDriverContext = ctx;
+    display->vaIsValid = nullIsValid;
+    display->vaDestroy = nullDestroy;
+    return display;
+}
+
+void destroyNullDisplay(VADisplay dpy)
+{
+    VADisplayContextP display = static_cast<VADisplayContextP>(dpy);
+    if (!display)
+        return;
+    VADriverContextP ctx = display->pDriverContext;
+    //not through the vtable, vaTerminate may have freed it already
+    if (ctx->pDriverData)
+        nullTerminate(ctx);
+    free(ctx->vtable);
+    free(ctx->vtable_vpp);
+    delete ctx;
+    delete display;
+}
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef vaapinulldriver_h
+#define vaapinulldriver_h
+
+#include <va/va.h>
+
+namespace YamiMediaCodec {
+
+/* A VADisplay backed by an in-memory driver. Configs, contexts, surfaces,
+ * buffers and images are plain host allocations and vaRenderPicture/
+ * vaEndPicture do nothing, so the whole decode/encode pipeline can run
+ * without a gpu. Decoded surfaces keep whatever was in memory and coded
+ * buffers come back empty; it is meant for profiling host side overhead.
+ *
+ * The display and driver contexts are filled in here rather than by
+ * vaInitialize, so no driver module or drm device is needed. libva only
+ * sees a valid VADisplay whose calls go through the driver vtable; this
+ * relies on the va_backend.h structures and has only been exercised
+ * against stub libva headers, not a real libva. Don't call vaInitialize
+ * on it, and release it with destroyNullDisplay rather than vaTerminate. */
+VADisplay createNullDisplay();
+void destroyNullDisplay(VADisplay display);
+}
+
+#endif //vaapinulldriver_h
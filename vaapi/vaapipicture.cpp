@@ -90,6 +90,29 @@ bool VaapiPicture::render(std::pair <BufObjectPtr,BufObjectPtr> &paramAndData)
     return render(paramAndData.first) && render(paramAndData.second);
 }
 
+bool VaapiPicture::renderBatch(std::vector<BufObjectPtr>& buffers)
+{
+    std::vector<VABufferID> ids;
+    ids.reserve(buffers.size());
+    for (size_t i = 0; i < buffers.size(); i++) {
+        BufObjectPtr& buffer = buffers[i];
+        if (!buffer)
+            continue;
+        buffer->unmap();
+        if (buffer->getID() == VA_INVALID_ID)
+            return false;
+        ids.push_back(buffer->getID());
+    }
+
+    bool ret = true;
+    if (!ids.empty()) {
+        VAStatus status = vaRenderPicture(m_display->getID(), m_context->getID(), &ids[0], ids.size());
+        ret = checkVaapiStatus(status, "vaRenderPicture failed");
+    }
+    buffers.clear(); // silently work around for psb
+    return ret;
+}
+
 bool VaapiPicture::addObject(std::vector<std::pair<BufObjectPtr,BufObjectPtr> >& objects,
                              const BufObjectPtr & param,
                              const BufObjectPtr & data)
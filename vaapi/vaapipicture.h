@@ -70,6 +70,9 @@ protected:
     template <class O>
     bool render(std::vector<O>& objects);
 
+    //submit all the buffers in one vaRenderPicture call, null ones are skipped
+    bool renderBatch(std::vector<BufObjectPtr>& buffers);
+
     template<class T>
     bool editObject(BufObjectPtr& object , VABufferType, T*& bufPtr);
     bool addObject(std::vector<std::pair<BufObjectPtr, BufObjectPtr> >& objects,